@@ -60,10 +60,7 @@ void loop()
         doc["uptime"] = millis() / 1000;
         doc["heap"] = ESP.getFreeHeap();
 
-        String message;
-        serializeJson(doc, message);
-
-        // 发送到所有连接的WebSocket客户端
-        otaLib.broadcastMessage(message);
+        // 发送到所有连接的WebSocket客户端（按各客户端协商的编码）
+        otaLib.broadcastMessage(doc);
     }
 }
\ No newline at end of file
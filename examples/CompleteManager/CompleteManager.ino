@@ -112,11 +112,8 @@ void loop()
         sensors["humidity"] = random(40, 80);    // 模拟湿度数据
         sensors["light"] = random(0, 1000);      // 模拟光照数据
 
-        String message;
-        serializeJson(doc, message);
-
         // 广播状态
-        otaLib.broadcastMessage(message);
+        otaLib.broadcastMessage(doc);
     }
 }
 
@@ -167,10 +164,7 @@ void sendButtonEvent()
     doc["count"] = buttonPressCount;
     doc["timestamp"] = millis() / 1000;
 
-    String message;
-    serializeJson(doc, message);
-
-    otaLib.broadcastMessage(message);
+    otaLib.broadcastMessage(doc);
 
     // 触发API活动指示
     StatusIndicator *statusIndicator = otaLib.getStatusIndicator();
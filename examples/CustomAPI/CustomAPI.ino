@@ -74,18 +74,16 @@ void loop()
  */
 void setupCustomRoutes()
 {
-    // 获取WebServer管理器引用
-    WebServerManager *webServer = otaLib.getWebServerManager();
+    // 获取API路由器引用，注册的路由会自动记录调用次数和延迟分布
+    ApiRouter *apiRouter = otaLib.getApiRouter();
 
     // 添加传感器数据API
-    /*
-    webServer->on("/api/sensors", HTTP_GET, [](AsyncWebServerRequest *request) {
-      String response = getSensorDataJson();
-      request->send(200, "application/json", response);
-    });
+    apiRouter->on("/api/sensors", HTTP_GET, [](AsyncWebServerRequest *request)
+                  { request->send(200, "application/json", getSensorDataJson()); });
 
     // 添加继电器控制API
-    webServer->on("/api/relay", HTTP_POST, [](AsyncWebServerRequest *request) {
+    apiRouter->on("/api/relay", HTTP_POST, [](AsyncWebServerRequest *request)
+                  {
       // 参数检查
       if (!request->hasParam("state", true)) {
         request->send(400, "application/json", "{\"error\":\"Missing state parameter\"}");
@@ -108,14 +106,11 @@ void setupCustomRoutes()
       StaticJsonDocument<100> doc;
       doc["type"] = "relay_update";
       doc["state"] = relayState ? "on" : "off";
-
-      String message;
-      serializeJson(doc, message);
-      otaLib.broadcastMessage(message);
-    });
+      otaLib.broadcastMessage(doc); });
 
     // 添加设备重命名API
-    webServer->on("/api/rename", HTTP_POST, [](AsyncWebServerRequest *request) {
+    apiRouter->on("/api/rename", HTTP_POST, [](AsyncWebServerRequest *request)
+                  {
       if (!request->hasParam("name", true)) {
         request->send(400, "application/json", "{\"error\":\"Missing name parameter\"}");
         return;
@@ -124,9 +119,9 @@ void setupCustomRoutes()
       String newName = request->getParam("name", true)->value();
       // 这里可以将设备名存储到EEPROM等
 
-      request->send(200, "application/json", "{\"success\":true,\"name\":\"" + newName + "\"}");
-    });
-    */
+      request->send(200, "application/json", "{\"success\":true,\"name\":\"" + newName + "\"}"); });
+
+    // 各路由的统计数据可以通过 /api/stats/routes 查询
 }
 
 /**
@@ -0,0 +1,125 @@
+/**
+ * ESP32_OTA_WS_Lib - 消息编码对比示例
+ *
+ * 这个示例比较同一个文档以JSON和MessagePack序列化时的大小和CPU周期数，
+ * 用于判断在当前设备上是否值得让客户端切换到MessagePack
+ * 结果输出到串口，不需要连接WiFi
+ * 不需要设备时，可以用 tools/encoding_sizes.py 在主机上计算相同消息的大小
+ *
+ * @author MrQ
+ * @date 2026.10.18
+ */
+
+#include <ESP32_OTA_WS_Lib.h>
+
+// 每项测试的重复次数
+const int ITERATIONS = 1000;
+
+/**
+ * 读取CPU周期计数
+ */
+uint32_t cycles()
+{
+    return ESP.getCycleCount();
+}
+
+/**
+ * 比较一个文档的两种编码
+ */
+void benchmark(const char *title, const JsonDocument &doc)
+{
+    uint8_t buffer[768];
+
+    Serial.printf("\n%s\n", title);
+    Serial.println("编码      大小   measure周期   serialize周期");
+
+    for (int i = 0; i < 2; i++)
+    {
+        MessageEncoding encoding = i == 0 ? MESSAGE_JSON : MESSAGE_MSGPACK;
+
+        uint32_t start = cycles();
+        size_t size = 0;
+        for (int n = 0; n < ITERATIONS; n++)
+        {
+            size = MessageCodec::measure(doc, encoding);
+        }
+        uint32_t measureCycles = (cycles() - start) / ITERATIONS;
+
+        start = cycles();
+        for (int n = 0; n < ITERATIONS; n++)
+        {
+            MessageCodec::serialize(doc, encoding, buffer, sizeof(buffer));
+        }
+        uint32_t serializeCycles = (cycles() - start) / ITERATIONS;
+
+        Serial.printf("%-8s %5u %13u %15u\n", MessageCodec::name(encoding), (unsigned)size, measureCycles, serializeCycles);
+    }
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+
+    // 与OTAManager发送的进度消息相同
+    StaticJsonDocument<200> progressDoc;
+    progressDoc["type"] = "progress";
+    progressDoc["progress"] = 42.5f;
+    progressDoc["current"] = 557056;
+    progressDoc["total"] = 1310720;
+    progressDoc["speed"] = 48213.7f;
+    progressDoc["speedText"] = "47.1 KB/s";
+    benchmark("OTA进度消息", progressDoc);
+
+    // 与WiFiScanner返回的扫描结果相同，8个网络
+    static const struct
+    {
+        const char *ssid;
+        int rssi;
+        int channel;
+        bool secure;
+    } networks[] = {
+        {"HomeNetwork", -48, 6, true},
+        {"TP-LINK_5A3C", -61, 1, true},
+        {"ChinaNet-8FQe", -67, 11, true},
+        {"Office-Guest", -70, 6, false},
+        {"DIRECT-7B-HP M428 LaserJet", -74, 6, true},
+        {"ESP_3A1F2C", -79, 1, false},
+        {"MERCURY_2.4G_E1", -83, 13, true},
+        {"Xiaomi_1C5D", -88, 4, true},
+    };
+    DynamicJsonDocument scanDoc(1024);
+    scanDoc["type"] = "wifi_scan";
+    JsonArray list = scanDoc.createNestedArray("networks");
+    for (const auto &network : networks)
+    {
+        JsonObject item = list.createNestedObject();
+        item["ssid"] = network.ssid;
+        item["rssi"] = network.rssi;
+        item["channel"] = network.channel;
+        item["secure"] = network.secure;
+    }
+    scanDoc["age"] = 1834;
+    benchmark("WiFi扫描结果", scanDoc);
+
+    // 典型的状态消息
+    StaticJsonDocument<512> statusDoc;
+    statusDoc["type"] = "status";
+    statusDoc["uptime"] = 86400;
+    statusDoc["heap"] = 183204;
+    statusDoc["minHeap"] = 151872;
+    statusDoc["rssi"] = -61;
+    statusDoc["ip"] = "192.168.1.42";
+    JsonArray cpu = statusDoc.createNestedArray("cpu");
+    cpu.add(12.5);
+    cpu.add(3.25);
+    JsonObject sensors = statusDoc.createNestedObject("sensors");
+    sensors["temperature"] = 23.4;
+    sensors["humidity"] = 56;
+    sensors["light"] = 734;
+    benchmark("状态消息", statusDoc);
+}
+
+void loop()
+{
+}
@@ -0,0 +1,107 @@
+/**
+ * ESP32_OTA_WS_Lib - LED动画耗时示例
+ *
+ * 这个示例在轮询方式下测量每种LED模式的StatusIndicator::handle()耗时（CPU周期）:
+ *   帧:   距上一帧超过LED_FRAME_INTERVAL时，计算颜色并写入LED
+ *   跳过: 帧间隔内的调用，只比较时间后返回，这是主循环大多数时候付出的开销
+ * 帧的耗时包含NeoPixel输出，颜色未变化时跳过输出，因此同时给出平均值和最大值
+ * 结果输出到串口，不需要连接WiFi
+ *
+ * @author MrQ
+ * @date 2026.10.18
+ */
+
+#include <ESP32_OTA_WS_Lib.h>
+
+// LED引脚，与板子上的NeoPixel一致
+const uint8_t LED_PIN = 8;
+
+// 每种模式测量的帧数和帧间隔内的调用次数
+const int FRAMES = 25;
+const int SKIPPED_CALLS = 1000;
+
+StatusIndicator indicator(LED_PIN);
+
+/**
+ * 读取CPU周期计数
+ */
+uint32_t cycles()
+{
+    return ESP.getCycleCount();
+}
+
+/**
+ * 测量一种模式
+ */
+void benchmark(LedMode mode, const char *name)
+{
+    if (mode == LED_API_ACTIVE)
+    {
+        // API活动的持续时间从triggerApiActivity()开始计算
+        indicator.triggerApiActivity();
+    }
+    else
+    {
+        indicator.setMode(mode);
+    }
+    // 第一帧输出新模式的颜色，不计入
+    indicator.handle();
+
+    uint32_t frameTotal = 0;
+    uint32_t frameMax = 0;
+    uint32_t skippedTotal = 0;
+
+    for (int i = 0; i < FRAMES; i++)
+    {
+        // 等待一个帧间隔，下一次调用会计算新的一帧
+        delay(LED_FRAME_INTERVAL);
+
+        uint32_t start = cycles();
+        indicator.handle();
+        uint32_t elapsed = cycles() - start;
+        frameTotal += elapsed;
+        if (elapsed > frameMax)
+        {
+            frameMax = elapsed;
+        }
+
+        // 刚输出一帧，接下来的调用都在帧间隔内
+        start = cycles();
+        for (int n = 0; n < SKIPPED_CALLS / FRAMES; n++)
+        {
+            indicator.handle();
+        }
+        skippedTotal += cycles() - start;
+    }
+
+    Serial.printf("%-20s %9u %9u %9u\n", name, (unsigned)(frameTotal / FRAMES), (unsigned)frameMax,
+                  (unsigned)(skippedTotal / (SKIPPED_CALLS / FRAMES * FRAMES)));
+}
+
+void setup()
+{
+    Serial.begin(115200);
+    delay(1000);
+
+    indicator.begin();
+    // StatusIndicator::begin()不启用定时渲染（ESP32_OTA_WS_Lib::begin()才会启用），
+    // 这里明确关闭：定时渲染时handle()直接返回，测量需要轮询方式
+    indicator.enableTimedRendering(false);
+
+    Serial.printf("\nCPU %u MHz，每种模式 %d 帧\n", (unsigned)ESP.getCpuFreqMHz(), FRAMES);
+    Serial.println("模式                   帧平均     帧最大      跳过");
+
+    // 成功闪烁和API活动是临时模式，结束后切换到其他模式，测量窗口小于它们的持续时间
+    benchmark(LED_BOOT_ANIMATION, "BOOT_ANIMATION");
+    benchmark(LED_AP_MODE, "AP_MODE");
+    benchmark(LED_CONNECTED, "CONNECTED");
+    benchmark(LED_API_ACTIVE, "API_ACTIVE");
+    benchmark(LED_OTA_IN_PROGRESS, "OTA_IN_PROGRESS");
+    benchmark(FIRMWARE_SUCCESS, "FIRMWARE_SUCCESS");
+    benchmark(FILESYSTEM_SUCCESS, "FILESYSTEM_SUCCESS");
+    benchmark(LED_ERROR, "ERROR");
+}
+
+void loop()
+{
+}
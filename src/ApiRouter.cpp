@@ -0,0 +1,372 @@
+/**
+ * ApiRouter.cpp
+ *
+ * API路由模块的实现
+ *
+ * @file ApiRouter.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "ApiRouter.h"
+#include "WebSocketManager.h"
+
+namespace
+{
+    /**
+     * 获取方法名称
+     */
+    const char *methodName(WebRequestMethodComposite method)
+    {
+        switch (method)
+        {
+        case HTTP_GET:
+            return "GET";
+        case HTTP_POST:
+            return "POST";
+        case HTTP_PUT:
+            return "PUT";
+        case HTTP_DELETE:
+            return "DELETE";
+        case HTTP_PATCH:
+            return "PATCH";
+        default:
+            return "ANY";
+        }
+    }
+
+    /**
+     * 计算处理时间所属的直方图桶
+     */
+    inline uint8_t bucketFor(uint32_t micros)
+    {
+        uint8_t bucket = micros ? 32 - __builtin_clz(micros) : 0;
+        return bucket < API_LATENCY_BUCKETS ? bucket : API_LATENCY_BUCKETS - 1;
+    }
+}
+
+/**
+ * 构造函数
+ */
+ApiRouter::ApiRouter() : _routeCount(0),
+                         _seed(1)
+{
+    memset(_slots, 0, sizeof(_slots));
+
+    // 路由统计本身也作为一个路由，便于观察查询开销；逐个路由流式输出
+    on("/api/stats/routes", HTTP_GET, [this](AsyncWebServerRequest *request)
+       { request->send(JsonResponseWriter::beginArray(
+             request, "{\"type\":\"api_stats\",\"routes\":[", "]}",
+             [this](size_t index, JsonDocument &routeDoc)
+             {
+                 if (index >= _routeCount)
+                 {
+                     return false;
+                 }
+                 fillRouteStats(index, routeDoc);
+                 return true;
+             })); });
+}
+
+/**
+ * 注册路由
+ */
+bool ApiRouter::on(const char *path, WebRequestMethodComposite method, ArRequestHandlerFunction handler)
+{
+    if (_routeCount >= API_ROUTER_MAX_ROUTES)
+    {
+        Serial.printf("路由数量已达上限，无法注册: %s\n", path);
+        return false;
+    }
+
+    ApiRoute &route = _routes[_routeCount++];
+    route.path = path;
+    route.method = method;
+    route.handler = handler;
+    route.nextSamePath = -1;
+
+    compile();
+    return true;
+}
+
+/**
+ * 将所有路由的统计数据以JSON格式写入输出流
+ */
+size_t ApiRouter::writeStatsJson(Print &out) const
+{
+    size_t written = out.print("{\"type\":\"api_stats\",\"routes\":[");
+
+    for (uint8_t i = 0; i < _routeCount; i++)
+    {
+        StaticJsonDocument<256> routeDoc;
+        fillRouteStats(i, routeDoc);
+
+        if (i > 0)
+        {
+            written += out.write(',');
+        }
+        written += serializeJson(routeDoc, out);
+    }
+
+    written += out.print("]}");
+    return written;
+}
+
+/**
+ * 通过WebSocket向客户端发送统计数据
+ */
+void ApiRouter::sendStats(WebSocketManager *wsManager, uint8_t num)
+{
+    if (!wsManager)
+    {
+        return;
+    }
+
+    _wsPayload = "";
+    writeStatsJson(_wsPayload);
+    wsManager->sendTXT(num, _wsPayload);
+}
+
+/**
+ * 清零所有统计数据
+ */
+void ApiRouter::resetStats()
+{
+    for (uint8_t i = 0; i < _routeCount; i++)
+    {
+        RouteStats &stats = _routes[i].stats;
+        stats.count.set(0);
+        stats.bytesIn.set(0);
+        stats.maxMicros.set(0);
+        for (uint8_t b = 0; b < API_LATENCY_BUCKETS; b++)
+        {
+            stats.buckets[b].set(0);
+        }
+    }
+}
+
+/**
+ * 获取路由数量
+ */
+size_t ApiRouter::getRouteCount() const
+{
+    return _routeCount;
+}
+
+/**
+ * 判断请求是否由本处理器处理
+ */
+bool ApiRouter::canHandle(AsyncWebServerRequest *request)
+{
+    if (!match(request))
+    {
+        return false;
+    }
+
+    // 未标记的请求头会被丢弃，MessageCodec按Accept协商编码
+    request->addInterestingHeader("Accept");
+    return true;
+}
+
+/**
+ * 分发请求并记录统计数据
+ */
+void ApiRouter::handleRequest(AsyncWebServerRequest *request)
+{
+    ApiRoute *route = match(request);
+    if (!route)
+    {
+        request->send(404);
+        return;
+    }
+
+    unsigned long start = micros();
+    route->handler(request);
+    uint32_t elapsed = micros() - start;
+
+    RouteStats &stats = route->stats;
+    stats.count.add();
+    stats.bytesIn.add(request->contentLength());
+    stats.maxMicros.updateMax(elapsed);
+    stats.buckets[bucketFor(elapsed)].add();
+}
+
+/**
+ * 需要解析请求体中的参数
+ */
+bool ApiRouter::isRequestHandlerTrivial()
+{
+    return false;
+}
+
+/**
+ * 编译分发表
+ */
+bool ApiRouter::compile()
+{
+    const uint32_t mask = API_ROUTER_TABLE_SIZE - 1;
+
+    // 相同路径的路由串成链表，只有链表头进入哈希表
+    bool isHead[API_ROUTER_MAX_ROUTES];
+    for (uint8_t i = 0; i < _routeCount; i++)
+    {
+        isHead[i] = true;
+        _routes[i].nextSamePath = -1;
+        for (uint8_t j = 0; j < i; j++)
+        {
+            if (isHead[j] && _routes[j].path == _routes[i].path)
+            {
+                uint8_t tail = j;
+                while (_routes[tail].nextSamePath >= 0)
+                {
+                    tail = _routes[tail].nextSamePath;
+                }
+                _routes[tail].nextSamePath = i;
+                isHead[i] = false;
+                break;
+            }
+        }
+    }
+
+    // 搜索使所有路径落入不同槽位的种子
+    for (uint32_t seed = 1; seed <= API_ROUTER_MAX_SEED_TRIES; seed++)
+    {
+        memset(_slots, 0, sizeof(_slots));
+        bool collision = false;
+
+        for (uint8_t i = 0; i < _routeCount && !collision; i++)
+        {
+            if (!isHead[i])
+            {
+                continue;
+            }
+            uint32_t slot = hashPath(_routes[i].path.c_str(), _routes[i].path.length(), seed) & mask;
+            if (_slots[slot])
+            {
+                collision = true;
+            }
+            else
+            {
+                _slots[slot] = i + 1;
+            }
+        }
+
+        if (!collision)
+        {
+            _seed = seed;
+            return true;
+        }
+    }
+
+    // 没有找到完美哈希时退化为线性探测，查找逻辑相同
+    _seed = 1;
+    memset(_slots, 0, sizeof(_slots));
+    for (uint8_t i = 0; i < _routeCount; i++)
+    {
+        if (!isHead[i])
+        {
+            continue;
+        }
+        uint32_t slot = hashPath(_routes[i].path.c_str(), _routes[i].path.length(), _seed) & mask;
+        while (_slots[slot])
+        {
+            slot = (slot + 1) & mask;
+        }
+        _slots[slot] = i + 1;
+    }
+    Serial.println("路由表未找到无冲突哈希，使用线性探测");
+    return false;
+}
+
+/**
+ * 查找请求对应的路由
+ */
+ApiRoute *ApiRouter::match(AsyncWebServerRequest *request)
+{
+    const uint32_t mask = API_ROUTER_TABLE_SIZE - 1;
+    const String &url = request->url();
+
+    uint32_t slot = hashPath(url.c_str(), url.length(), _seed) & mask;
+    for (uint8_t probes = 0; probes < API_ROUTER_TABLE_SIZE && _slots[slot]; probes++)
+    {
+        ApiRoute *route = &_routes[_slots[slot] - 1];
+        if (route->path == url)
+        {
+            // 按方法在相同路径的链表中查找
+            while (route)
+            {
+                if (route->method & request->method())
+                {
+                    return route;
+                }
+                route = route->nextSamePath >= 0 ? &_routes[route->nextSamePath] : nullptr;
+            }
+            return nullptr;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return nullptr;
+}
+
+/**
+ * 计算路径的哈希值（带种子的FNV-1a）
+ */
+uint32_t ApiRouter::hashPath(const char *path, size_t len, uint32_t seed)
+{
+    uint32_t hash = 2166136261UL ^ (seed * 0x9E3779B1UL);
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= (uint8_t)path[i];
+        hash *= 16777619UL;
+    }
+    return hash ^ (hash >> 15);
+}
+
+/**
+ * 填充单个路由的统计数据
+ */
+void ApiRouter::fillRouteStats(size_t index, JsonDocument &routeDoc) const
+{
+    const ApiRoute &route = _routes[index];
+    routeDoc["path"] = route.path.c_str();
+    routeDoc["method"] = methodName(route.method);
+    routeDoc["count"] = route.stats.count.get();
+    routeDoc["bytesIn"] = route.stats.bytesIn.get();
+    routeDoc["p50"] = percentile(route.stats, 0.50f);
+    routeDoc["p99"] = percentile(route.stats, 0.99f);
+    routeDoc["max"] = route.stats.maxMicros.get();
+}
+
+/**
+ * 估算直方图的分位数
+ */
+uint32_t ApiRouter::percentile(const RouteStats &stats, float quantile)
+{
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < API_LATENCY_BUCKETS; i++)
+    {
+        total += stats.buckets[i].get();
+    }
+    if (!total)
+    {
+        return 0;
+    }
+
+    uint32_t target = (uint32_t)(quantile * total + 0.5f);
+    if (target == 0)
+    {
+        target = 1;
+    }
+
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < API_LATENCY_BUCKETS; i++)
+    {
+        cumulative += stats.buckets[i].get();
+        if (cumulative >= target)
+        {
+            return 1UL << i;
+        }
+    }
+    return 1UL << (API_LATENCY_BUCKETS - 1);
+}
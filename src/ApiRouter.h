@@ -0,0 +1,156 @@
+/**
+ * ApiRouter.h
+ *
+ * API路由模块，将注册的路径编译为完美哈希分发表，并为每个路由记录延迟直方图
+ *
+ * @file ApiRouter.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef API_ROUTER_H
+#define API_ROUTER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <StreamString.h>
+#include "AtomicCounter.h"
+#include "JsonResponseWriter.h"
+
+// 路由配置
+#define API_ROUTER_MAX_ROUTES 24       // 最大路由数量
+#define API_ROUTER_TABLE_SIZE 64       // 哈希表槽位数量（2的幂, 至少为路径数量的2倍）
+#define API_LATENCY_BUCKETS 21         // 延迟直方图桶数量，第i个桶的上限为2^i微秒
+#define API_ROUTER_MAX_SEED_TRIES 4096 // 搜索无冲突哈希种子的最大次数
+
+// 前向声明
+class WebSocketManager;
+
+// 单个路由的统计数据，由网络任务无锁更新
+struct RouteStats
+{
+    AtomicCounter count;                        // 请求次数
+    AtomicCounter bytesIn;                      // 请求体字节数
+    AtomicCounter maxMicros;                    // 最大处理时间
+    AtomicCounter buckets[API_LATENCY_BUCKETS]; // 处理时间的对数直方图
+};
+
+// 注册的路由
+struct ApiRoute
+{
+    String path;                      // 路径
+    WebRequestMethodComposite method; // 允许的方法
+    ArRequestHandlerFunction handler; // 处理函数
+    int8_t nextSamePath;              // 相同路径的下一个路由（不同方法）, -1表示没有
+    RouteStats stats;                 // 统计数据
+};
+
+/**
+ * API路由器类
+ *
+ * 注册时把所有路径编译为无冲突的哈希表，请求分发只需一次哈希和一次字符串比较
+ */
+class ApiRouter : public AsyncWebHandler
+{
+public:
+    /**
+     * 构造函数
+     */
+    ApiRouter();
+
+    /**
+     * 注册路由
+     *
+     * 应在setup()中注册，每次注册都会重新编译分发表
+     *
+     * @param path 路径
+     * @param method 允许的方法
+     * @param handler 处理函数
+     * @return 是否注册成功
+     */
+    bool on(const char *path, WebRequestMethodComposite method, ArRequestHandlerFunction handler);
+
+    /**
+     * 将所有路由的统计数据以JSON格式写入输出流
+     *
+     * @param out 输出流
+     * @return 写入的字节数
+     */
+    size_t writeStatsJson(Print &out) const;
+
+    /**
+     * 通过WebSocket向客户端发送统计数据
+     *
+     * @param wsManager WebSocket管理器
+     * @param num 客户端编号
+     */
+    void sendStats(WebSocketManager *wsManager, uint8_t num);
+
+    /**
+     * 清零所有统计数据
+     */
+    void resetStats();
+
+    /**
+     * 获取路由数量
+     *
+     * @return 路由数量
+     */
+    size_t getRouteCount() const;
+
+    bool canHandle(AsyncWebServerRequest *request) override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+    bool isRequestHandlerTrivial() override;
+
+private:
+    ApiRoute _routes[API_ROUTER_MAX_ROUTES]; // 路由
+    uint8_t _routeCount;                     // 路由数量
+    uint8_t _slots[API_ROUTER_TABLE_SIZE];   // 哈希槽位，存放路由索引+1，0表示空
+    uint32_t _seed;                          // 无冲突的哈希种子
+    StreamString _wsPayload;                 // WebSocket发送缓冲区
+
+    /**
+     * 编译分发表
+     *
+     * @return 是否找到无冲突的种子
+     */
+    bool compile();
+
+    /**
+     * 查找请求对应的路由
+     *
+     * @param request 异步请求对象
+     * @return 路由，不存在时返回nullptr
+     */
+    ApiRoute *match(AsyncWebServerRequest *request);
+
+    /**
+     * 计算路径的哈希值
+     *
+     * @param path 路径
+     * @param len 路径长度
+     * @param seed 哈希种子
+     * @return 哈希值
+     */
+    static uint32_t hashPath(const char *path, size_t len, uint32_t seed);
+
+    /**
+     * 填充单个路由的统计数据
+     *
+     * @param index 路由索引
+     * @param routeDoc 输出文档
+     */
+    void fillRouteStats(size_t index, JsonDocument &routeDoc) const;
+
+    /**
+     * 估算直方图的分位数
+     *
+     * @param stats 统计数据
+     * @param quantile 分位数 (0-1)
+     * @return 对应的延迟上限（微秒）
+     */
+    static uint32_t percentile(const RouteStats &stats, float quantile);
+};
+
+#endif // API_ROUTER_H
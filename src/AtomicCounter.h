@@ -0,0 +1,106 @@
+/**
+ * AtomicCounter.h
+ *
+ * 无锁计数器，用于在网络任务中更新、在其他任务中读取的统计数据
+ *
+ * @file AtomicCounter.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef ATOMIC_COUNTER_H
+#define ATOMIC_COUNTER_H
+
+#include <Arduino.h>
+
+// ESP32为多核多任务，使用原子操作；ESP8266和RP2040的网络回调与loop()不会并发，
+// 32位对齐读写本身即为原子操作
+#if defined(ESP32)
+#include <atomic>
+#define ATOMIC_COUNTER_USE_STD 1
+#else
+#define ATOMIC_COUNTER_USE_STD 0
+#endif
+
+/**
+ * 无锁32位计数器
+ */
+class AtomicCounter
+{
+public:
+    AtomicCounter() : _value(0)
+    {
+    }
+
+    /**
+     * 增加计数
+     *
+     * @param delta 增量
+     */
+    inline void add(uint32_t delta = 1)
+    {
+#if ATOMIC_COUNTER_USE_STD
+        _value.fetch_add(delta, std::memory_order_relaxed);
+#else
+        _value = _value + delta;
+#endif
+    }
+
+    /**
+     * 设置数值
+     *
+     * @param value 新的数值
+     */
+    inline void set(uint32_t value)
+    {
+#if ATOMIC_COUNTER_USE_STD
+        _value.store(value, std::memory_order_relaxed);
+#else
+        _value = value;
+#endif
+    }
+
+    /**
+     * 如果新数值更大则更新
+     *
+     * @param value 候选数值
+     */
+    inline void updateMax(uint32_t value)
+    {
+#if ATOMIC_COUNTER_USE_STD
+        uint32_t current = _value.load(std::memory_order_relaxed);
+        while (value > current && !_value.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        {
+        }
+#else
+        if (value > _value)
+        {
+            _value = value;
+        }
+#endif
+    }
+
+    /**
+     * 读取数值
+     *
+     * @return 当前数值
+     */
+    inline uint32_t get() const
+    {
+#if ATOMIC_COUNTER_USE_STD
+        return _value.load(std::memory_order_relaxed);
+#else
+        return _value;
+#endif
+    }
+
+private:
+#if ATOMIC_COUNTER_USE_STD
+    std::atomic<uint32_t> _value;
+#else
+    volatile uint32_t _value;
+#endif
+};
+
+#endif // ATOMIC_COUNTER_H
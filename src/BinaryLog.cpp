@@ -0,0 +1,602 @@
+/**
+ * BinaryLog.cpp
+ *
+ * 二进制日志模块的实现
+ *
+ * 记录格式（小端）:
+ *   uint32 头部  bit31: 已提交标志, bit16-30: 格式ID, bit0-15: 记录总长度（4字节对齐）
+ *   uint32 时间戳（毫秒）
+ *   uint8  参数个数, 之后每个参数为 1字节类型标记 + 数据
+ *          ('i'/'u'/'f': 4字节, 's': 1字节长度 + 字符串内容)
+ *
+ * WebSocket二进制帧以 'L', 版本号, 2字节保留 开头，之后是若干条清除了提交标志的记录
+ *
+ * @file BinaryLog.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "BinaryLog.h"
+#include "WebSocketManager.h"
+#include "WsEventRouter.h"
+#include <ArduinoJson.h>
+#include <StreamString.h>
+
+#define BINARY_LOG_MASK (BINARY_LOG_BUFFER_SIZE - 1)
+#define BINARY_LOG_COMMITTED 0x80000000UL
+#define BINARY_LOG_RECORD_HEADER 8
+#define BINARY_LOG_FRAME_MAGIC 'L'
+#define BINARY_LOG_FRAME_VERSION 1
+
+// 格式表的登记很少发生，用短临界区保护
+#if defined(ESP32)
+static portMUX_TYPE formatLock = portMUX_INITIALIZER_UNLOCKED;
+#define FORMAT_LOCK() portENTER_CRITICAL(&formatLock)
+#define FORMAT_UNLOCK() portEXIT_CRITICAL(&formatLock)
+#define LOG_FENCE_RELEASE() std::atomic_thread_fence(std::memory_order_release)
+#define LOG_FENCE_ACQUIRE() std::atomic_thread_fence(std::memory_order_acquire)
+#else
+#define FORMAT_LOCK() noInterrupts()
+#define FORMAT_UNLOCK() interrupts()
+#define LOG_FENCE_RELEASE() __sync_synchronize()
+#define LOG_FENCE_ACQUIRE() __sync_synchronize()
+#endif
+
+const char *BinaryLog::_formats[BINARY_LOG_MAX_FORMATS];
+volatile uint16_t BinaryLog::_formatCount = 0;
+
+/**
+ * 写入有符号整数参数
+ */
+void BinaryLogPacker::putInt(int32_t value)
+{
+    put(BINARY_LOG_ARG_INT, &value, sizeof(value));
+}
+
+/**
+ * 写入无符号整数参数
+ */
+void BinaryLogPacker::putUint(uint32_t value)
+{
+    put(BINARY_LOG_ARG_UINT, &value, sizeof(value));
+}
+
+/**
+ * 写入浮点参数
+ */
+void BinaryLogPacker::putFloat(float value)
+{
+    put(BINARY_LOG_ARG_FLOAT, &value, sizeof(value));
+}
+
+/**
+ * 写入字符串参数（截断到BINARY_LOG_MAX_STRING字节）
+ */
+void BinaryLogPacker::putString(const char *value)
+{
+    if (!value)
+    {
+        value = "(null)";
+    }
+
+    size_t len = strnlen(value, BINARY_LOG_MAX_STRING);
+    if (_length + 2 > sizeof(_buffer))
+    {
+        return;
+    }
+    if (_length + 2 + len > sizeof(_buffer))
+    {
+        len = sizeof(_buffer) - _length - 2;
+    }
+
+    _buffer[_length++] = BINARY_LOG_ARG_STRING;
+    _buffer[_length++] = (uint8_t)len;
+    memcpy(_buffer + _length, value, len);
+    _length += len;
+    _argc++;
+}
+
+/**
+ * 获取打包后的数据
+ */
+const uint8_t *BinaryLogPacker::data()
+{
+    _buffer[0] = _argc;
+    return _buffer;
+}
+
+/**
+ * 写入定长参数
+ */
+bool BinaryLogPacker::put(uint8_t tag, const void *value, size_t size)
+{
+    if (_length + 1 + size > sizeof(_buffer))
+    {
+        return false;
+    }
+
+    _buffer[_length++] = tag;
+    memcpy(_buffer + _length, value, size);
+    _length += size;
+    _argc++;
+    return true;
+}
+
+/**
+ * 获取全局实例
+ */
+BinaryLog &BinaryLog::instance()
+{
+    static BinaryLog log;
+    return log;
+}
+
+/**
+ * 构造函数
+ */
+BinaryLog::BinaryLog() : _head(0),
+                         _tail(0),
+                         _reportedDropped(0),
+                         _serialOutput(true),
+                         _wsManager(nullptr),
+                         _sentFormats(0),
+                         _formatClients(0),
+                         _router(nullptr),
+                         _frameLength(0)
+{
+    memset(_buffer, 0, sizeof(_buffer));
+}
+
+/**
+ * 登记格式字符串
+ */
+uint16_t BinaryLog::registerFormat(const char *format)
+{
+    FORMAT_LOCK();
+
+    uint16_t id = _formatCount;
+    for (uint16_t i = 0; i < _formatCount; i++)
+    {
+        if (_formats[i] == format)
+        {
+            id = i;
+            break;
+        }
+    }
+
+    if (id == _formatCount)
+    {
+        if (_formatCount < BINARY_LOG_MAX_FORMATS)
+        {
+            _formats[_formatCount++] = format;
+        }
+        else
+        {
+            // 格式表已满，记录会以未知格式输出
+            id = BINARY_LOG_MAX_FORMATS;
+        }
+    }
+
+    FORMAT_UNLOCK();
+    return id;
+}
+
+/**
+ * 输出缓冲区中的日志
+ */
+void BinaryLog::drain(uint16_t budget)
+{
+    uint32_t dropped = _dropped.get();
+    if (dropped != _reportedDropped && _serialOutput)
+    {
+        Serial.printf("[日志] 缓冲区已满, 丢弃 %u 条记录\n", (unsigned)(dropped - _reportedDropped));
+    }
+    _reportedDropped = dropped;
+
+    // WebSocket客户端需要先拿到格式表才能解码
+    bool wsActive = false;
+    if (_wsManager)
+    {
+        wsActive = _wsManager->getClientCount() > 0;
+
+        // 新登记的格式广播给已有的客户端
+        uint16_t formatCount = _formatCount;
+        if (wsActive && _sentFormats < formatCount)
+        {
+            sendFormats(-1, _sentFormats, formatCount);
+        }
+        _sentFormats = formatCount;
+
+        // 新连接的客户端收到完整的格式表
+        for (uint8_t num = 0; _formatClients && num < 32; num++)
+        {
+            if (_formatClients & (1UL << num))
+            {
+                _formatClients &= ~(1UL << num);
+                sendFormats(num, 0, formatCount);
+            }
+        }
+    }
+
+    uint8_t record[BINARY_LOG_RECORD_HEADER + BINARY_LOG_MAX_PAYLOAD + 4];
+
+    while (budget--)
+    {
+        uint32_t tail = _tail;
+#if defined(ESP32)
+        uint32_t head = _head.load(std::memory_order_acquire);
+#else
+        uint32_t head = _head;
+#endif
+        if (tail == head)
+        {
+            break;
+        }
+
+        uint32_t header = *(volatile uint32_t *)&_buffer[tail & BINARY_LOG_MASK];
+        if (!(header & BINARY_LOG_COMMITTED))
+        {
+            // 生产者仍在写入这条记录
+            break;
+        }
+        LOG_FENCE_ACQUIRE();
+
+        size_t size = header & 0xFFFF;
+        copyOut(tail, record, size);
+
+        // 清零已读取的区域，保证未提交的头部始终为0
+        clear(tail, size);
+        LOG_FENCE_RELEASE();
+        _tail = tail + size;
+
+        header &= ~BINARY_LOG_COMMITTED;
+        memcpy(record, &header, sizeof(header));
+
+        if (_serialOutput)
+        {
+            printRecord(record, size);
+        }
+        if (wsActive)
+        {
+            appendToFrame(record, size);
+        }
+    }
+
+    flushFrame();
+}
+
+/**
+ * 启用或禁用串口输出
+ */
+void BinaryLog::setSerialOutput(bool enable)
+{
+    _serialOutput = enable;
+}
+
+/**
+ * 设置WebSocket输出
+ */
+void BinaryLog::setWebSocketOutput(WebSocketManager *wsManager, WsEventRouter *router)
+{
+    _wsManager = wsManager;
+    _formatClients = 0;
+
+    // 已经连接的客户端在下次drain()时收到完整的格式表
+    _sentFormats = 0;
+
+    if (router && router != _router)
+    {
+        // 连接事件在主循环中分发，与drain()不会同时执行
+        router->addListener([this](uint8_t num, WStype_t type, uint8_t *, size_t)
+                            {
+                                if (num < 32)
+                                {
+                                    if (type == WStype_CONNECTED)
+                                    {
+                                        _formatClients |= 1UL << num;
+                                    }
+                                    else if (type == WStype_DISCONNECTED)
+                                    {
+                                        _formatClients &= ~(1UL << num);
+                                    }
+                                }
+                                return false;
+                            });
+        _router = router;
+    }
+}
+
+/**
+ * 获取丢弃的记录数
+ */
+uint32_t BinaryLog::getDroppedCount() const
+{
+    return _dropped.get();
+}
+
+/**
+ * 写入记录到环形缓冲区
+ */
+void BinaryLog::commit(uint16_t formatId, const uint8_t *payload, size_t length)
+{
+    uint32_t size = (BINARY_LOG_RECORD_HEADER + length + 3) & ~3UL;
+    uint32_t position;
+
+    if (!reserve(size, position))
+    {
+        _dropped.add();
+        return;
+    }
+
+    uint32_t timestamp = millis();
+    copyIn(position + 4, &timestamp, sizeof(timestamp));
+    copyIn(position + BINARY_LOG_RECORD_HEADER, payload, length);
+
+    // 最后写入头部，消费者看到提交标志时内容已经完整
+    LOG_FENCE_RELEASE();
+    uint32_t header = BINARY_LOG_COMMITTED | ((uint32_t)(formatId & 0x7FFF) << 16) | size;
+    *(volatile uint32_t *)&_buffer[position & BINARY_LOG_MASK] = header;
+}
+
+/**
+ * 预留缓冲区空间
+ */
+bool BinaryLog::reserve(uint32_t size, uint32_t &position)
+{
+#if defined(ESP32)
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    do
+    {
+        if (head + size - _tail > BINARY_LOG_BUFFER_SIZE)
+        {
+            return false;
+        }
+    } while (!_head.compare_exchange_weak(head, head + size, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    position = head;
+    return true;
+#else
+    // 单核平台上只需屏蔽中断完成预留
+    bool reserved = false;
+    noInterrupts();
+    if (_head + size - _tail <= BINARY_LOG_BUFFER_SIZE)
+    {
+        position = _head;
+        _head = _head + size;
+        reserved = true;
+    }
+    interrupts();
+    return reserved;
+#endif
+}
+
+/**
+ * 复制数据到环形缓冲区
+ */
+void BinaryLog::copyIn(uint32_t position, const void *data, size_t length)
+{
+    uint32_t offset = position & BINARY_LOG_MASK;
+    size_t first = BINARY_LOG_BUFFER_SIZE - offset;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(_buffer + offset, data, first);
+    memcpy(_buffer, (const uint8_t *)data + first, length - first);
+}
+
+/**
+ * 从环形缓冲区复制数据
+ */
+void BinaryLog::copyOut(uint32_t position, void *data, size_t length) const
+{
+    uint32_t offset = position & BINARY_LOG_MASK;
+    size_t first = BINARY_LOG_BUFFER_SIZE - offset;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(data, _buffer + offset, first);
+    memcpy((uint8_t *)data + first, _buffer, length - first);
+}
+
+/**
+ * 清零环形缓冲区中的区域
+ */
+void BinaryLog::clear(uint32_t position, size_t length)
+{
+    uint32_t offset = position & BINARY_LOG_MASK;
+    size_t first = BINARY_LOG_BUFFER_SIZE - offset;
+    if (first > length)
+    {
+        first = length;
+    }
+    memset(_buffer + offset, 0, first);
+    memset(_buffer, 0, length - first);
+}
+
+/**
+ * 在串口上格式化输出一条记录
+ */
+void BinaryLog::printRecord(const uint8_t *record, size_t size)
+{
+    uint32_t header;
+    memcpy(&header, record, sizeof(header));
+    uint16_t formatId = (header >> 16) & 0x7FFF;
+
+    if (formatId >= _formatCount)
+    {
+        Serial.printf("[日志] 未知格式 %u\n", formatId);
+        return;
+    }
+
+    const char *format = _formats[formatId];
+    const uint8_t *arg = record + BINARY_LOG_RECORD_HEADER;
+    const uint8_t *end = record + size;
+    uint8_t argc = *arg++;
+    char spec[16];
+    char text[BINARY_LOG_MAX_STRING + 32];
+
+    while (*format)
+    {
+        if (*format != '%')
+        {
+            const char *run = format;
+            while (*format && *format != '%')
+            {
+                format++;
+            }
+            Serial.write((const uint8_t *)run, format - run);
+            continue;
+        }
+
+        if (format[1] == '%')
+        {
+            Serial.write('%');
+            format += 2;
+            continue;
+        }
+
+        // 复制转换说明，去掉长度修饰符（参数已统一为32位）
+        size_t specLen = 0;
+        spec[specLen++] = *format++;
+        while (*format && !strchr("diouxXcsfFeEgGp", *format))
+        {
+            if (!strchr("hlLqjzt", *format) && specLen < sizeof(spec) - 2)
+            {
+                spec[specLen++] = *format;
+            }
+            format++;
+        }
+        if (!*format)
+        {
+            break;
+        }
+        char conversion = *format++;
+        spec[specLen++] = conversion;
+        spec[specLen] = '\0';
+
+        if (!argc || arg >= end)
+        {
+            Serial.print(spec);
+            continue;
+        }
+        argc--;
+
+        uint8_t tag = *arg++;
+        bool isFloatSpec = strchr("fFeEgG", conversion) != nullptr;
+
+        if (tag == BINARY_LOG_ARG_STRING)
+        {
+            uint8_t len = *arg++;
+            char str[BINARY_LOG_MAX_STRING + 1];
+            memcpy(str, arg, len);
+            str[len] = '\0';
+            arg += len;
+            snprintf(text, sizeof(text), conversion == 's' ? spec : "%s", str);
+        }
+        else
+        {
+            uint32_t raw;
+            memcpy(&raw, arg, sizeof(raw));
+            arg += sizeof(raw);
+
+            if (tag == BINARY_LOG_ARG_FLOAT)
+            {
+                float value;
+                memcpy(&value, &raw, sizeof(value));
+                snprintf(text, sizeof(text), isFloatSpec ? spec : "%g", (double)value);
+            }
+            else if (isFloatSpec)
+            {
+                snprintf(text, sizeof(text), spec, tag == BINARY_LOG_ARG_INT ? (double)(int32_t)raw : (double)raw);
+            }
+            else if (conversion == 's' || conversion == 'p')
+            {
+                snprintf(text, sizeof(text), "0x%08lx", (unsigned long)raw);
+            }
+            else
+            {
+                snprintf(text, sizeof(text), spec, (int)raw);
+            }
+        }
+        Serial.print(text);
+    }
+}
+
+/**
+ * 把记录加入WebSocket帧
+ */
+void BinaryLog::appendToFrame(const uint8_t *record, size_t size)
+{
+    if (_frameLength + size > sizeof(_frame))
+    {
+        flushFrame();
+    }
+
+    if (_frameLength == 0)
+    {
+        _frame[0] = BINARY_LOG_FRAME_MAGIC;
+        _frame[1] = BINARY_LOG_FRAME_VERSION;
+        _frame[2] = 0;
+        _frame[3] = 0;
+        _frameLength = 4;
+    }
+
+    memcpy(_frame + _frameLength, record, size);
+    _frameLength += size;
+}
+
+/**
+ * 发送WebSocket帧
+ */
+void BinaryLog::flushFrame()
+{
+    if (_wsManager && _frameLength > 4)
+    {
+        _wsManager->broadcastBIN(_frame, _frameLength);
+    }
+    _frameLength = 0;
+}
+
+/**
+ * 向WebSocket客户端发送格式字符串表
+ */
+void BinaryLog::sendFormats(int16_t num, uint16_t from, uint16_t count)
+{
+    // 分批发送，单条消息保持较小
+    while (from < count)
+    {
+        StreamString message;
+        message.printf("{\"type\":\"log_formats\",\"base\":%u,\"formats\":[", from);
+
+        uint16_t end = from + 16;
+        if (end > count)
+        {
+            end = count;
+        }
+
+        for (uint16_t i = from; i < end; i++)
+        {
+            StaticJsonDocument<16> formatDoc;
+            formatDoc.set(_formats[i]);
+            if (i > from)
+            {
+                message.print(',');
+            }
+            serializeJson(formatDoc, message);
+        }
+        message.print("]}");
+
+        if (num < 0)
+        {
+            _wsManager->broadcastTXT(message);
+        }
+        else
+        {
+            _wsManager->sendTXT(num, message);
+        }
+        from = end;
+    }
+}
@@ -0,0 +1,279 @@
+/**
+ * BinaryLog.h
+ *
+ * 二进制日志模块
+ *
+ * 日志调用只把格式字符串ID和原始参数写入无锁环形缓冲区，
+ * 格式化推迟到handle()中的后台输出（串口）或浏览器端（WebSocket）
+ *
+ * @file BinaryLog.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef BINARY_LOG_H
+#define BINARY_LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+#include "AtomicCounter.h"
+
+#if defined(ESP32)
+#include <atomic>
+#endif
+
+// 日志配置
+#define BINARY_LOG_BUFFER_SIZE 4096 // 环形缓冲区大小（2的幂）
+#define BINARY_LOG_MAX_FORMATS 128  // 最多登记的格式字符串数量
+#define BINARY_LOG_MAX_PAYLOAD 96   // 单条记录的最大参数字节数
+#define BINARY_LOG_MAX_STRING 32    // 字符串参数最多保存的字节数
+#define BINARY_LOG_DRAIN_BUDGET 16  // 每次handle()最多输出的记录数
+#define BINARY_LOG_FRAME_SIZE 512   // WebSocket二进制帧的最大长度
+
+// 参数类型标记
+#define BINARY_LOG_ARG_INT 'i'
+#define BINARY_LOG_ARG_UINT 'u'
+#define BINARY_LOG_ARG_FLOAT 'f'
+#define BINARY_LOG_ARG_STRING 's'
+
+/**
+ * 记录一条二进制日志
+ *
+ * 每个调用点的格式字符串只在第一次执行时登记，之后只写入ID和参数
+ */
+#define BLOG(fmt, ...)                                                        \
+    do                                                                        \
+    {                                                                         \
+        static const uint16_t _blogFormatId = BinaryLog::registerFormat(fmt); \
+        BinaryLog::instance().record(_blogFormatId, ##__VA_ARGS__);           \
+    } while (0)
+
+// 前向声明
+class WebSocketManager;
+class WsEventRouter;
+
+/**
+ * 参数打包器
+ */
+class BinaryLogPacker
+{
+public:
+    BinaryLogPacker() : _length(1), _argc(0)
+    {
+    }
+
+    void putInt(int32_t value);
+    void putUint(uint32_t value);
+    void putFloat(float value);
+    void putString(const char *value);
+
+    const uint8_t *data();
+    size_t length() const
+    {
+        return _length;
+    }
+
+private:
+    uint8_t _buffer[BINARY_LOG_MAX_PAYLOAD]; // 第一个字节为参数个数
+    size_t _length;
+    uint8_t _argc;
+
+    bool put(uint8_t tag, const void *value, size_t size);
+};
+
+/**
+ * 二进制日志类
+ */
+class BinaryLog
+{
+public:
+    /**
+     * 获取全局实例
+     *
+     * @return 日志实例
+     */
+    static BinaryLog &instance();
+
+    /**
+     * 登记格式字符串
+     *
+     * @param format 格式字符串（必须是静态存储的字符串常量）
+     * @return 格式ID
+     */
+    static uint16_t registerFormat(const char *format);
+
+    /**
+     * 写入一条日志
+     *
+     * @param formatId 格式ID
+     * @param args 参数
+     */
+    template <typename... Args>
+    void record(uint16_t formatId, Args... args)
+    {
+        BinaryLogPacker packer;
+        pack(packer, args...);
+        commit(formatId, packer.data(), packer.length());
+    }
+
+    /**
+     * 输出缓冲区中的日志，需要在loop()中调用
+     *
+     * @param budget 本次最多输出的记录数
+     */
+    void drain(uint16_t budget = BINARY_LOG_DRAIN_BUDGET);
+
+    /**
+     * 启用或禁用串口输出
+     *
+     * @param enable 是否启用
+     */
+    void setSerialOutput(bool enable);
+
+    /**
+     * 设置WebSocket输出
+     *
+     * 每个客户端连接时都会收到完整的格式表，之后登记的格式广播给所有客户端
+     *
+     * @param wsManager WebSocket管理器, nullptr表示禁用
+     * @param router 事件路由器，用于接收连接事件（只需在第一次设置时提供）
+     */
+    void setWebSocketOutput(WebSocketManager *wsManager, WsEventRouter *router = nullptr);
+
+    /**
+     * 获取因缓冲区已满而丢弃的记录数
+     *
+     * @return 丢弃的记录数
+     */
+    uint32_t getDroppedCount() const;
+
+private:
+    BinaryLog();
+
+    alignas(4) uint8_t _buffer[BINARY_LOG_BUFFER_SIZE]; // 环形缓冲区
+#if defined(ESP32)
+    std::atomic<uint32_t> _head; // 生产者预留位置
+#else
+    volatile uint32_t _head; // 生产者预留位置
+#endif
+    volatile uint32_t _tail;               // 消费者读取位置
+    AtomicCounter _dropped;                // 丢弃的记录数
+    uint32_t _reportedDropped;             // 已报告的丢弃数
+    bool _serialOutput;                    // 是否输出到串口
+    WebSocketManager *_wsManager;          // WebSocket输出
+    uint16_t _sentFormats;                 // 已广播给WebSocket客户端的格式数量
+    uint32_t _formatClients;               // 新连接、需要完整格式表的客户端位图
+    WsEventRouter *_router;                // 已注册监听器的事件路由器
+    uint8_t _frame[BINARY_LOG_FRAME_SIZE]; // WebSocket帧缓冲区
+    size_t _frameLength;                   // 帧缓冲区中的字节数
+
+    static const char *_formats[BINARY_LOG_MAX_FORMATS]; // 格式字符串表
+    static volatile uint16_t _formatCount;               // 已登记的格式数量
+
+    // 参数打包
+    static void pack(BinaryLogPacker &)
+    {
+    }
+
+    template <typename T, typename... Rest>
+    static void pack(BinaryLogPacker &packer, T value, Rest... rest)
+    {
+        packArg(packer, value);
+        pack(packer, rest...);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+    packArg(BinaryLogPacker &packer, T value)
+    {
+        packer.putInt((int32_t)value);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type
+    packArg(BinaryLogPacker &packer, T value)
+    {
+        packer.putUint((uint32_t)value);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    packArg(BinaryLogPacker &packer, T value)
+    {
+        packer.putFloat((float)value);
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_enum<T>::value>::type
+    packArg(BinaryLogPacker &packer, T value)
+    {
+        packer.putInt((int32_t)value);
+    }
+
+    static void packArg(BinaryLogPacker &packer, const char *value)
+    {
+        packer.putString(value);
+    }
+
+    static void packArg(BinaryLogPacker &packer, char *value)
+    {
+        packer.putString(value);
+    }
+
+    static void packArg(BinaryLogPacker &packer, const String &value)
+    {
+        packer.putString(value.c_str());
+    }
+
+    /**
+     * 写入记录到环形缓冲区
+     *
+     * @param formatId 格式ID
+     * @param payload 参数数据
+     * @param length 参数长度
+     */
+    void commit(uint16_t formatId, const uint8_t *payload, size_t length);
+
+    /**
+     * 预留缓冲区空间
+     *
+     * @param size 记录大小
+     * @param position 输出的起始位置
+     * @return 是否预留成功
+     */
+    bool reserve(uint32_t size, uint32_t &position);
+
+    /**
+     * 在环形缓冲区中复制数据
+     */
+    void copyIn(uint32_t position, const void *data, size_t length);
+    void copyOut(uint32_t position, void *data, size_t length) const;
+    void clear(uint32_t position, size_t length);
+
+    /**
+     * 在串口上格式化输出一条记录
+     */
+    void printRecord(const uint8_t *record, size_t size);
+
+    /**
+     * 把记录加入WebSocket帧
+     */
+    void appendToFrame(const uint8_t *record, size_t size);
+
+    /**
+     * 发送WebSocket帧
+     */
+    void flushFrame();
+
+    /**
+     * 向WebSocket客户端发送格式字符串表
+     *
+     * @param num 客户端编号, -1表示广播
+     * @param from 第一个需要发送的格式ID
+     * @param count 发送到此ID之前
+     */
+    void sendFormats(int16_t num, uint16_t from, uint16_t count);
+};
+
+#endif // BINARY_LOG_H
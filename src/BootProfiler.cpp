@@ -0,0 +1,154 @@
+/**
+ * BootProfiler.cpp
+ *
+ * 启动性能分析模块的实现
+ *
+ * @file BootProfiler.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "BootProfiler.h"
+#include "WebSocketManager.h"
+#include "BinaryLog.h"
+#include <ArduinoJson.h>
+
+/**
+ * 构造函数
+ */
+BootProfiler::BootProfiler(WebSocketManager *wsManager) : _wsManager(wsManager),
+                                                          _phaseCount(0),
+                                                          _servingMicros(0),
+                                                          _reportSent(false)
+{
+}
+
+/**
+ * 开始一个阶段
+ */
+uint8_t BootProfiler::beginPhase(const char *name)
+{
+    if (_phaseCount >= BOOT_PROFILER_MAX_PHASES)
+    {
+        return BOOT_PHASE_INVALID;
+    }
+
+    BootPhase &phase = _phases[_phaseCount];
+    phase.name = name;
+    phase.startMicros = micros();
+    phase.endMicros = 0;
+    return _phaseCount++;
+}
+
+/**
+ * 结束一个阶段
+ */
+void BootProfiler::endPhase(uint8_t phase)
+{
+    if (phase < _phaseCount)
+    {
+        uint32_t now = micros();
+        _phases[phase].endMicros = now ? now : 1;
+    }
+}
+
+/**
+ * 标记设备开始提供服务
+ */
+void BootProfiler::markServing()
+{
+    _servingMicros = micros();
+}
+
+/**
+ * 获取从上电到开始提供服务的时间
+ */
+uint32_t BootProfiler::getServingMicros() const
+{
+    return _servingMicros;
+}
+
+/**
+ * 在串口输出启动阶段明细
+ */
+void BootProfiler::printSummary() const
+{
+    for (uint8_t i = 0; i < _phaseCount; i++)
+    {
+        const BootPhase &phase = _phases[i];
+        uint32_t end = phase.endMicros;
+        BLOG("启动阶段 %-14s 开始 %7lu us, 耗时 %7lu us\n",
+             phase.name, phase.startMicros, end ? end - phase.startMicros : 0);
+    }
+    BLOG("上电到开始服务共 %lu ms\n", _servingMicros / 1000);
+}
+
+/**
+ * 将启动报告以JSON格式写入输出流
+ */
+size_t BootProfiler::writeJson(Print &out) const
+{
+    size_t written = out.print("{\"type\":\"boot_profile\",\"phases\":[");
+
+    for (uint8_t i = 0; i < _phaseCount; i++)
+    {
+        const BootPhase &phase = _phases[i];
+        uint32_t end = phase.endMicros;
+
+        StaticJsonDocument<96> phaseDoc;
+        phaseDoc["name"] = phase.name;
+        phaseDoc["start"] = phase.startMicros;
+        if (end)
+        {
+            phaseDoc["duration"] = end - phase.startMicros;
+        }
+        else
+        {
+            phaseDoc["duration"] = nullptr;
+        }
+
+        if (i > 0)
+        {
+            written += out.write(',');
+        }
+        written += serializeJson(phaseDoc, out);
+    }
+
+    written += out.printf("],\"servingAt\":%lu}", (unsigned long)_servingMicros);
+    return written;
+}
+
+/**
+ * 向WebSocket客户端发送启动报告
+ */
+void BootProfiler::sendReport(uint8_t num)
+{
+    if (!_wsManager)
+    {
+        return;
+    }
+
+    _wsPayload = "";
+    writeJson(_wsPayload);
+    _wsManager->sendTXT(num, _wsPayload);
+}
+
+/**
+ * 第一个WebSocket客户端连接时推送启动报告
+ */
+void BootProfiler::handle()
+{
+    if (_reportSent || !_wsManager || _wsManager->getClientCount() == 0)
+    {
+        return;
+    }
+
+    _wsPayload = "";
+    writeJson(_wsPayload);
+    _wsManager->broadcastTXT(_wsPayload);
+    _reportSent = true;
+
+    // 报告只发送一次，释放缓冲区
+    _wsPayload = String();
+}
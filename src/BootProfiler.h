@@ -0,0 +1,110 @@
+/**
+ * BootProfiler.h
+ *
+ * 启动性能分析模块，记录各启动阶段的时间戳
+ *
+ * @file BootProfiler.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef BOOT_PROFILER_H
+#define BOOT_PROFILER_H
+
+#include <Arduino.h>
+#include <StreamString.h>
+
+// 分析配置
+#define BOOT_PROFILER_MAX_PHASES 16 // 最多记录的启动阶段数量
+#define BOOT_PHASE_INVALID 0xFF     // 无效的阶段索引
+
+// 前向声明
+class WebSocketManager;
+
+// 启动阶段记录
+struct BootPhase
+{
+    const char *name;            // 阶段名称（字符串常量）
+    uint32_t startMicros;        // 开始时间（上电后的微秒数）
+    volatile uint32_t endMicros; // 结束时间, 0表示尚未结束
+};
+
+/**
+ * 启动分析器类
+ *
+ * 阶段可以重叠（例如WiFi连接与文件系统挂载并行进行），
+ * 时间均以上电复位为起点，可以直接比较
+ */
+class BootProfiler
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param wsManager WebSocket管理器, 用于向第一个连接的客户端推送启动报告
+     */
+    BootProfiler(WebSocketManager *wsManager = nullptr);
+
+    /**
+     * 开始一个阶段
+     *
+     * @param name 阶段名称（必须是字符串常量）
+     * @return 阶段索引, 超出容量时返回BOOT_PHASE_INVALID
+     */
+    uint8_t beginPhase(const char *name);
+
+    /**
+     * 结束一个阶段，可以在其他任务中调用
+     *
+     * @param phase beginPhase返回的阶段索引
+     */
+    void endPhase(uint8_t phase);
+
+    /**
+     * 标记设备开始提供服务（网络就绪且服务器已启动）
+     */
+    void markServing();
+
+    /**
+     * 获取从上电到开始提供服务的时间
+     *
+     * @return 微秒数, 尚未就绪时返回0
+     */
+    uint32_t getServingMicros() const;
+
+    /**
+     * 在串口输出启动阶段明细
+     */
+    void printSummary() const;
+
+    /**
+     * 将启动报告以JSON格式写入输出流
+     *
+     * @param out 输出流
+     * @return 写入的字节数
+     */
+    size_t writeJson(Print &out) const;
+
+    /**
+     * 向WebSocket客户端发送启动报告
+     *
+     * @param num 客户端编号
+     */
+    void sendReport(uint8_t num);
+
+    /**
+     * 第一个WebSocket客户端连接时推送启动报告，需要在loop()中调用
+     */
+    void handle();
+
+private:
+    WebSocketManager *_wsManager;                // WebSocket管理器
+    BootPhase _phases[BOOT_PROFILER_MAX_PHASES]; // 阶段记录
+    uint8_t _phaseCount;                         // 已记录的阶段数量
+    uint32_t _servingMicros;                     // 开始提供服务的时间
+    bool _reportSent;                            // 是否已推送过启动报告
+    StreamString _wsPayload;                     // WebSocket消息缓冲区
+};
+
+#endif // BOOT_PROFILER_H
@@ -24,7 +24,8 @@ ESP32_OTA_WS_Lib::ESP32_OTA_WS_Lib(const char *deviceName,
                                                      _wsServerPort(wsServerPort),
                                                      _ledPin(ledPin),
                                                      _apiMonitoring(false),
-                                                     _lastApiStatsUpdate(0)
+                                                     _lastApiStatsUpdate(0),
+                                                     _webHandlersAttached(false)
 {
     // 初始化各个模块
     _wifiManager = new WiFiManager();
@@ -32,67 +33,212 @@ ESP32_OTA_WS_Lib::ESP32_OTA_WS_Lib(const char *deviceName,
     _webServer = new WebServerManager(webServerPort);
     _otaManager = new OTAManager(_wsManager);
     _sysMonitor = new SystemMonitor(_deviceName, _firmwareVersion);
+    _wifiScanner = new WiFiScanner(_wsManager);
+    _apiRouter = new ApiRouter();
+    _bootProfiler = new BootProfiler(_wsManager);
+    _wsRouter = new WsEventRouter(_wsManager);
+    _wsOta = new WsOtaReceiver(_wsManager, _otaManager);
+    _wsCommands = new WsCommandDispatcher(_wsManager);
+    _metrics = new MetricsSampler();
+
+#if EMBEDDED_WEB_UI_AVAILABLE
+    _embeddedAssets = new EmbeddedAssetHandler(EmbeddedWebUI::ROUTES, EmbeddedWebUI::ROUTE_COUNT);
+#else
+    _embeddedAssets = nullptr;
+#endif
 
 // 根据平台决定是否创建状态指示器
 #if defined(ESP32) || defined(ESP8266)
     _statusIndicator = new StatusIndicator(ledPin);
+    _staticAssets = new StaticAssetHandler(LittleFS);
+    _fsSync = new FsSync(LittleFS);
+    _peerOta = new PeerOtaMirror(_otaManager, LittleFS, webServerPort);
+    _power = new PowerManager();
+
+    // 同步修改文件后，静态资源的ETag和内存缓存随之失效
+    _fsSync->onSynced([this]()
+                      { _staticAssets->invalidate(); });
+
+    // 有客户端连接、更新、扫描或文件同步进行中时保持低延迟
+    _power->addActivitySource([this]()
+                              { return _wsManager->getClientCount() > 0; });
+    _power->addActivitySource([this]()
+                              { return _otaManager->isUpdating() || _otaManager->isRestartPending() || _wsOta->isActive(); });
+    _power->addActivitySource([this]()
+                              { return _peerOta->getState() != PEER_OTA_IDLE || _wifiScanner->isScanning() || _fsSync->isBusy(); });
+
+    // 空闲时主循环只需要按时采样指标、推进轮询方式的LED动画和计算文件清单
+    _power->addDeadlineSource([this](unsigned long now)
+                              { return _metrics->getNextSampleDelay(now); });
+    _power->addDeadlineSource([this](unsigned long)
+                              { return _statusIndicator->isTimedRendering() ? POWER_NO_DEADLINE : LED_FRAME_INTERVAL; });
+    _power->addDeadlineSource([this](unsigned long)
+                              { return _fsSync->isBuildingManifest() ? 0 : POWER_NO_DEADLINE; });
 #else
     _statusIndicator = nullptr;
+    _staticAssets = nullptr;
+    _fsSync = nullptr;
+    _peerOta = nullptr;
+    _power = nullptr;
 #endif
 }
 
+#if defined(ESP32)
+// 后台WiFi初始化任务的参数
+struct WiFiBeginContext
+{
+    WiFiManager *wifiManager; // WiFi管理器
+    BootProfiler *profiler;   // 启动分析器
+    uint8_t phase;            // WiFi阶段索引
+    TaskHandle_t waiter;      // 等待完成的任务
+};
+
+/**
+ * 在独立任务中执行WiFi初始化（连接或启动AP），完成后通知begin()
+ */
+static void wifiBeginTask(void *arg)
+{
+    WiFiBeginContext *context = (WiFiBeginContext *)arg;
+    context->wifiManager->begin();
+    context->profiler->endPhase(context->phase);
+    xTaskNotifyGive(context->waiter);
+    vTaskDelete(nullptr);
+}
+#endif
+
 /**
  * 初始化库
  */
 bool ESP32_OTA_WS_Lib::begin(bool mountFS)
 {
+    uint8_t phase = _bootProfiler->beginPhase("serial");
     Serial.begin(115200);
     Serial.println("\n--------------------------");
     Serial.printf("ESP32_OTA_WS_Lib v%s\n", ESP32_OTA_WS_LIB_VERSION);
     Serial.printf("设备名称: %s\n", _deviceName.c_str());
     Serial.printf("固件版本: %s\n", _firmwareVersion.c_str());
     Serial.println("--------------------------\n");
+    _bootProfiler->endPhase(phase);
 
     // 初始化状态指示器
     if (_statusIndicator)
     {
+        phase = _bootProfiler->beginPhase("status_led");
         _statusIndicator->begin();
+
+        // 支持的平台上由定时器驱动LED动画，OTA或阻塞的WiFi连接期间也不会停顿
+        _statusIndicator->enableTimedRendering(true);
+        _bootProfiler->endPhase(phase);
+    }
+
+    if (_embeddedAssets)
+    {
+        Serial.printf("使用嵌入的Web界面 (%u 个路由)\n", (unsigned)_embeddedAssets->getAssetCount());
+    }
+
+    // WiFi关联耗时最长，尽早开始，其他步骤与之并行
+    uint8_t wifiPhase = _bootProfiler->beginPhase("wifi");
+    bool wifiAsync = false;
+#if defined(ESP32)
+    // 先初始化网络协议栈，服务器可以在WiFi连接完成前开始监听
+    WiFi.mode(WIFI_STA);
+
+    WiFiBeginContext wifiContext = {_wifiManager, _bootProfiler, wifiPhase, xTaskGetCurrentTaskHandle()};
+    wifiAsync = xTaskCreatePinnedToCore(wifiBeginTask, "wifi_begin", 6144, &wifiContext,
+                                        uxTaskPriorityGet(nullptr), nullptr, tskNO_AFFINITY) == pdPASS;
+    if (!wifiAsync)
+    {
+        BLOG("无法创建WiFi初始化任务, 改为顺序初始化\n");
     }
+#endif
 
     // 挂载文件系统
     bool fsInitialized = true;
     if (mountFS)
     {
+        phase = _bootProfiler->beginPhase("fs_mount");
 #if defined(ESP32) || defined(ESP8266)
         fsInitialized = LittleFS.begin();
         if (!fsInitialized)
         {
-            Serial.println("文件系统挂载失败");
+            BLOG("文件系统挂载失败\n");
         }
         else
         {
-            Serial.println("文件系统挂载成功");
+            BLOG("文件系统挂载成功\n");
         }
 #else
         Serial.println("当前平台不支持LittleFS");
         fsInitialized = false;
 #endif
+        _bootProfiler->endPhase(phase);
     }
 
-    // 初始化WiFi管理器
-    _wifiManager->begin();
-
+    // 服务器监听所有接口，网络就绪后立即可以接受连接
     // 初始化WebSocket服务器
+    phase = _bootProfiler->beginPhase("websocket");
     _wsManager->begin();
 
+    // 接管事件回调，二进制OTA帧由接收器处理，其余事件交给WebSocketManager
+    _wsRouter->begin();
+    _wsOta->begin(_wsRouter);
+    _wsCommands->begin(_wsRouter);
+
+    // {"cmd":"api_stats"}：路由统计较大，以单独的api_stats消息发送，应答只包含路由数量
+    _wsCommands->on("api_stats", [this](WsCommandContext &ctx)
+                    {
+                        _apiRouter->sendStats(_wsManager, ctx.client());
+                        ctx.result()["routes"] = _apiRouter->getRouteCount(); });
+
+    // {"cmd":"boot_profile"}：之后连接的客户端也能获取启动明细，以单独的boot_profile消息发送
+    _wsCommands->on("boot_profile", [this](WsCommandContext &ctx)
+                    { _bootProfiler->sendReport(ctx.client()); });
+    _bootProfiler->endPhase(phase);
+
+    // 日志同时以二进制帧推送给WebSocket客户端，由浏览器格式化
+    BinaryLog::instance().setWebSocketOutput(_wsManager, _wsRouter);
+
     // 初始化Web服务器并配置路由
+    phase = _bootProfiler->beginPhase("web_server");
+    attachWebHandlers(*_webServer->getServer());
     _webServer->begin();
+    _bootProfiler->endPhase(phase);
 
     // 配置OTA管理器
+    phase = _bootProfiler->beginPhase("ota");
     _otaManager->begin();
 
-    // 配置系统监控器
+    // 上次重启前未完成的设备间分发
+    if (_peerOta && fsInitialized)
+    {
+        _peerOta->begin();
+    }
+    _bootProfiler->endPhase(phase);
+
+    // 等待WiFi初始化完成
+    if (wifiAsync)
+    {
+#if defined(ESP32)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+#endif
+    }
+    else
+    {
+        // 初始化WiFi管理器
+        _wifiManager->begin();
+        _bootProfiler->endPhase(wifiPhase);
+    }
+    _bootProfiler->markServing();
+
+    // 配置系统监控器（依赖WiFi状态）
+    phase = _bootProfiler->beginPhase("system_monitor");
     _sysMonitor->begin();
+    _metrics->begin();
+    if (_power)
+    {
+        _power->begin();
+    }
+    _bootProfiler->endPhase(phase);
 
     // 设置状态指示器模式
     if (_statusIndicator)
@@ -107,6 +253,11 @@ bool ESP32_OTA_WS_Lib::begin(bool mountFS)
         }
     }
 
+    _bootProfiler->printSummary();
+
+    // 输出初始化期间缓存的日志
+    BinaryLog::instance().drain(BINARY_LOG_MAX_FORMATS);
+
     return fsInitialized;
 }
 
@@ -118,9 +269,33 @@ void ESP32_OTA_WS_Lib::handle()
     // 处理WiFi状态变化
     _wifiManager->handle();
 
+    // 推进异步WiFi扫描
+    _wifiScanner->handle();
+
     // 处理WebSocket消息
     _wsManager->handle();
 
+    // 向第一个连接的客户端推送启动报告
+    _bootProfiler->handle();
+
+    // WebSocket OTA会话超时
+    _wsOta->handle();
+
+    // OTA完成后的计划重启
+    _otaManager->handle();
+
+    // 分批计算文件同步清单
+    if (_fsSync)
+    {
+        _fsSync->handle();
+    }
+
+    // 设备间固件分发
+    if (_peerOta)
+    {
+        _peerOta->handle();
+    }
+
     // 更新状态指示器
     if (_statusIndicator)
     {
@@ -137,6 +312,19 @@ void ESP32_OTA_WS_Lib::handle()
 
     // 处理系统监控
     _sysMonitor->handle();
+
+    // 运行指标采样
+    _metrics->recordLoop();
+    _metrics->handle();
+
+    // 在主循环中格式化并输出日志
+    BinaryLog::instance().drain();
+
+    // 空闲时等待到下一个截止时间，需要在最后调用
+    if (_power)
+    {
+        _power->handle();
+    }
 }
 
 /**
@@ -167,6 +355,80 @@ void ESP32_OTA_WS_Lib::broadcastMessage(const String &message)
     }
 }
 
+/**
+ * 发送文档到所有连接的WebSocket客户端
+ */
+void ESP32_OTA_WS_Lib::broadcastMessage(const JsonDocument &doc)
+{
+    if (_wsManager)
+    {
+        _wsManager->broadcastDocument(doc);
+    }
+}
+
+/**
+ * 将库提供的HTTP路由注册到Web服务器
+ */
+void ESP32_OTA_WS_Lib::attachWebHandlers(AsyncWebServer &server)
+{
+    // 同一组处理器只能属于一个服务器
+    if (_webHandlersAttached)
+    {
+        return;
+    }
+    _webHandlersAttached = true;
+
+    // WiFi扫描（异步、带缓存）
+    _apiRouter->on("/api/wifi/scan", HTTP_GET, [this](AsyncWebServerRequest *request)
+                   { _wifiScanner->handleRequest(request); });
+
+    // 启动阶段明细
+    _apiRouter->on("/api/boot", HTTP_GET, [this](AsyncWebServerRequest *request)
+                   { request->send(JsonResponseWriter::beginDocument(
+                         request, [this](Print &out)
+                         { _bootProfiler->writeJson(out); })); });
+
+    // Prometheus/OpenMetrics格式的指标
+    _apiRouter->on("/metrics", HTTP_GET, [](AsyncWebServerRequest *request)
+                   { request->send(MetricsRegistry::beginResponse(request)); });
+
+    // CPU占用、主循环频率和任务栈余量
+    _metrics->attach(*_apiRouter);
+
+    // 向其他设备提供正在运行的固件
+    if (_peerOta)
+    {
+        _peerOta->attach(*_apiRouter);
+    }
+
+    // 省电状态和各状态的时间
+    if (_power)
+    {
+        _power->attach(*_apiRouter);
+    }
+
+    // 库和用户注册的API路由，带每路由延迟统计
+    server.addHandler(_apiRouter);
+
+    // 文件级增量同步（上传需要请求体处理函数，直接注册到服务器）
+    if (_fsSync)
+    {
+        _fsSync->attach(server);
+    }
+
+    // 编译期嵌入的Web界面优先，启动后立即可用且不依赖文件系统
+    if (_embeddedAssets)
+    {
+        server.addHandler(_embeddedAssets);
+    }
+
+    // 静态Web资源（预压缩、ETag、内存热缓存）
+    if (_staticAssets)
+    {
+        server.addHandler(_staticAssets);
+    }
+}
+
 // 获取各模块的实例
 OTAManager *ESP32_OTA_WS_Lib::getOTAManager()
 {
@@ -196,4 +458,64 @@ SystemMonitor *ESP32_OTA_WS_Lib::getSystemMonitor()
 StatusIndicator *ESP32_OTA_WS_Lib::getStatusIndicator()
 {
     return _statusIndicator;
-}
\ No newline at end of file
+}
+
+WiFiScanner *ESP32_OTA_WS_Lib::getWiFiScanner()
+{
+    return _wifiScanner;
+}
+
+StaticAssetHandler *ESP32_OTA_WS_Lib::getStaticAssetHandler()
+{
+    return _staticAssets;
+}
+
+EmbeddedAssetHandler *ESP32_OTA_WS_Lib::getEmbeddedAssetHandler()
+{
+    return _embeddedAssets;
+}
+
+ApiRouter *ESP32_OTA_WS_Lib::getApiRouter()
+{
+    return _apiRouter;
+}
+
+BootProfiler *ESP32_OTA_WS_Lib::getBootProfiler()
+{
+    return _bootProfiler;
+}
+
+WsEventRouter *ESP32_OTA_WS_Lib::getWsEventRouter()
+{
+    return _wsRouter;
+}
+
+WsOtaReceiver *ESP32_OTA_WS_Lib::getWsOtaReceiver()
+{
+    return _wsOta;
+}
+
+WsCommandDispatcher *ESP32_OTA_WS_Lib::getWsCommandDispatcher()
+{
+    return _wsCommands;
+}
+
+FsSync *ESP32_OTA_WS_Lib::getFsSync()
+{
+    return _fsSync;
+}
+
+MetricsSampler *ESP32_OTA_WS_Lib::getMetricsSampler()
+{
+    return _metrics;
+}
+
+PeerOtaMirror *ESP32_OTA_WS_Lib::getPeerOtaMirror()
+{
+    return _peerOta;
+}
+
+PowerManager *ESP32_OTA_WS_Lib::getPowerManager()
+{
+    return _power;
+}
@@ -33,6 +33,21 @@
 #include "WebServerManager.h"
 #include "SystemMonitor.h"
 #include "StatusIndicator.h"
+#include "WiFiScanner.h"
+#include "StaticAssetHandler.h"
+#include "EmbeddedAssetHandler.h"
+#include "ApiRouter.h"
+#include "BinaryLog.h"
+#include "BootProfiler.h"
+#include "OtaWsLib.h"
+#include "WsEventRouter.h"
+#include "WsOtaReceiver.h"
+#include "WsCommandDispatcher.h"
+#include "FsSync.h"
+#include "MetricsSampler.h"
+#include "MetricsRegistry.h"
+#include "PeerOtaMirror.h"
+#include "PowerManager.h"
 
 // 库版本
 #define ESP32_OTA_WS_LIB_VERSION "1.0.0"
@@ -63,6 +78,8 @@ public:
     /**
      * 初始化库
      *
+     * 使用嵌入的Web界面（EMBEDDED_WEB_UI_AVAILABLE）时无需挂载文件系统
+     *
      * @param mountFS 是否挂载文件系统
      * @return 初始化是否成功
      */
@@ -94,6 +111,23 @@ public:
      */
     void broadcastMessage(const String &message);
 
+    /**
+     * 发送文档到所有连接的WebSocket客户端，按各客户端协商的编码序列化
+     *
+     * @param doc 要发送的文档
+     */
+    void broadcastMessage(const JsonDocument &doc);
+
+    /**
+     * 将库提供的HTTP路由注册到Web服务器
+     *
+     * begin()已在WebServerManager的服务器启动前调用，只需注册一次，重复调用无效；
+     * 静态资源处理器也在此注册，因此位于WebServerManager自己的路由之前
+     *
+     * @param server 异步Web服务器
+     */
+    void attachWebHandlers(AsyncWebServer &server);
+
     // 获取各模块的实例
     OTAManager *getOTAManager();
     WiFiManager *getWiFiManager();
@@ -101,6 +135,18 @@ public:
     WebServerManager *getWebServerManager();
     SystemMonitor *getSystemMonitor();
     StatusIndicator *getStatusIndicator();
+    WiFiScanner *getWiFiScanner();
+    StaticAssetHandler *getStaticAssetHandler();
+    EmbeddedAssetHandler *getEmbeddedAssetHandler();
+    ApiRouter *getApiRouter();
+    BootProfiler *getBootProfiler();
+    WsEventRouter *getWsEventRouter();
+    WsOtaReceiver *getWsOtaReceiver();
+    WsCommandDispatcher *getWsCommandDispatcher();
+    FsSync *getFsSync();
+    MetricsSampler *getMetricsSampler();
+    PeerOtaMirror *getPeerOtaMirror();
+    PowerManager *getPowerManager();
 
 private:
     // 模块实例
@@ -110,6 +156,18 @@ private:
     WebServerManager *_webServer;
     SystemMonitor *_sysMonitor;
     StatusIndicator *_statusIndicator;
+    WiFiScanner *_wifiScanner;
+    StaticAssetHandler *_staticAssets;
+    EmbeddedAssetHandler *_embeddedAssets;
+    ApiRouter *_apiRouter;
+    BootProfiler *_bootProfiler;
+    WsEventRouter *_wsRouter;
+    WsOtaReceiver *_wsOta;
+    WsCommandDispatcher *_wsCommands;
+    FsSync *_fsSync;
+    MetricsSampler *_metrics;
+    PeerOtaMirror *_peerOta;
+    PowerManager *_power;
 
     // 配置参数
     String _deviceName;
@@ -121,6 +179,7 @@ private:
     // 标志
     bool _apiMonitoring;
     unsigned long _lastApiStatsUpdate;
+    bool _webHandlersAttached;
 };
 
 #endif // ESP32_OTA_WS_LIB_H
\ No newline at end of file
@@ -0,0 +1,125 @@
+/**
+ * EmbeddedAssetHandler.cpp
+ *
+ * 编译期嵌入的Web界面处理模块的实现
+ *
+ * @file EmbeddedAssetHandler.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "EmbeddedAssetHandler.h"
+
+/**
+ * 构造函数
+ */
+EmbeddedAssetHandler::EmbeddedAssetHandler(const EmbeddedAsset *assets, size_t count, const char *cacheControl) : _assets(assets),
+                                                                                                                 _count(count),
+                                                                                                                 _cacheControl(cacheControl)
+{
+}
+
+/**
+ * 查找资源
+ */
+const EmbeddedAsset *EmbeddedAssetHandler::find(const String &uri) const
+{
+    // 路由表按uri升序排列
+    size_t low = 0;
+    size_t high = _count;
+    while (low < high)
+    {
+        size_t mid = (low + high) / 2;
+        int cmp = strcmp(uri.c_str(), _assets[mid].uri);
+        if (cmp == 0)
+        {
+            return &_assets[mid];
+        }
+        if (cmp < 0)
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * 获取资源数量
+ */
+size_t EmbeddedAssetHandler::getAssetCount() const
+{
+    return _count;
+}
+
+/**
+ * 判断请求是否由本处理器处理
+ */
+bool EmbeddedAssetHandler::canHandle(AsyncWebServerRequest *request)
+{
+    if (request->method() != HTTP_GET && request->method() != HTTP_HEAD)
+    {
+        return false;
+    }
+
+    if (!find(request->url()))
+    {
+        return false;
+    }
+
+    request->addInterestingHeader("If-None-Match");
+    request->addInterestingHeader("Accept-Encoding");
+    return true;
+}
+
+/**
+ * 处理嵌入资源请求
+ */
+void EmbeddedAssetHandler::handleRequest(AsyncWebServerRequest *request)
+{
+    const EmbeddedAsset *asset = find(request->url());
+    if (!asset)
+    {
+        request->send(404);
+        return;
+    }
+
+    // 只嵌入了压缩后的内容
+    if (asset->gzip && !(request->hasHeader("Accept-Encoding") &&
+                         request->header("Accept-Encoding").indexOf("gzip") >= 0))
+    {
+        request->send(406, "text/plain", "gzip encoding required");
+        return;
+    }
+
+    AsyncWebServerResponse *response;
+    bool notModified = request->hasHeader("If-None-Match") &&
+                       request->header("If-None-Match") == asset->etag;
+
+    if (notModified)
+    {
+        response = request->beginResponse(304);
+    }
+    else
+    {
+        // 直接从Flash读取发送，不复制到RAM
+        response = request->beginResponse_P(200, asset->contentType, asset->data, asset->length);
+        if (asset->gzip)
+        {
+            response->addHeader("Content-Encoding", "gzip");
+        }
+    }
+
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", _cacheControl);
+    if (asset->gzip)
+    {
+        // 响应取决于Accept-Encoding，共享缓存不能把它发给不支持gzip的客户端
+        response->addHeader("Vary", "Accept-Encoding");
+    }
+    request->send(response);
+}
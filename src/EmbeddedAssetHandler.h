@@ -0,0 +1,86 @@
+/**
+ * EmbeddedAssetHandler.h
+ *
+ * 编译期嵌入的Web界面处理模块，直接从Flash发送预压缩资源，无需挂载文件系统
+ *
+ * 资源表由 tools/embed_web_ui.py 根据 data/ 目录生成到 EmbeddedWebUIData.h，
+ * 头文件需要位于本目录或包含路径中
+ *
+ * @file EmbeddedAssetHandler.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef EMBEDDED_ASSET_HANDLER_H
+#define EMBEDDED_ASSET_HANDLER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// 嵌入的资源，由生成器输出为constexpr路由表
+struct EmbeddedAsset
+{
+    const char *uri;         // 请求路径
+    const char *contentType; // 内容类型
+    const char *etag;        // 预先计算的强ETag（含引号）
+    const uint8_t *data;     // Flash中的资源内容
+    uint32_t length;         // 内容长度
+    bool gzip;               // 内容是否为gzip压缩
+};
+
+// 生成的资源表存在时自动启用
+#if defined(__has_include)
+#if __has_include("EmbeddedWebUIData.h")
+#include "EmbeddedWebUIData.h"
+#endif
+#endif
+
+#ifndef EMBEDDED_WEB_UI_AVAILABLE
+#define EMBEDDED_WEB_UI_AVAILABLE 0
+#endif
+
+/**
+ * 嵌入资源处理器类
+ *
+ * 在按路径排序的静态路由表中二分查找，资源从Flash零拷贝发送，
+ * 不占用文件句柄和RAM缓存。设备上不解压，压缩资源只发送给支持gzip的客户端，
+ * 其他客户端收到406
+ */
+class EmbeddedAssetHandler : public AsyncWebHandler
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param assets 按uri升序排列的资源表
+     * @param count 资源数量
+     * @param cacheControl Cache-Control的值
+     */
+    EmbeddedAssetHandler(const EmbeddedAsset *assets, size_t count, const char *cacheControl = "no-cache");
+
+    /**
+     * 查找资源
+     *
+     * @param uri 请求路径
+     * @return 资源，不存在时返回nullptr
+     */
+    const EmbeddedAsset *find(const String &uri) const;
+
+    /**
+     * 获取资源数量
+     *
+     * @return 资源数量
+     */
+    size_t getAssetCount() const;
+
+    bool canHandle(AsyncWebServerRequest *request) override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+
+private:
+    const EmbeddedAsset *_assets; // 资源表
+    size_t _count;                // 资源数量
+    const char *_cacheControl;    // Cache-Control的值
+};
+
+#endif // EMBEDDED_ASSET_HANDLER_H
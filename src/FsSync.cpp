@@ -0,0 +1,597 @@
+/**
+ * FsSync.cpp
+ *
+ * 文件级增量同步模块的实现
+ *
+ * @file FsSync.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "FsSync.h"
+#include "JsonResponseWriter.h"
+#include "BinaryLog.h"
+
+/**
+ * 构造函数
+ */
+FsSync::FsSync(fs::FS &fs) : _fs(fs),
+                             _manifestValid(false),
+                             _manifestTruncated(false),
+                             _rebuildRequested(true),
+                             _buildReady(false),
+                             _pendingIndex(0),
+                             _buildActive(false),
+                             _firstBuild(true),
+                             _buildTruncated(false),
+                             _owner(nullptr),
+                             _fileFailed(false),
+                             _written(0),
+                             _errorCount(0)
+{
+}
+
+/**
+ * 注册HTTP路由
+ */
+void FsSync::attach(AsyncWebServer &server)
+{
+    server.on("/api/fs/manifest", HTTP_GET, [this](AsyncWebServerRequest *request)
+              {
+                  if (_buildReady)
+                  {
+                      publishManifest();
+                  }
+
+                  // 计算MD5需要读取所有文件，不在Web服务器任务中进行
+                  if (!_manifestValid)
+                  {
+                      AsyncWebServerResponse *response = request->beginResponse(
+                          503, "application/json", "{\"error\":\"manifest_building\"}");
+                      response->addHeader("Retry-After", FS_SYNC_RETRY_AFTER);
+                      request->send(response);
+                      return;
+                  }
+
+                  // 清单不完整时工具无法判断哪些文件需要上传或删除，必须告知
+                  request->send(JsonResponseWriter::beginArray(
+                      request, "{\"type\":\"fs_manifest\",\"files\":[",
+                      _manifestTruncated ? "],\"truncated\":true}" : "]}",
+                      [this](size_t index, JsonDocument &fileDoc)
+                      {
+                          if (index >= _manifest.size())
+                          {
+                              return false;
+                          }
+                          fileDoc["path"] = _manifest[index].path.c_str();
+                          fileDoc["size"] = _manifest[index].size;
+                          fileDoc["md5"] = (const char *)_manifest[index].md5;
+                          return true;
+                      })); });
+
+    server.on(
+        "/api/fs/sync", HTTP_POST,
+        [this](AsyncWebServerRequest *request)
+        { handleSyncRequest(request); },
+        [this](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
+        { handleUpload(request, filename, index, data, len, final); });
+}
+
+/**
+ * 分批计算清单
+ */
+void FsSync::handle()
+{
+    if (_buildReady)
+    {
+        // 等待Web服务器任务取用上一次的结果
+        return;
+    }
+
+    if (_rebuildRequested)
+    {
+        _rebuildRequested = false;
+        startBuild();
+    }
+
+    if (_buildActive)
+    {
+        continueBuild();
+    }
+}
+
+/**
+ * 是否正在计算清单
+ */
+bool FsSync::isBuildingManifest() const
+{
+    // 等待取用时主循环没有需要做的工作
+    return !_buildReady && (_buildActive || _rebuildRequested);
+}
+
+/**
+ * 是否有同步请求正在上传文件
+ */
+bool FsSync::isBusy() const
+{
+    return _owner != nullptr;
+}
+
+/**
+ * 设置同步完成回调
+ */
+void FsSync::onSynced(std::function<void()> callback)
+{
+    _syncedCallback = callback;
+}
+
+/**
+ * 清空清单缓存
+ */
+void FsSync::invalidateManifest()
+{
+    _manifestValid = false;
+    _rebuildRequested = true;
+}
+
+/**
+ * 处理上传数据
+ */
+void FsSync::handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
+{
+    if (_owner && _owner != request)
+    {
+        // 同一时间只允许一个同步请求
+        return;
+    }
+
+    if (!_owner)
+    {
+        _owner = request;
+        _written = 0;
+        _errors = "";
+        _errorCount = 0;
+
+        // 客户端中断时清理临时文件
+        request->onDisconnect([this, request]()
+                              {
+                                  if (_owner == request)
+                                  {
+                                      resetSession();
+                                  }
+                              });
+    }
+
+    if (!index)
+    {
+        // 上一个文件未收到final时放弃它
+        if (_tempFile)
+        {
+            _tempFile.close();
+            _fs.remove(_targetPath + FS_SYNC_TEMP_SUFFIX);
+        }
+
+        _targetPath = filename;
+        _fileFailed = false;
+        _md5.begin();
+
+        if (!isValidPath(_targetPath))
+        {
+            addError(_targetPath, "invalid_path");
+            _fileFailed = true;
+        }
+        else
+        {
+            ensureParentDirs(_targetPath);
+            _tempFile = _fs.open(_targetPath + FS_SYNC_TEMP_SUFFIX, "w");
+            if (!_tempFile)
+            {
+                addError(_targetPath, "open_failed");
+                _fileFailed = true;
+            }
+        }
+    }
+
+    if (!_fileFailed && len)
+    {
+        if (_tempFile.write(data, len) != len)
+        {
+            addError(_targetPath, "write_failed");
+            _fileFailed = true;
+            _tempFile.close();
+            _fs.remove(_targetPath + FS_SYNC_TEMP_SUFFIX);
+        }
+        else
+        {
+            _md5.add(data, len);
+        }
+    }
+
+    if (final)
+    {
+        finishFile(request);
+    }
+}
+
+/**
+ * 完成当前文件：校验并重命名
+ */
+void FsSync::finishFile(AsyncWebServerRequest *request)
+{
+    if (_fileFailed)
+    {
+        return;
+    }
+
+    size_t size = _tempFile.size();
+    _tempFile.close();
+    _md5.calculate();
+    String md5 = _md5.toString();
+    String tempPath = _targetPath + FS_SYNC_TEMP_SUFFIX;
+
+    // 校验客户端提供的MD5
+    String field = "md5:" + _targetPath;
+    if (request->hasParam(field, true) && !request->getParam(field, true)->value().equalsIgnoreCase(md5))
+    {
+        _fs.remove(tempPath);
+        addError(_targetPath, "md5_mismatch");
+        return;
+    }
+
+    // 重命名是原子的，读取方只会看到旧文件或完整的新文件
+    if (!_fs.rename(tempPath, _targetPath))
+    {
+        _fs.remove(_targetPath);
+        if (!_fs.rename(tempPath, _targetPath))
+        {
+            _fs.remove(tempPath);
+            addError(_targetPath, "rename_failed");
+            return;
+        }
+    }
+
+    _written++;
+    updateManifestEntry(_targetPath, size, md5.c_str());
+}
+
+/**
+ * 处理同步请求完成
+ */
+void FsSync::handleSyncRequest(AsyncWebServerRequest *request)
+{
+    if (_owner && _owner != request)
+    {
+        request->send(409, "application/json", "{\"error\":\"sync_in_progress\"}");
+        return;
+    }
+
+    if (!_owner)
+    {
+        // 只有删除操作的请求
+        _written = 0;
+        _errors = "";
+        _errorCount = 0;
+    }
+
+    uint16_t deleted = 0;
+    size_t params = request->params();
+    for (size_t i = 0; i < params; i++)
+    {
+        const AsyncWebParameter *param = request->getParam(i);
+        if (!param->isPost() || param->isFile() || param->name() != "delete")
+        {
+            continue;
+        }
+
+        const String &path = param->value();
+        if (!isValidPath(path))
+        {
+            addError(path, "invalid_path");
+        }
+        else if (_fs.exists(path) && !_fs.remove(path))
+        {
+            addError(path, "delete_failed");
+        }
+        else
+        {
+            deleted++;
+            removeManifestEntry(path);
+        }
+    }
+
+    BLOG("文件同步完成: 写入 %u 个文件, 删除 %u 个, 错误 %u 个\n", _written, deleted, _errorCount);
+
+    if ((_written || deleted) && _syncedCallback)
+    {
+        _syncedCallback();
+    }
+
+    String result;
+    result.reserve(96 + _errors.length());
+    result = "{\"type\":\"fs_sync\",\"written\":";
+    result += _written;
+    result += ",\"deleted\":";
+    result += deleted;
+    result += ",\"errors\":[";
+    result += _errors;
+    result += "]}";
+    request->send(_errorCount ? 207 : 200, "application/json", result);
+
+    resetSession();
+}
+
+/**
+ * 记录错误
+ */
+void FsSync::addError(const String &path, const char *reason)
+{
+    if (_errorCount++ >= FS_SYNC_MAX_ERRORS)
+    {
+        return;
+    }
+
+    StaticJsonDocument<64> errorDoc;
+    errorDoc["path"] = path.c_str();
+    errorDoc["error"] = reason;
+
+    if (_errors.length())
+    {
+        _errors += ',';
+    }
+    serializeJson(errorDoc, _errors);
+}
+
+/**
+ * 清理当前请求的状态
+ */
+void FsSync::resetSession()
+{
+    if (_tempFile)
+    {
+        _tempFile.close();
+        _fs.remove(_targetPath + FS_SYNC_TEMP_SUFFIX);
+    }
+    _owner = nullptr;
+    _targetPath = "";
+    _errors = String();
+}
+
+/**
+ * 检查路径是否可以同步
+ */
+bool FsSync::isValidPath(const String &path)
+{
+    return path.startsWith("/") && path.length() > 1 && !path.endsWith("/") &&
+           path.indexOf("..") < 0 && !path.endsWith(FS_SYNC_TEMP_SUFFIX);
+}
+
+/**
+ * 创建文件所在的目录
+ */
+void FsSync::ensureParentDirs(const String &path)
+{
+    int slash = path.indexOf('/', 1);
+    while (slash > 0)
+    {
+        String dir = path.substring(0, slash);
+        if (!_fs.exists(dir))
+        {
+            _fs.mkdir(dir);
+        }
+        slash = path.indexOf('/', slash + 1);
+    }
+}
+
+/**
+ * 列出所有文件，开始计算清单
+ */
+void FsSync::startBuild()
+{
+    if (_hashFile)
+    {
+        _hashFile.close();
+    }
+    _building.clear();
+    _pendingPaths.clear();
+    _pendingIndex = 0;
+    _buildTruncated = false;
+
+    scanDirectory("/");
+    if (_buildTruncated)
+    {
+        BLOG("文件数量超过 %u, 清单不完整\n", (unsigned)FS_SYNC_MAX_FILES);
+    }
+    _firstBuild = false;
+    _buildActive = true;
+}
+
+void FsSync::scanDirectory(const String &dir)
+{
+#if defined(ESP8266)
+    Dir entries = _fs.openDir(dir);
+    while (entries.next())
+    {
+        String path = dir + (dir.endsWith("/") ? "" : "/") + entries.fileName();
+        if (entries.isDirectory())
+        {
+            scanDirectory(path);
+        }
+        else if (path.endsWith(FS_SYNC_TEMP_SUFFIX))
+        {
+            // 上次运行中断的上传留下的临时文件，此后的临时文件可能属于进行中的上传
+            if (_firstBuild)
+            {
+                _fs.remove(path);
+            }
+        }
+        else if (_pendingPaths.size() < FS_SYNC_MAX_FILES)
+        {
+            _pendingPaths.push_back(path);
+        }
+        else
+        {
+            _buildTruncated = true;
+        }
+    }
+#else
+    File root = _fs.open(dir);
+    if (!root || !root.isDirectory())
+    {
+        return;
+    }
+
+    File entry = root.openNextFile();
+    while (entry)
+    {
+        String path = entry.path();
+        bool isDirectory = entry.isDirectory();
+        entry.close();
+
+        if (isDirectory)
+        {
+            scanDirectory(path);
+        }
+        else if (path.endsWith(FS_SYNC_TEMP_SUFFIX))
+        {
+            // 上次运行中断的上传留下的临时文件，此后的临时文件可能属于进行中的上传
+            if (_firstBuild)
+            {
+                _fs.remove(path);
+            }
+        }
+        else if (_pendingPaths.size() < FS_SYNC_MAX_FILES)
+        {
+            _pendingPaths.push_back(path);
+        }
+        else
+        {
+            _buildTruncated = true;
+        }
+        entry = root.openNextFile();
+    }
+#endif
+}
+
+/**
+ * 计算一部分文件的MD5
+ */
+void FsSync::continueBuild()
+{
+    uint8_t chunk[256];
+    size_t budget = FS_SYNC_HASH_PER_LOOP;
+
+    while (budget)
+    {
+        if (!_hashFile)
+        {
+            if (_pendingIndex >= _pendingPaths.size())
+            {
+                _buildActive = false;
+                _pendingPaths.clear();
+                BLOG("文件清单计算完成: %u 个文件\n", (unsigned)_building.size());
+
+                // _building交给Web服务器任务，下次请求清单时取用
+                _buildReady = true;
+                return;
+            }
+
+            _hashFile = _fs.open(_pendingPaths[_pendingIndex], "r");
+            if (!_hashFile)
+            {
+                _pendingIndex++;
+                continue;
+            }
+            _hashMD5.begin();
+        }
+
+        size_t len = _hashFile.read(chunk, budget < sizeof(chunk) ? budget : sizeof(chunk));
+        if (len > 0)
+        {
+            _hashMD5.add(chunk, len);
+            budget -= len;
+            continue;
+        }
+
+        // 文件读取完毕
+        _hashMD5.calculate();
+
+        FsManifestEntry entry;
+        entry.path = _pendingPaths[_pendingIndex];
+        entry.size = _hashFile.size();
+        strlcpy(entry.md5, _hashMD5.toString().c_str(), sizeof(entry.md5));
+        _hashFile.close();
+
+        _building.push_back(entry);
+        _pendingIndex++;
+    }
+}
+
+/**
+ * 在Web服务器任务中取用计算完成的清单
+ */
+void FsSync::publishManifest()
+{
+    _manifest.swap(_building);
+    _building.clear();
+    _manifestTruncated = _buildTruncated;
+
+    // 计算期间文件被修改时结果已过期，主循环会重新计算
+    _manifestValid = !_rebuildRequested;
+    _buildReady = false;
+}
+
+/**
+ * 更新清单缓存中的一项
+ */
+void FsSync::updateManifestEntry(const String &path, size_t size, const char *md5)
+{
+    if (!_manifestValid)
+    {
+        // 正在计算的清单可能已读取了旧内容
+        _rebuildRequested = true;
+        return;
+    }
+
+    for (FsManifestEntry &entry : _manifest)
+    {
+        if (entry.path == path)
+        {
+            entry.size = size;
+            strlcpy(entry.md5, md5, sizeof(entry.md5));
+            return;
+        }
+    }
+
+    if (_manifest.size() < FS_SYNC_MAX_FILES)
+    {
+        FsManifestEntry entry;
+        entry.path = path;
+        entry.size = size;
+        strlcpy(entry.md5, md5, sizeof(entry.md5));
+        _manifest.push_back(entry);
+    }
+    else
+    {
+        // 超出容量时下次请求重新扫描
+        invalidateManifest();
+    }
+}
+
+void FsSync::removeManifestEntry(const String &path)
+{
+    if (!_manifestValid)
+    {
+        _rebuildRequested = true;
+        return;
+    }
+
+    for (size_t i = 0; i < _manifest.size(); i++)
+    {
+        if (_manifest[i].path == path)
+        {
+            _manifest.erase(_manifest.begin() + i);
+            return;
+        }
+    }
+}
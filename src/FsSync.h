@@ -0,0 +1,181 @@
+/**
+ * FsSync.h
+ *
+ * 文件级增量同步模块，只上传变化的文件，不重写整个文件系统分区
+ *
+ * GET  /api/fs/manifest  返回所有文件的路径、大小和MD5
+ * POST /api/fs/sync      multipart请求，文件部分的文件名为目标路径，可一次上传多个文件；
+ *                        字段 "md5:<路径>" 为对应文件的期望MD5（需在文件之前发送），
+ *                        字段 "delete" 为需要删除的路径（可以有多个）
+ *
+ * 清单在主循环中分批计算（启动时和文件被其他方式修改后），
+ * 计算完成前 /api/fs/manifest 返回503和Retry-After
+ *
+ * @file FsSync.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef FS_SYNC_H
+#define FS_SYNC_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+#include <MD5Builder.h>
+#include <functional>
+#include <vector>
+
+// 同步配置
+#define FS_SYNC_MAX_FILES 64       // 清单中最多记录的文件数量
+#define FS_SYNC_MAX_ERRORS 8       // 响应中最多报告的错误数量
+#define FS_SYNC_TEMP_SUFFIX ".tmp" // 上传中的临时文件后缀
+#define FS_SYNC_HASH_PER_LOOP 4096 // 每次handle()最多计算MD5的字节数
+#define FS_SYNC_RETRY_AFTER "1"    // 清单未就绪时建议客户端重试的间隔（秒）
+
+// 清单条目
+struct FsManifestEntry
+{
+    String path;  // 文件路径
+    size_t size;  // 文件大小
+    char md5[33]; // 内容MD5（十六进制）
+};
+
+/**
+ * 文件系统同步类
+ *
+ * 文件先写入临时文件，校验通过后重命名为目标文件，传输中断不会留下不完整的文件
+ */
+class FsSync
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param fs 文件系统
+     */
+    FsSync(fs::FS &fs);
+
+    /**
+     * 注册HTTP路由
+     *
+     * @param server 异步Web服务器
+     */
+    void attach(AsyncWebServer &server);
+
+    /**
+     * 分批计算清单，需要在loop()中调用
+     */
+    void handle();
+
+    /**
+     * 是否正在计算清单
+     */
+    bool isBuildingManifest() const;
+
+    /**
+     * 是否有同步请求正在上传文件
+     */
+    bool isBusy() const;
+
+    /**
+     * 设置同步完成回调，用于清空依赖文件内容的缓存
+     *
+     * @param callback 回调函数
+     */
+    void onSynced(std::function<void()> callback);
+
+    /**
+     * 清单缓存失效并在主循环中重新计算，文件系统被其他方式修改后调用
+     */
+    void invalidateManifest();
+
+private:
+    fs::FS &_fs;                            // 文件系统
+    std::vector<FsManifestEntry> _manifest; // 清单缓存（只在Web服务器任务中访问）
+    volatile bool _manifestValid;           // 清单缓存是否有效
+    bool _manifestTruncated;                // 文件数量超出FS_SYNC_MAX_FILES，清单不完整（只在Web服务器任务中访问）
+    volatile bool _rebuildRequested;        // 需要重新计算清单
+    volatile bool _buildReady;              // 新清单已计算完成，等待Web服务器任务取用
+    std::function<void()> _syncedCallback;  // 同步完成回调
+
+    // 清单计算状态，只在主循环中访问（_buildReady为true时_building交给Web服务器任务）
+    std::vector<FsManifestEntry> _building; // 计算中的清单
+    std::vector<String> _pendingPaths;      // 需要计算MD5的文件
+    size_t _pendingIndex;                   // 正在计算的文件序号
+    File _hashFile;                         // 正在计算的文件
+    MD5Builder _hashMD5;                    // 正在计算的MD5
+    bool _buildActive;                      // 是否正在计算
+    bool _firstBuild;                       // 是否为启动后第一次计算
+    bool _buildTruncated;                   // 计算中的清单是否不完整
+
+    // 当前同步请求的状态
+    AsyncWebServerRequest *_owner; // 正在同步的请求
+    File _tempFile;                // 正在写入的临时文件
+    String _targetPath;            // 正在写入的目标路径
+    MD5Builder _md5;               // 正在写入文件的MD5
+    bool _fileFailed;              // 当前文件是否已失败
+    uint16_t _written;             // 成功写入的文件数
+    String _errors;                // 错误列表（JSON数组元素）
+    uint8_t _errorCount;           // 错误数量
+
+    /**
+     * 处理上传数据
+     */
+    void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final);
+
+    /**
+     * 处理同步请求完成（删除文件并返回结果）
+     */
+    void handleSyncRequest(AsyncWebServerRequest *request);
+
+    /**
+     * 完成当前文件：校验并重命名
+     */
+    void finishFile(AsyncWebServerRequest *request);
+
+    /**
+     * 记录错误
+     */
+    void addError(const String &path, const char *reason);
+
+    /**
+     * 清理当前请求的状态
+     */
+    void resetSession();
+
+    /**
+     * 检查路径是否可以同步
+     */
+    static bool isValidPath(const String &path);
+
+    /**
+     * 创建文件所在的目录
+     */
+    void ensureParentDirs(const String &path);
+
+    /**
+     * 列出所有文件，开始计算清单
+     */
+    void startBuild();
+    void scanDirectory(const String &dir);
+
+    /**
+     * 计算一部分文件的MD5
+     */
+    void continueBuild();
+
+    /**
+     * 在Web服务器任务中取用计算完成的清单
+     */
+    void publishManifest();
+
+    /**
+     * 更新清单缓存中的一项
+     */
+    void updateManifestEntry(const String &path, size_t size, const char *md5);
+    void removeManifestEntry(const String &path);
+};
+
+#endif // FS_SYNC_H
@@ -0,0 +1,209 @@
+/**
+ * JsonResponseWriter.cpp
+ *
+ * 流式JSON响应模块的实现
+ *
+ * @file JsonResponseWriter.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "JsonResponseWriter.h"
+#include "BinaryLog.h"
+#include <memory>
+
+namespace
+{
+    // 数组输出阶段
+    enum ArrayStreamPhase
+    {
+        PHASE_PREFIX,
+        PHASE_ELEMENTS,
+        PHASE_SUFFIX,
+        PHASE_DONE
+    };
+
+    // 数组输出状态，由分块回调持有
+    struct ArrayStreamState
+    {
+        const char *prefix;                           // 数组之前的内容
+        const char *suffix;                           // 数组之后的内容
+        JsonArrayFiller filler;                       // 元素填充回调
+        ArrayStreamPhase phase;                       // 当前阶段
+        size_t index;                                 // 下一个元素的索引
+        size_t emitted;                               // 已输出的元素数量
+        const char *pending;                          // 待输出的数据
+        size_t pendingLen;                            // 待输出的长度
+        char element[JSON_STREAM_ELEMENT_BUFFER + 1]; // 当前元素（含前导逗号）
+    };
+
+    /**
+     * 准备下一段待输出的数据
+     *
+     * @return 是否还有数据
+     */
+    bool nextSegment(ArrayStreamState &state)
+    {
+        switch (state.phase)
+        {
+        case PHASE_PREFIX:
+            state.pending = state.prefix;
+            state.pendingLen = strlen(state.prefix);
+            state.phase = PHASE_ELEMENTS;
+            return true;
+
+        case PHASE_ELEMENTS:
+            while (true)
+            {
+                StaticJsonDocument<JSON_STREAM_ELEMENT_DOC_SIZE> elementDoc;
+                if (!state.filler(state.index, elementDoc))
+                {
+                    state.phase = PHASE_SUFFIX;
+                    return nextSegment(state);
+                }
+                size_t index = state.index++;
+
+                // 先计算长度，截断的元素会让整个响应变成无效的JSON，跳过它
+                size_t offset = state.emitted ? 1 : 0;
+                size_t len = measureJson(elementDoc);
+                if (elementDoc.overflowed() || offset + len > JSON_STREAM_ELEMENT_BUFFER)
+                {
+                    BLOG("JSON数组元素 %u 超出缓冲区 (%u 字节), 已跳过\n", (unsigned)index, (unsigned)len);
+                    continue;
+                }
+
+                if (offset)
+                {
+                    state.element[0] = ',';
+                }
+                serializeJson(elementDoc, state.element + offset, sizeof(state.element) - offset);
+
+                state.pending = state.element;
+                state.pendingLen = offset + len;
+                state.emitted++;
+                return true;
+            }
+
+        case PHASE_SUFFIX:
+            state.pending = state.suffix;
+            state.pendingLen = strlen(state.suffix);
+            state.phase = PHASE_DONE;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+}
+
+/**
+ * 构造函数
+ */
+ChunkWindowPrint::ChunkWindowPrint(uint8_t *buffer, size_t maxLen, size_t skip) : _buffer(buffer),
+                                                                                  _maxLen(maxLen),
+                                                                                  _skip(skip),
+                                                                                  _length(0)
+{
+}
+
+/**
+ * 写入单个字节
+ */
+size_t ChunkWindowPrint::write(uint8_t c)
+{
+    return write(&c, 1);
+}
+
+/**
+ * 写入数据，只保留窗口内的部分
+ */
+size_t ChunkWindowPrint::write(const uint8_t *data, size_t len)
+{
+    size_t consumed = len;
+
+    if (_skip)
+    {
+        size_t skipped = len < _skip ? len : _skip;
+        _skip -= skipped;
+        data += skipped;
+        len -= skipped;
+    }
+
+    size_t room = _maxLen - _length;
+    if (len > room)
+    {
+        len = room;
+    }
+    memcpy(_buffer + _length, data, len);
+    _length += len;
+
+    // 始终报告全部写入，避免序列化提前中止
+    return consumed;
+}
+
+/**
+ * 获取写入缓冲区的字节数
+ */
+size_t ChunkWindowPrint::length() const
+{
+    return _length;
+}
+
+/**
+ * 创建逐个元素输出的数组响应
+ */
+AsyncWebServerResponse *JsonResponseWriter::beginArray(AsyncWebServerRequest *request,
+                                                       const char *prefix,
+                                                       const char *suffix,
+                                                       JsonArrayFiller filler,
+                                                       const char *contentType)
+{
+    std::shared_ptr<ArrayStreamState> state(new ArrayStreamState());
+    state->prefix = prefix;
+    state->suffix = suffix;
+    state->filler = filler;
+    state->phase = PHASE_PREFIX;
+    state->index = 0;
+    state->emitted = 0;
+    state->pending = nullptr;
+    state->pendingLen = 0;
+
+    return request->beginChunkedResponse(
+        contentType,
+        [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+            size_t written = 0;
+            while (written < maxLen)
+            {
+                if (state->pendingLen == 0 && !nextSegment(*state))
+                {
+                    break;
+                }
+
+                size_t len = state->pendingLen < maxLen - written ? state->pendingLen : maxLen - written;
+                memcpy(buffer + written, state->pending, len);
+                state->pending += len;
+                state->pendingLen -= len;
+                written += len;
+            }
+            return written;
+        });
+}
+
+/**
+ * 创建分块输出的文档响应
+ */
+AsyncWebServerResponse *JsonResponseWriter::beginDocument(AsyncWebServerRequest *request,
+                                                          JsonContentWriter writer,
+                                                          const char *contentType)
+{
+    return request->beginChunkedResponse(
+        contentType,
+        [writer](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+            ChunkWindowPrint window(buffer, maxLen, index);
+            writer(window);
+            return window.length();
+        });
+}
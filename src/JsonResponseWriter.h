@@ -0,0 +1,108 @@
+/**
+ * JsonResponseWriter.h
+ *
+ * 流式JSON响应模块，通过固定大小的缓冲区以分块传输方式输出JSON
+ *
+ * @file JsonResponseWriter.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef JSON_RESPONSE_WRITER_H
+#define JSON_RESPONSE_WRITER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <functional>
+
+// 流式输出配置
+#define JSON_STREAM_ELEMENT_DOC_SIZE 384 // 单个数组元素的JsonDocument容量
+#define JSON_STREAM_ELEMENT_BUFFER 256   // 单个数组元素序列化后的最大长度，超出的元素被跳过
+
+/**
+ * 填充数组元素的回调
+ *
+ * @param index 元素索引
+ * @param element 需要填充的元素文档
+ * @return 是否产生了元素, 返回false表示数组结束
+ */
+typedef std::function<bool(size_t index, JsonDocument &element)> JsonArrayFiller;
+
+/**
+ * 将完整内容写入输出流的回调，可能被多次调用，每次输出必须相同
+ *
+ * @param out 输出流
+ */
+typedef std::function<void(Print &out)> JsonContentWriter;
+
+/**
+ * 输出窗口
+ *
+ * 丢弃前skip个字节，之后最多写入maxLen个字节，用于分块输出时定位到当前块
+ */
+class ChunkWindowPrint : public Print
+{
+public:
+    ChunkWindowPrint(uint8_t *buffer, size_t maxLen, size_t skip);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t len) override;
+
+    /**
+     * 获取写入缓冲区的字节数
+     *
+     * @return 字节数
+     */
+    size_t length() const;
+
+private:
+    uint8_t *_buffer;
+    size_t _maxLen;
+    size_t _skip;
+    size_t _length;
+};
+
+/**
+ * JSON响应写入器类
+ *
+ * 响应内容在发送时才逐块生成，峰值内存只取决于固定缓冲区，与响应总大小无关
+ */
+class JsonResponseWriter
+{
+public:
+    /**
+     * 创建逐个元素输出的数组响应
+     *
+     * 输出为 prefix + 元素1 + "," + 元素2 ... + suffix，每次只构建一个元素
+     *
+     * @param request 异步请求对象
+     * @param prefix 数组之前的内容, 例如 "{\"items\":["
+     * @param suffix 数组之后的内容, 例如 "]}"
+     * @param filler 填充元素的回调
+     * @param contentType 内容类型
+     * @return 分块响应对象
+     */
+    static AsyncWebServerResponse *beginArray(AsyncWebServerRequest *request,
+                                              const char *prefix,
+                                              const char *suffix,
+                                              JsonArrayFiller filler,
+                                              const char *contentType = "application/json");
+
+    /**
+     * 创建分块输出的文档响应
+     *
+     * 每个块都会重新执行writer并只保留当前块的窗口，不在内存中保存完整内容
+     *
+     * @param request 异步请求对象
+     * @param writer 输出完整内容的回调
+     * @param contentType 内容类型
+     * @return 分块响应对象
+     */
+    static AsyncWebServerResponse *beginDocument(AsyncWebServerRequest *request,
+                                                 JsonContentWriter writer,
+                                                 const char *contentType = "application/json");
+};
+
+#endif // JSON_RESPONSE_WRITER_H
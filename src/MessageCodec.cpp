@@ -0,0 +1,137 @@
+/**
+ * MessageCodec.cpp
+ *
+ * 消息编码模块的实现
+ *
+ * @file MessageCodec.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "MessageCodec.h"
+
+/**
+ * 按名称获取编码
+ */
+bool MessageCodec::parse(const char *name, MessageEncoding &encoding)
+{
+    if (!name)
+    {
+        return false;
+    }
+    if (strcmp(name, "msgpack") == 0)
+    {
+        encoding = MESSAGE_MSGPACK;
+        return true;
+    }
+    if (strcmp(name, "json") == 0)
+    {
+        encoding = MESSAGE_JSON;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * 获取编码名称
+ */
+const char *MessageCodec::name(MessageEncoding encoding)
+{
+    return encoding == MESSAGE_MSGPACK ? "msgpack" : "json";
+}
+
+/**
+ * 从WebSocket连接URL的查询参数中获取编码
+ */
+MessageEncoding MessageCodec::fromUrl(const char *url)
+{
+    const char *query = url ? strchr(url, '?') : nullptr;
+    if (!query)
+    {
+        return MESSAGE_JSON;
+    }
+
+    const char *param = strstr(query, "encoding=msgpack");
+    if (param && (param[-1] == '?' || param[-1] == '&'))
+    {
+        char next = param[strlen("encoding=msgpack")];
+        if (next == '\0' || next == '&')
+        {
+            return MESSAGE_MSGPACK;
+        }
+    }
+    return MESSAGE_JSON;
+}
+
+/**
+ * 从HTTP请求中获取编码
+ */
+MessageEncoding MessageCodec::fromRequest(AsyncWebServerRequest *request)
+{
+    MessageEncoding encoding = MESSAGE_JSON;
+    if (request->hasParam("encoding") && parse(request->getParam("encoding")->value().c_str(), encoding))
+    {
+        return encoding;
+    }
+
+    if (request->hasHeader("Accept"))
+    {
+        const String &accept = request->getHeader("Accept")->value();
+        if (accept.indexOf("application/msgpack") >= 0 || accept.indexOf("application/x-msgpack") >= 0)
+        {
+            return MESSAGE_MSGPACK;
+        }
+    }
+    return MESSAGE_JSON;
+}
+
+/**
+ * 获取编码对应的Content-Type
+ */
+const char *MessageCodec::contentType(MessageEncoding encoding)
+{
+    return encoding == MESSAGE_MSGPACK ? "application/msgpack" : "application/json";
+}
+
+/**
+ * 序列化文档
+ */
+size_t MessageCodec::serialize(const JsonDocument &doc, MessageEncoding encoding, Print &out)
+{
+    return encoding == MESSAGE_MSGPACK ? serializeMsgPack(doc, out) : serializeJson(doc, out);
+}
+
+/**
+ * 序列化文档到缓冲区
+ */
+size_t MessageCodec::serialize(const JsonDocument &doc, MessageEncoding encoding, uint8_t *buffer, size_t size)
+{
+    if (encoding == MESSAGE_MSGPACK)
+    {
+        return serializeMsgPack(doc, buffer, size);
+    }
+    return serializeJson(doc, (char *)buffer, size);
+}
+
+/**
+ * 计算序列化后的大小
+ */
+size_t MessageCodec::measure(const JsonDocument &doc, MessageEncoding encoding)
+{
+    return encoding == MESSAGE_MSGPACK ? measureMsgPack(doc) : measureJson(doc);
+}
+
+/**
+ * 按请求协商的编码发送文档
+ */
+void MessageCodec::send(AsyncWebServerRequest *request, const JsonDocument &doc, int code)
+{
+    MessageEncoding encoding = fromRequest(request);
+
+    AsyncResponseStream *response = request->beginResponseStream(contentType(encoding));
+    response->setCode(code);
+    response->addHeader("Vary", "Accept");
+    serialize(doc, encoding, *response);
+    request->send(response);
+}
@@ -0,0 +1,107 @@
+/**
+ * MessageCodec.h
+ *
+ * 消息编码模块，同一个JsonDocument按客户端协商的结果输出为JSON文本或MessagePack
+ *
+ * WebSocket: 连接URL带 ?encoding=msgpack，或发送命令 {"cmd":"set_encoding","encoding":"msgpack"}，
+ *            之后以文档形式发送的消息改为二进制帧（首字节为0x80-0x8F/0xDE/0xDF的映射），
+ *            其余消息仍为JSON文本帧
+ * HTTP:      请求头 Accept: application/msgpack，或查询参数 ?encoding=msgpack
+ *
+ * @file MessageCodec.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef MESSAGE_CODEC_H
+#define MESSAGE_CODEC_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+
+// 编码配置
+#define MESSAGE_CODEC_STACK_BUFFER 256 // 小于此大小的消息在栈上序列化
+
+// 消息编码
+enum MessageEncoding : uint8_t
+{
+    MESSAGE_JSON,   // JSON文本
+    MESSAGE_MSGPACK // MessagePack二进制
+};
+
+/**
+ * 消息编码类
+ */
+class MessageCodec
+{
+public:
+    /**
+     * 按名称获取编码
+     *
+     * @param name "json" 或 "msgpack"
+     * @param encoding 输出：编码
+     * @return 名称是否有效
+     */
+    static bool parse(const char *name, MessageEncoding &encoding);
+
+    /**
+     * 获取编码名称
+     */
+    static const char *name(MessageEncoding encoding);
+
+    /**
+     * 从WebSocket连接URL的查询参数中获取编码
+     *
+     * @param url 连接URL，例如 "/?encoding=msgpack"
+     * @return 编码，未指定时为JSON
+     */
+    static MessageEncoding fromUrl(const char *url);
+
+    /**
+     * 从HTTP请求中获取编码（查询参数优先于Accept请求头）
+     *
+     * @param request 异步请求对象
+     * @return 编码
+     */
+    static MessageEncoding fromRequest(AsyncWebServerRequest *request);
+
+    /**
+     * 获取编码对应的Content-Type
+     */
+    static const char *contentType(MessageEncoding encoding);
+
+    /**
+     * 序列化文档
+     *
+     * @param doc 文档
+     * @param encoding 编码
+     * @param out 输出流
+     * @return 写入的字节数
+     */
+    static size_t serialize(const JsonDocument &doc, MessageEncoding encoding, Print &out);
+
+    /**
+     * 序列化文档到缓冲区
+     *
+     * @return 写入的字节数（JSON不含结尾的'\0'）
+     */
+    static size_t serialize(const JsonDocument &doc, MessageEncoding encoding, uint8_t *buffer, size_t size);
+
+    /**
+     * 计算序列化后的大小
+     */
+    static size_t measure(const JsonDocument &doc, MessageEncoding encoding);
+
+    /**
+     * 按请求协商的编码发送文档
+     *
+     * @param request 异步请求对象
+     * @param doc 文档
+     * @param code HTTP状态码
+     */
+    static void send(AsyncWebServerRequest *request, const JsonDocument &doc, int code = 200);
+};
+
+#endif // MESSAGE_CODEC_H
@@ -0,0 +1,343 @@
+/**
+ * MetricsRegistry.cpp
+ *
+ * 指标注册表的实现
+ *
+ * @file MetricsRegistry.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "MetricsRegistry.h"
+#include <memory>
+
+// 常量初始化，早于任何静态指标对象的构造
+Metric *MetricsRegistry::_first = nullptr;
+Metric *MetricsRegistry::_last = nullptr;
+
+namespace
+{
+    // 当前行的类型
+    enum MetricsStreamLine
+    {
+        LINE_HELP,
+        LINE_TYPE,
+        LINE_SAMPLE
+    };
+
+    // 输出状态，由分块回调持有
+    struct MetricsStreamState
+    {
+        Metric *metric;                 // 正在输出的指标
+        const char *family;             // 上一个指标的名称
+        MetricsStreamLine line;         // 正在输出的行类型
+        uint8_t sample;                 // 下一个样本行序号
+        bool openMetrics;               // 是否输出OpenMetrics格式
+        bool finished;                  // 是否已输出结尾
+        const char *pending;            // 待输出的数据
+        size_t pendingLen;              // 待输出的长度
+        char text[METRICS_LINE_BUFFER]; // 当前行
+    };
+
+    const char *typeName(MetricType type)
+    {
+        switch (type)
+        {
+        case METRIC_COUNTER:
+            return "counter";
+        case METRIC_GAUGE:
+            return "gauge";
+        default:
+            return "histogram";
+        }
+    }
+
+    /**
+     * 准备下一行待输出的数据
+     *
+     * @return 是否还有数据
+     */
+    bool nextLine(MetricsStreamState &state)
+    {
+        while (state.metric)
+        {
+            Metric *metric = state.metric;
+            size_t len = 0;
+
+            switch (state.line)
+            {
+            case LINE_HELP:
+                state.line = LINE_TYPE;
+                // 与上一个指标同名时共享HELP/TYPE行
+                if (!state.family || strcmp(state.family, metric->getName()) != 0)
+                {
+                    // Prometheus 0.0.4的计数器族名包含_total，OpenMetrics不包含
+                    bool total = !state.openMetrics && metric->getType() == METRIC_COUNTER;
+                    len = snprintf(state.text, sizeof(state.text), "# HELP %s%s %s\n",
+                                   metric->getName(), total ? "_total" : "", metric->getHelp());
+                }
+                else
+                {
+                    state.line = LINE_SAMPLE;
+                }
+                break;
+
+            case LINE_TYPE:
+            {
+                bool total = !state.openMetrics && metric->getType() == METRIC_COUNTER;
+                len = snprintf(state.text, sizeof(state.text), "# TYPE %s%s %s\n",
+                               metric->getName(), total ? "_total" : "", typeName(metric->getType()));
+                state.line = LINE_SAMPLE;
+                break;
+            }
+
+            case LINE_SAMPLE:
+                len = metric->formatSample(state.sample++, state.text, sizeof(state.text));
+                if (!len)
+                {
+                    state.family = metric->getName();
+                    state.metric = metric->getNext();
+                    state.line = LINE_HELP;
+                    state.sample = 0;
+                }
+                break;
+            }
+
+            if (len)
+            {
+                if (len >= sizeof(state.text))
+                {
+                    // 截断的行仍以换行结束，避免破坏后续行
+                    len = sizeof(state.text) - 1;
+                    state.text[len - 1] = '\n';
+                }
+                state.pending = state.text;
+                state.pendingLen = len;
+                return true;
+            }
+        }
+
+        if (!state.finished)
+        {
+            state.finished = true;
+            if (state.openMetrics)
+            {
+                state.pending = "# EOF\n";
+                state.pendingLen = 6;
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+/**
+ * 构造函数
+ */
+Metric::Metric(const char *name, const char *help, const char *labels) : _name(name),
+                                                                         _help(help),
+                                                                         _labels(labels),
+                                                                         _next(nullptr)
+{
+    MetricsRegistry::add(this);
+}
+
+/**
+ * 格式化一行 "名称后缀{标签} 值"
+ */
+size_t Metric::formatLine(char *buffer, size_t size, const char *suffix, const char *extraLabel, const char *value) const
+{
+    bool hasLabels = _labels && _labels[0];
+    bool hasExtra = extraLabel && extraLabel[0];
+
+    if (!hasLabels && !hasExtra)
+    {
+        return snprintf(buffer, size, "%s%s %s\n", _name, suffix, value);
+    }
+    return snprintf(buffer, size, "%s%s{%s%s%s} %s\n", _name, suffix,
+                    hasLabels ? _labels : "", hasLabels && hasExtra ? "," : "", hasExtra ? extraLabel : "", value);
+}
+
+/**
+ * 计数器
+ */
+MetricCounter::MetricCounter(const char *name, const char *help, const char *labels) : Metric(name, help, labels)
+{
+}
+
+size_t MetricCounter::formatSample(uint8_t index, char *buffer, size_t size) const
+{
+    if (index > 0)
+    {
+        return 0;
+    }
+
+    char value[12];
+    snprintf(value, sizeof(value), "%lu", (unsigned long)_value.get());
+    return formatLine(buffer, size, "_total", nullptr, value);
+}
+
+/**
+ * 仪表
+ */
+MetricGauge::MetricGauge(const char *name, const char *help, const char *labels) : Metric(name, help, labels),
+                                                                                   _reader(nullptr)
+{
+}
+
+MetricGauge::MetricGauge(const char *name, const char *help, MetricGaugeReader reader, const char *labels) : Metric(name, help, labels),
+                                                                                                             _reader(reader)
+{
+}
+
+int32_t MetricGauge::get() const
+{
+    return _reader ? _reader() : (int32_t)_value.get();
+}
+
+size_t MetricGauge::formatSample(uint8_t index, char *buffer, size_t size) const
+{
+    if (index > 0)
+    {
+        return 0;
+    }
+
+    char value[12];
+    snprintf(value, sizeof(value), "%ld", (long)get());
+    return formatLine(buffer, size, "", nullptr, value);
+}
+
+/**
+ * 直方图
+ */
+MetricHistogram::MetricHistogram(const char *name, const char *help, const uint32_t *bounds, uint8_t bucketCount, const char *labels)
+    : Metric(name, help, labels),
+      _bounds(bounds),
+      _bucketCount(bucketCount > METRICS_HISTOGRAM_MAX_BUCKETS ? METRICS_HISTOGRAM_MAX_BUCKETS : bucketCount)
+{
+}
+
+/**
+ * 记录一个观测值
+ */
+void MetricHistogram::observe(uint32_t value)
+{
+    uint8_t bucket = 0;
+    while (bucket < _bucketCount && value > _bounds[bucket])
+    {
+        bucket++;
+    }
+
+    _buckets[bucket].add();
+    _sum.add(value);
+    _count.add();
+}
+
+size_t MetricHistogram::formatSample(uint8_t index, char *buffer, size_t size) const
+{
+    char value[12];
+    char le[24];
+
+    // 0.._bucketCount: 累计桶（最后一个为+Inf），然后是_sum和_count
+    if (index <= _bucketCount)
+    {
+        uint32_t cumulative = 0;
+        for (uint8_t i = 0; i <= index; i++)
+        {
+            cumulative += _buckets[i].get();
+        }
+
+        if (index < _bucketCount)
+        {
+            snprintf(le, sizeof(le), "le=\"%lu\"", (unsigned long)_bounds[index]);
+        }
+        else
+        {
+            strcpy(le, "le=\"+Inf\"");
+        }
+        snprintf(value, sizeof(value), "%lu", (unsigned long)cumulative);
+        return formatLine(buffer, size, "_bucket", le, value);
+    }
+
+    if (index == _bucketCount + 1)
+    {
+        snprintf(value, sizeof(value), "%lu", (unsigned long)_sum.get());
+        return formatLine(buffer, size, "_sum", nullptr, value);
+    }
+
+    if (index == _bucketCount + 2)
+    {
+        snprintf(value, sizeof(value), "%lu", (unsigned long)_count.get());
+        return formatLine(buffer, size, "_count", nullptr, value);
+    }
+
+    return 0;
+}
+
+/**
+ * 获取第一个注册的指标
+ */
+Metric *MetricsRegistry::first()
+{
+    return _first;
+}
+
+/**
+ * 追加指标到链表末尾，保持声明顺序
+ */
+void MetricsRegistry::add(Metric *metric)
+{
+    if (_last)
+    {
+        _last->_next = metric;
+    }
+    else
+    {
+        _first = metric;
+    }
+    _last = metric;
+}
+
+/**
+ * 创建 /metrics 响应
+ */
+AsyncWebServerResponse *MetricsRegistry::beginResponse(AsyncWebServerRequest *request)
+{
+    std::shared_ptr<MetricsStreamState> state(new MetricsStreamState());
+    state->metric = _first;
+    state->family = nullptr;
+    state->line = LINE_HELP;
+    state->sample = 0;
+    state->finished = false;
+    state->pending = nullptr;
+    state->pendingLen = 0;
+
+    state->openMetrics = false;
+    if (request->hasHeader("Accept"))
+    {
+        state->openMetrics = request->getHeader("Accept")->value().indexOf("application/openmetrics-text") >= 0;
+    }
+
+    return request->beginChunkedResponse(
+        state->openMetrics ? "application/openmetrics-text; version=1.0.0; charset=utf-8"
+                           : "text/plain; version=0.0.4; charset=utf-8",
+        [state](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+        {
+            size_t written = 0;
+            while (written < maxLen)
+            {
+                if (state->pendingLen == 0 && !nextLine(*state))
+                {
+                    break;
+                }
+
+                size_t len = state->pendingLen < maxLen - written ? state->pendingLen : maxLen - written;
+                memcpy(buffer + written, state->pending, len);
+                state->pending += len;
+                state->pendingLen -= len;
+                written += len;
+            }
+            return written;
+        });
+}
@@ -0,0 +1,210 @@
+/**
+ * MetricsRegistry.h
+ *
+ * 指标注册表，计数器、仪表和直方图以静态对象声明并在构造时自动注册，
+ * 通过 GET /metrics 以Prometheus/OpenMetrics文本格式逐行流式输出
+ *
+ * @file MetricsRegistry.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include "AtomicCounter.h"
+
+// 注册表配置
+#define METRICS_LINE_BUFFER 160          // 单行输出缓冲区大小
+#define METRICS_HISTOGRAM_MAX_BUCKETS 10 // 直方图最多的桶数量（不含+Inf）
+
+// 指标类型
+enum MetricType
+{
+    METRIC_COUNTER,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+};
+
+/**
+ * 指标基类
+ *
+ * 对象必须具有静态生存期，构造时追加到全局链表，不分配内存。
+ * 同名不同标签的指标需要连续声明，输出时共享HELP/TYPE行
+ */
+class Metric
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param name 指标名称（字符串常量）
+     * @param help 说明（字符串常量）
+     * @param labels 固定标签，例如 "result=\"ok\""，可为nullptr
+     */
+    Metric(const char *name, const char *help, const char *labels);
+
+    const char *getName() const { return _name; }
+    const char *getHelp() const { return _help; }
+    const char *getLabels() const { return _labels; }
+    Metric *getNext() const { return _next; }
+
+    /**
+     * 获取指标类型
+     */
+    virtual MetricType getType() const = 0;
+
+    /**
+     * 格式化第index个样本行（不含HELP/TYPE）
+     *
+     * @param index 样本行序号
+     * @param buffer 输出缓冲区
+     * @param size 缓冲区大小
+     * @return 写入的长度，0表示没有更多样本行
+     */
+    virtual size_t formatSample(uint8_t index, char *buffer, size_t size) const = 0;
+
+protected:
+    /**
+     * 格式化一行 "名称后缀{标签} 值"
+     */
+    size_t formatLine(char *buffer, size_t size, const char *suffix, const char *extraLabel, const char *value) const;
+
+private:
+    friend class MetricsRegistry;
+
+    const char *_name;   // 指标名称
+    const char *_help;   // 说明
+    const char *_labels; // 固定标签
+    Metric *_next;       // 链表中的下一个指标
+
+    Metric(const Metric &) = delete;
+    Metric &operator=(const Metric &) = delete;
+};
+
+/**
+ * 单调递增计数器，输出时名称追加 "_total"
+ */
+class MetricCounter : public Metric
+{
+public:
+    MetricCounter(const char *name, const char *help, const char *labels = nullptr);
+
+    /**
+     * 增加计数
+     *
+     * @param delta 增量
+     */
+    inline void inc(uint32_t delta = 1) { _value.add(delta); }
+
+    inline uint32_t get() const { return _value.get(); }
+
+    MetricType getType() const override { return METRIC_COUNTER; }
+    size_t formatSample(uint8_t index, char *buffer, size_t size) const override;
+
+private:
+    AtomicCounter _value; // 计数值
+};
+
+// 仪表读取函数，在输出时调用
+typedef int32_t (*MetricGaugeReader)();
+
+/**
+ * 仪表，保存一个有符号数值，或在输出时通过读取函数获取
+ */
+class MetricGauge : public Metric
+{
+public:
+    MetricGauge(const char *name, const char *help, const char *labels = nullptr);
+
+    /**
+     * 构造由读取函数提供数值的仪表
+     *
+     * @param reader 读取函数
+     */
+    MetricGauge(const char *name, const char *help, MetricGaugeReader reader, const char *labels = nullptr);
+
+    inline void set(int32_t value) { _value.set((uint32_t)value); }
+    inline void add(int32_t delta) { _value.add((uint32_t)delta); }
+    inline void updateMax(uint32_t value) { _value.updateMax(value); }
+
+    int32_t get() const;
+
+    MetricType getType() const override { return METRIC_GAUGE; }
+    size_t formatSample(uint8_t index, char *buffer, size_t size) const override;
+
+private:
+    AtomicCounter _value;      // 保存的数值（按补码存放）
+    MetricGaugeReader _reader; // 读取函数
+};
+
+/**
+ * 直方图，桶上界在声明时固定
+ */
+class MetricHistogram : public Metric
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param bounds 递增的桶上界数组（静态存储）
+     * @param bucketCount 桶数量，最多METRICS_HISTOGRAM_MAX_BUCKETS
+     */
+    MetricHistogram(const char *name, const char *help, const uint32_t *bounds, uint8_t bucketCount, const char *labels = nullptr);
+
+    /**
+     * 记录一个观测值
+     *
+     * @param value 观测值
+     */
+    void observe(uint32_t value);
+
+    MetricType getType() const override { return METRIC_HISTOGRAM; }
+    size_t formatSample(uint8_t index, char *buffer, size_t size) const override;
+
+private:
+    const uint32_t *_bounds;                                   // 桶上界
+    uint8_t _bucketCount;                                      // 桶数量
+    AtomicCounter _buckets[METRICS_HISTOGRAM_MAX_BUCKETS + 1]; // 各桶计数（非累计，最后为+Inf）
+    AtomicCounter _sum;                                        // 观测值之和
+    AtomicCounter _count;                                      // 观测次数
+};
+
+/**
+ * 指标注册表
+ */
+class MetricsRegistry
+{
+public:
+    /**
+     * 获取第一个注册的指标
+     */
+    static Metric *first();
+
+    /**
+     * 创建 /metrics 响应
+     *
+     * 请求的Accept包含 application/openmetrics-text 时输出OpenMetrics 1.0，
+     * 否则输出Prometheus 0.0.4文本格式
+     *
+     * @param request 异步请求对象
+     * @return 分块响应对象
+     */
+    static AsyncWebServerResponse *beginResponse(AsyncWebServerRequest *request);
+
+private:
+    friend class Metric;
+
+    static Metric *_first; // 链表头
+    static Metric *_last;  // 链表尾
+
+    /**
+     * 追加指标到链表末尾
+     */
+    static void add(Metric *metric);
+};
+
+#endif // METRICS_REGISTRY_H
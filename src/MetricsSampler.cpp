@@ -0,0 +1,478 @@
+/**
+ * MetricsSampler.cpp
+ *
+ * 运行指标采样模块的实现
+ *
+ * @file MetricsSampler.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "MetricsSampler.h"
+#include "JsonResponseWriter.h"
+#include "MetricsRegistry.h"
+
+#if defined(ESP8266)
+#include <ESP8266WiFi.h>
+#else
+#include <WiFi.h>
+#endif
+
+// 导出到 /metrics 的系统指标，堆内存在抓取时读取，其余在采样时更新
+static int32_t readFreeHeap()
+{
+    return ESP.getFreeHeap();
+}
+
+static int32_t readMinFreeHeap()
+{
+#if defined(ESP32)
+    return ESP.getMinFreeHeap();
+#else
+    return ESP.getFreeHeap();
+#endif
+}
+
+static MetricGauge heapFreeMetric("heap_free_bytes", "空闲堆内存", readFreeHeap);
+static MetricGauge heapMinFreeMetric("heap_min_free_bytes", "启动以来的最小空闲堆内存", readMinFreeHeap);
+static MetricGauge loopRateMetric("loop_rate_hz", "主循环每秒执行次数");
+static MetricGauge wifiRssiMetric("wifi_rssi_dbm", "WiFi信号强度，未连接时为0");
+static MetricCounter wifiDisconnectsMetric("wifi_disconnects", "WiFi断开次数");
+#if defined(ESP32)
+static MetricGauge cpuLoadMetric0("cpu_load_percent", "CPU占用", "core=\"0\"");
+#if METRICS_CORE_COUNT > 1
+static MetricGauge cpuLoadMetric1("cpu_load_percent", "CPU占用", "core=\"1\"");
+#endif
+#endif
+
+#if defined(ESP32)
+#include <esp_freertos_hooks.h>
+#include <esp_idf_version.h>
+
+TaskHandle_t MetricsSampler::_idleTasks[METRICS_CORE_COUNT];
+
+/**
+ * 获取核心的空闲任务
+ */
+static TaskHandle_t idleTaskFor(uint8_t core)
+{
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 1, 0)
+    return xTaskGetIdleTaskHandleForCore(core);
+#else
+    return xTaskGetIdleTaskHandleForCPU(core);
+#endif
+}
+
+#if !METRICS_RUN_TIME_STATS
+AtomicCounter MetricsSampler::_busyTicks[METRICS_CORE_COUNT];
+
+/**
+ * 节拍钩子，在该核心的节拍中断中执行，记录被中断的是否为空闲任务
+ */
+void MetricsSampler::tickHook0()
+{
+    if (xTaskGetCurrentTaskHandle() != _idleTasks[0])
+    {
+        _busyTicks[0].add();
+    }
+}
+
+void MetricsSampler::tickHook1()
+{
+#if METRICS_CORE_COUNT > 1
+    if (xTaskGetCurrentTaskHandle() != _idleTasks[1])
+    {
+        _busyTicks[1].add();
+    }
+#endif
+}
+#endif
+#endif
+
+/**
+ * 构造函数
+ */
+MetricsSampler::MetricsSampler(uint32_t interval) : _interval(interval),
+                                                    _lastSample(0),
+                                                    _taskCount(0),
+                                                    _wifiWasConnected(false),
+                                                    _wifiDisconnects(0)
+{
+    memset(&_latest, 0, sizeof(_latest));
+    memset(_pending, 0, sizeof(_pending));
+
+    _tiers[0] = {_secondSamples, METRICS_SECONDS_LENGTH, 0, 0};
+    _tiers[1] = {_minuteSamples, METRICS_MINUTES_LENGTH, 0, 0};
+    _tiers[2] = {_hourSamples, METRICS_HOURS_LENGTH, 0, 0};
+
+#if defined(ESP32)
+    // 默认监视的系统任务
+    watchTask("loopTask");
+    watchTask("async_tcp");
+    watchTask("tiT");
+    watchTask("wifi");
+#else
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        _latest.cpu[core] = METRICS_CPU_UNKNOWN;
+    }
+#endif
+}
+
+/**
+ * 安装空闲钩子并开始采样
+ */
+void MetricsSampler::begin()
+{
+#if defined(ESP32)
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        _idleTasks[core] = idleTaskFor(core);
+    }
+
+#if METRICS_RUN_TIME_STATS
+    _runTimeClock = portGET_RUN_TIME_COUNTER_VALUE();
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        TaskStatus_t status;
+        vTaskGetInfo(_idleTasks[core], &status, pdFALSE, eRunning);
+        _idleRunTime[core] = status.ulRunTimeCounter;
+    }
+#else
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        _busyTicks[core].set(0);
+    }
+    esp_register_freertos_tick_hook_for_cpu(tickHook0, 0);
+#if METRICS_CORE_COUNT > 1
+    esp_register_freertos_tick_hook_for_cpu(tickHook1, 1);
+#endif
+#endif
+#endif
+
+    _loopCount.set(0);
+    _lastSample = millis();
+}
+
+/**
+ * 采样
+ */
+void MetricsSampler::handle()
+{
+    unsigned long now = millis();
+    uint32_t elapsed = now - _lastSample;
+    if (elapsed < _interval)
+    {
+        return;
+    }
+
+    _lastSample = now;
+    takeSample(elapsed);
+}
+
+/**
+ * 记录一次主循环迭代
+ */
+void MetricsSampler::recordLoop()
+{
+    _loopCount.add();
+}
+
+/**
+ * 设置采样间隔
+ */
+void MetricsSampler::setSampleInterval(uint32_t interval)
+{
+    _interval = interval ? interval : METRICS_DEFAULT_INTERVAL;
+}
+
+/**
+ * 获取距离下次采样的时间
+ */
+uint32_t MetricsSampler::getNextSampleDelay(unsigned long now) const
+{
+    uint32_t elapsed = now - _lastSample;
+    return elapsed >= _interval ? 0 : _interval - elapsed;
+}
+
+/**
+ * 增加一个需要监视栈余量的任务
+ */
+bool MetricsSampler::watchTask(const char *name)
+{
+    if (_taskCount >= METRICS_MAX_TASKS)
+    {
+        return false;
+    }
+
+    _tasks[_taskCount].name = name;
+#if defined(ESP32)
+    _tasks[_taskCount].handle = nullptr;
+#endif
+    _taskCount++;
+    return true;
+}
+
+/**
+ * 获取最近一次的采样
+ */
+const MetricsSample &MetricsSampler::getLatest() const
+{
+    return _latest;
+}
+
+/**
+ * 获取WiFi断开次数
+ */
+uint32_t MetricsSampler::getWiFiDisconnects() const
+{
+    return _wifiDisconnects;
+}
+
+/**
+ * 将当前指标以JSON格式写入输出流
+ */
+size_t MetricsSampler::writeCurrentJson(Print &out) const
+{
+    StaticJsonDocument<768> metricsDoc;
+    metricsDoc["type"] = "metrics";
+    metricsDoc["interval"] = _interval;
+    fillSample(_latest, metricsDoc);
+    metricsDoc["wifiDisconnects"] = _wifiDisconnects;
+    metricsDoc["wifiConnected"] = _wifiWasConnected;
+
+    JsonArray tasks = metricsDoc.createNestedArray("tasks");
+#if defined(ESP32)
+    for (uint8_t i = 0; i < _taskCount; i++)
+    {
+        TaskHandle_t handle = _tasks[i].handle ? _tasks[i].handle : xTaskGetHandle(_tasks[i].name);
+        if (!handle)
+        {
+            continue;
+        }
+        JsonObject task = tasks.createNestedObject();
+        task["name"] = _tasks[i].name;
+        task["stackFree"] = uxTaskGetStackHighWaterMark(handle);
+    }
+#elif defined(ESP8266)
+    JsonObject task = tasks.createNestedObject();
+    task["name"] = "cont";
+    task["stackFree"] = ESP.getFreeContStack();
+#endif
+
+    return serializeJson(metricsDoc, out);
+}
+
+/**
+ * 注册API路由
+ */
+void MetricsSampler::attach(ApiRouter &router)
+{
+    router.on("/api/metrics", HTTP_GET, [this](AsyncWebServerRequest *request)
+              { request->send(JsonResponseWriter::beginDocument(
+                    request, [this](Print &out)
+                    { writeCurrentJson(out); })); });
+
+    router.on("/api/metrics/history", HTTP_GET, [this](AsyncWebServerRequest *request)
+              {
+                  uint8_t tier = 0;
+                  if (request->hasParam("tier"))
+                  {
+                      tier = request->getParam("tier")->value().toInt();
+                  }
+                  if (tier >= METRICS_TIER_COUNT)
+                  {
+                      request->send(400, "application/json", "{\"error\":\"invalid_tier\"}");
+                      return;
+                  }
+
+                  // 响应对象只保存前缀指针，使用常量字符串
+                  static const char *prefixes[METRICS_TIER_COUNT] = {
+                      "{\"type\":\"metrics_history\",\"tier\":0,\"samples\":[",
+                      "{\"type\":\"metrics_history\",\"tier\":1,\"samples\":[",
+                      "{\"type\":\"metrics_history\",\"tier\":2,\"samples\":["};
+
+                  // 分块输出期间可能写入新的采样，写入位置和点数都按请求时的值计算，
+                  // 否则新的点会让后续序号整体偏移，输出重复或遗漏的点
+                  const MetricsTier &ring = _tiers[tier];
+                  size_t count = ring.count;
+                  size_t oldest = (ring.head + ring.capacity - count) % ring.capacity;
+                  request->send(JsonResponseWriter::beginArray(
+                      request, prefixes[tier], "]}",
+                      [this, tier, oldest, count](size_t index, JsonDocument &sampleDoc)
+                      {
+                          const MetricsSample *sample = index < count ? sampleAt(tier, oldest, index) : nullptr;
+                          if (!sample)
+                          {
+                              return false;
+                          }
+                          fillSample(*sample, sampleDoc);
+                          return true;
+                      })); });
+}
+
+/**
+ * 采集一个采样点
+ */
+void MetricsSampler::takeSample(uint32_t elapsed)
+{
+    MetricsSample sample;
+
+#if defined(ESP32) && METRICS_RUN_TIME_STATS
+    // 空闲任务运行时间占区间的比例（计数器为32位，差值在回绕后仍然正确）
+    uint32_t clock = portGET_RUN_TIME_COUNTER_VALUE();
+    uint32_t clockDelta = clock - _runTimeClock;
+    _runTimeClock = clock;
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        TaskStatus_t status;
+        vTaskGetInfo(_idleTasks[core], &status, pdFALSE, eRunning);
+        uint32_t idleDelta = (uint32_t)status.ulRunTimeCounter - _idleRunTime[core];
+        _idleRunTime[core] = status.ulRunTimeCounter;
+
+        uint32_t idlePercent = clockDelta ? (uint64_t)idleDelta * 100 / clockDelta : 100;
+        sample.cpu[core] = idlePercent >= 100 ? 0 : 100 - idlePercent;
+    }
+#elif defined(ESP32)
+    // 按区间长度计算应有的节拍数，tickless idle睡眠期间缺少的节拍都是空闲时间
+    uint32_t expectedTicks = (uint64_t)elapsed * configTICK_RATE_HZ / 1000;
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        uint32_t busy = _busyTicks[core].get();
+        _busyTicks[core].set(0);
+
+        uint32_t busyPercent = expectedTicks ? (uint64_t)busy * 100 / expectedTicks : 0;
+        sample.cpu[core] = busyPercent > 100 ? 100 : busyPercent;
+    }
+#else
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        sample.cpu[core] = METRICS_CPU_UNKNOWN;
+    }
+#endif
+
+    uint32_t loops = _loopCount.get();
+    _loopCount.set(0);
+    uint32_t loopRate = (uint64_t)loops * 1000 / elapsed;
+    sample.loopRate = loopRate > 0xFFFF ? 0xFFFF : loopRate;
+
+    bool connected = WiFi.status() == WL_CONNECTED;
+    if (_wifiWasConnected && !connected)
+    {
+        _wifiDisconnects++;
+        wifiDisconnectsMetric.inc();
+    }
+    _wifiWasConnected = connected;
+    sample.rssi = connected ? WiFi.RSSI() : 0;
+
+    sample.freeHeap = ESP.getFreeHeap();
+#if defined(ESP32)
+    sample.minFreeHeap = ESP.getMinFreeHeap();
+#else
+    sample.minFreeHeap = sample.freeHeap;
+#endif
+
+    loopRateMetric.set(sample.loopRate);
+    wifiRssiMetric.set(sample.rssi);
+#if defined(ESP32)
+    cpuLoadMetric0.set(sample.cpu[0]);
+#if METRICS_CORE_COUNT > 1
+    cpuLoadMetric1.set(sample.cpu[1]);
+#endif
+#endif
+
+    _latest = sample;
+    pushSample(0, sample);
+}
+
+/**
+ * 写入一级历史，并在累计足够的点后降采样到下一级
+ */
+void MetricsSampler::pushSample(uint8_t tier, const MetricsSample &sample)
+{
+    MetricsTier &ring = _tiers[tier];
+    ring.samples[ring.head] = sample;
+    ring.head = (ring.head + 1) % ring.capacity;
+    if (ring.count < ring.capacity)
+    {
+        ring.count++;
+    }
+
+    if (tier + 1 >= METRICS_TIER_COUNT)
+    {
+        return;
+    }
+
+    MetricsAccumulator &acc = _pending[tier];
+    if (acc.count == 0)
+    {
+        acc.minFreeHeap = sample.minFreeHeap;
+    }
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        acc.cpu[core] += sample.cpu[core];
+    }
+    acc.rssi += sample.rssi;
+    acc.loopRate += sample.loopRate;
+    acc.freeHeap += sample.freeHeap;
+    if (sample.minFreeHeap < acc.minFreeHeap)
+    {
+        acc.minFreeHeap = sample.minFreeHeap;
+    }
+
+    if (++acc.count < METRICS_TIER_FACTOR)
+    {
+        return;
+    }
+
+    // 下一级保存区间内的平均值和最小堆
+    MetricsSample average;
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        average.cpu[core] = acc.cpu[core] / acc.count;
+    }
+    average.rssi = acc.rssi / (int32_t)acc.count;
+    average.loopRate = acc.loopRate / acc.count;
+    average.freeHeap = acc.freeHeap / acc.count;
+    average.minFreeHeap = acc.minFreeHeap;
+
+    memset(&acc, 0, sizeof(acc));
+    pushSample(tier + 1, average);
+}
+
+/**
+ * 将采样点填入JSON文档
+ */
+void MetricsSampler::fillSample(const MetricsSample &sample, JsonDocument &sampleDoc)
+{
+    JsonArray cpu = sampleDoc.createNestedArray("cpu");
+    for (uint8_t core = 0; core < METRICS_CORE_COUNT; core++)
+    {
+        if (sample.cpu[core] == METRICS_CPU_UNKNOWN)
+        {
+            cpu.add(nullptr);
+        }
+        else
+        {
+            cpu.add(sample.cpu[core]);
+        }
+    }
+    sampleDoc["loopRate"] = sample.loopRate;
+    sampleDoc["rssi"] = sample.rssi;
+    sampleDoc["freeHeap"] = sample.freeHeap;
+    sampleDoc["minFreeHeap"] = sample.minFreeHeap;
+}
+
+/**
+ * 获取某一级历史中从指定位置开始的第index个点
+ */
+const MetricsSample *MetricsSampler::sampleAt(uint8_t tier, size_t oldest, size_t index) const
+{
+    const MetricsTier &ring = _tiers[tier];
+    if (index >= ring.capacity)
+    {
+        return nullptr;
+    }
+    return &ring.samples[(oldest + index) % ring.capacity];
+}
@@ -0,0 +1,228 @@
+/**
+ * MetricsSampler.h
+ *
+ * 运行指标采样模块，记录CPU占用、主循环频率、任务栈余量和WiFi计数，
+ * 并降采样保存到1秒/1分钟/1小时三级环形缓冲区
+ *
+ * @file MetricsSampler.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef METRICS_SAMPLER_H
+#define METRICS_SAMPLER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include "AtomicCounter.h"
+#include "ApiRouter.h"
+
+// 采样配置
+#define METRICS_DEFAULT_INTERVAL 1000 // 默认采样间隔（毫秒）
+#define METRICS_TIER_COUNT 3          // 历史数据级数
+#define METRICS_TIER_FACTOR 60        // 每级相对上一级的降采样倍数
+#define METRICS_SECONDS_LENGTH 60     // 第0级（每次采样）保存的点数
+#define METRICS_MINUTES_LENGTH 60     // 第1级保存的点数
+#define METRICS_HOURS_LENGTH 24       // 第2级保存的点数
+#define METRICS_MAX_TASKS 8           // 最多监视的任务数量
+#define METRICS_CPU_UNKNOWN 0xFF      // 平台不支持CPU占用统计
+
+#if defined(ESP32) && !defined(CONFIG_FREERTOS_UNICORE)
+#define METRICS_CORE_COUNT 2
+#else
+#define METRICS_CORE_COUNT 1
+#endif
+
+// 固件开启了FreeRTOS运行时间统计时直接读取空闲任务的运行时间，否则在节拍中断中采样
+#if defined(ESP32) && configGENERATE_RUN_TIME_STATS == 1 && configUSE_TRACE_FACILITY == 1
+#define METRICS_RUN_TIME_STATS 1
+#else
+#define METRICS_RUN_TIME_STATS 0
+#endif
+
+// 一个采样点（降采样后为平均值）
+struct MetricsSample
+{
+    uint8_t cpu[METRICS_CORE_COUNT]; // 每个核心的CPU占用（百分比）
+    int8_t rssi;                     // WiFi信号强度
+    uint16_t loopRate;               // 主循环每秒执行次数
+    uint32_t freeHeap;               // 空闲堆内存
+    uint32_t minFreeHeap;            // 区间内最小空闲堆内存
+};
+
+// 降采样累加器
+struct MetricsAccumulator
+{
+    uint32_t cpu[METRICS_CORE_COUNT]; // CPU占用之和
+    int32_t rssi;                     // 信号强度之和
+    uint32_t loopRate;                // 主循环频率之和
+    uint32_t freeHeap;                // 空闲堆之和
+    uint32_t minFreeHeap;             // 最小空闲堆
+    uint16_t count;                   // 累加的点数
+};
+
+// 一级环形缓冲区
+struct MetricsTier
+{
+    MetricsSample *samples; // 采样点
+    uint16_t capacity;      // 容量
+    uint16_t count;         // 已保存的点数
+    uint16_t head;          // 下一个写入位置
+};
+
+// 被监视的任务
+struct MonitoredTask
+{
+    const char *name; // 任务名称
+#if defined(ESP32)
+    TaskHandle_t handle; // 任务句柄（缓存）
+#endif
+};
+
+/**
+ * 指标采样器类
+ *
+ * CPU占用按空闲任务占用的时间计算，不依赖校准：
+ * 开启FreeRTOS运行时间统计时读取空闲任务的运行时间；否则每个系统节拍检查
+ * 该核心上正在运行的任务，占用率 = 非空闲任务的节拍数 / 区间内的节拍数
+ * （tickless idle睡眠期间缺少的节拍计为空闲）
+ */
+class MetricsSampler
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param interval 采样间隔（毫秒）
+     */
+    MetricsSampler(uint32_t interval = METRICS_DEFAULT_INTERVAL);
+
+    /**
+     * 安装空闲钩子并开始采样
+     */
+    void begin();
+
+    /**
+     * 采样，需要在loop()中调用
+     */
+    void handle();
+
+    /**
+     * 记录一次主循环迭代
+     */
+    void recordLoop();
+
+    /**
+     * 设置采样间隔
+     *
+     * 各级历史的时间跨度随之按比例变化
+     *
+     * @param interval 采样间隔（毫秒）
+     */
+    void setSampleInterval(uint32_t interval);
+
+    /**
+     * 获取距离下次采样的时间
+     *
+     * @param now 当前时间（millis）
+     * @return 毫秒，0表示已到采样时间
+     */
+    uint32_t getNextSampleDelay(unsigned long now) const;
+
+    /**
+     * 增加一个需要监视栈余量的任务
+     *
+     * @param name 任务名称（字符串常量）
+     * @return 是否添加成功
+     */
+    bool watchTask(const char *name);
+
+    /**
+     * 获取最近一次的采样
+     *
+     * @return 采样点
+     */
+    const MetricsSample &getLatest() const;
+
+    /**
+     * 获取WiFi断开次数
+     *
+     * @return 断开次数
+     */
+    uint32_t getWiFiDisconnects() const;
+
+    /**
+     * 将当前指标（含任务栈余量）以JSON格式写入输出流
+     *
+     * @param out 输出流
+     * @return 写入的字节数
+     */
+    size_t writeCurrentJson(Print &out) const;
+
+    /**
+     * 注册API路由
+     *
+     * GET /api/metrics                当前指标
+     * GET /api/metrics/history?tier=N 第N级历史数据（0: 秒, 1: 分钟, 2: 小时）
+     *
+     * @param router API路由器，路由与库的其他API一起分发并记录延迟统计
+     */
+    void attach(ApiRouter &router);
+
+private:
+    uint32_t _interval;                                   // 采样间隔
+    unsigned long _lastSample;                            // 上次采样时间
+    AtomicCounter _loopCount;                             // 采样区间内的主循环次数
+    MetricsSample _latest;                                // 最近一次采样
+    MetricsSample _secondSamples[METRICS_SECONDS_LENGTH]; // 第0级数据
+    MetricsSample _minuteSamples[METRICS_MINUTES_LENGTH]; // 第1级数据
+    MetricsSample _hourSamples[METRICS_HOURS_LENGTH];     // 第2级数据
+    MetricsTier _tiers[METRICS_TIER_COUNT];               // 各级历史
+    MetricsAccumulator _pending[METRICS_TIER_COUNT - 1];  // 向下一级降采样的累加器
+    MonitoredTask _tasks[METRICS_MAX_TASKS];              // 被监视的任务
+    uint8_t _taskCount;                                   // 被监视的任务数量
+    bool _wifiWasConnected;                               // 上次采样时WiFi是否连接
+    uint32_t _wifiDisconnects;                            // WiFi断开次数
+
+#if defined(ESP32)
+    static TaskHandle_t _idleTasks[METRICS_CORE_COUNT]; // 每个核心的空闲任务
+#if METRICS_RUN_TIME_STATS
+    uint32_t _idleRunTime[METRICS_CORE_COUNT]; // 上次采样时空闲任务的运行时间
+    uint32_t _runTimeClock;                    // 上次采样时的运行时间时钟
+#else
+    static AtomicCounter _busyTicks[METRICS_CORE_COUNT]; // 节拍中断时正在运行非空闲任务的次数
+
+    static void tickHook0();
+    static void tickHook1();
+#endif
+#endif
+
+    /**
+     * 采集一个采样点
+     */
+    void takeSample(uint32_t elapsed);
+
+    /**
+     * 写入一级历史，并在累计足够的点后降采样到下一级
+     */
+    void pushSample(uint8_t tier, const MetricsSample &sample);
+
+    /**
+     * 将采样点填入JSON文档
+     */
+    static void fillSample(const MetricsSample &sample, JsonDocument &sampleDoc);
+
+    /**
+     * 获取某一级历史中从指定位置开始的第index个点
+     *
+     * @param tier 历史级别
+     * @param oldest 最旧的点在环形缓冲区中的位置（开始输出时确定）
+     * @param index 序号
+     * @return 采样点，超出容量时返回nullptr
+     */
+    const MetricsSample *sampleAt(uint8_t tier, size_t oldest, size_t index) const;
+};
+
+#endif // METRICS_SAMPLER_H
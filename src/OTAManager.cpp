@@ -11,6 +11,23 @@
 
 #include "OTAManager.h"
 #include "WebSocketManager.h"
+#include "BinaryLog.h"
+#include "MetricsRegistry.h"
+#include <ESPAsyncWebServer.h>
+
+// 导出到 /metrics 的OTA指标
+static MetricCounter otaBytesMetric("ota_written_bytes", "OTA写入闪存的字节数");
+static MetricCounter otaSuccessMetric("ota_updates", "OTA更新次数", "result=\"success\"");
+static MetricCounter otaFailedMetric("ota_updates", "OTA更新次数", "result=\"failed\"");
+static MetricGauge otaSpeedMetric("ota_speed_bytes_per_second", "当前OTA写入速度");
+
+#if defined(ESP32)
+#define OTA_OWNER_LOCK() portENTER_CRITICAL(&_ownerLock)
+#define OTA_OWNER_UNLOCK() portEXIT_CRITICAL(&_ownerLock)
+#else
+#define OTA_OWNER_LOCK()
+#define OTA_OWNER_UNLOCK()
+#endif
 
 /**
  * 构造函数
@@ -21,11 +38,21 @@ OTAManager::OTAManager(WebSocketManager *wsManager) : _wsManager(wsManager),
                                                       _totalLength(0),
                                                       _isUpdating(false),
                                                       _updateType(0),
+                                                      _updateOwner(nullptr),
                                                       _lastBytes(0),
                                                       _lastSpeedCheck(0),
                                                       _currentSpeed(0),
-                                                      _ota_progress_millis(0)
+                                                      _ota_progress_millis(0),
+                                                      _restartPending(false),
+                                                      _restartReason(""),
+                                                      _restartScheduledAt(0),
+                                                      _restartDeadline(0),
+                                                      _responseDone(true),
+                                                      _closeSentAt(0)
 {
+#if defined(ESP32)
+    _ownerLock = portMUX_INITIALIZER_UNLOCKED;
+#endif
 }
 
 /**
@@ -39,6 +66,7 @@ void OTAManager::begin()
     _totalLength = 0;
     _isUpdating = false;
     _updateType = 0;
+    _updateOwner = nullptr;
     _lastBytes = 0;
     _lastSpeedCheck = 0;
     _currentSpeed = 0;
@@ -48,82 +76,130 @@ void OTAManager::begin()
 }
 
 /**
- * 处理固件更新请求
+ * 处理计划中的重启
  */
-void OTAManager::handleFirmwareUpdate(void *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
+void OTAManager::handle()
 {
-    if (!index)
-    { // 首次接收数据
-        Serial.println("开始接收固件更新...");
-        Serial.printf("文件名: %s\n", filename.c_str());
-
-        // 保存内容长度
-        _contentLength = ((AsyncWebServerRequest *)request)->contentLength();
-        _totalLength = _contentLength;
-        _currentLength = 0;
-        _isUpdating = true;
-        _updateType = 1; // 固件更新
-
-        // 初始化速度计算
-        _lastBytes = 0;
-        _lastSpeedCheck = millis();
-        _currentSpeed = 0;
-
-// 初始化更新
-#if defined(ESP8266)
-        Update.runAsync(true);
-        if (!Update.begin(_contentLength, U_FLASH))
-        {
-#else
-        if (!Update.begin(_contentLength))
+    if (!_restartPending)
+    {
+        return;
+    }
+
+    unsigned long now = millis();
+    unsigned long elapsed = now - _restartScheduledAt;
+
+    if (!_closeSentAt)
+    {
+        // 等待HTTP响应发出，超过截止时间则不再等待
+        bool drained = _responseDone && elapsed >= OTA_RESTART_MIN_DELAY;
+        if (!drained && elapsed < _restartDeadline)
         {
-#endif
-            Update.printError(Serial);
             return;
         }
+
+        if (!_responseDone)
+        {
+            BLOG("等待响应超时, 强制重启\n");
+        }
+
+        if (_beforeRestart)
+        {
+            _beforeRestart(_restartReason);
+        }
+
+        // 发送关闭帧（1012 服务重启，附带重启原因），客户端可以立即得知设备正在重启而不是等待超时
+        if (_wsManager)
+        {
+            _wsManager->disconnectAll(WS_CLOSE_SERVICE_RESTART, _restartReason);
+        }
+
+        _closeSentAt = now ? now : 1;
+        return;
     }
 
-    // 写入数据
-    if (Update.write(data, len) != len)
+    if (now - _closeSentAt < OTA_RESTART_CLOSE_GRACE)
     {
-        Update.printError(Serial);
         return;
     }
 
-    _currentLength += len;
+    BLOG("重启设备: %s\n", _restartReason);
+    BinaryLog::instance().setWebSocketOutput(nullptr);
+    BinaryLog::instance().drain(BINARY_LOG_MAX_FORMATS);
+    Serial.flush();
+    ESP.restart();
+}
 
-    // 更新速度
-    unsigned long now = millis();
-    if (now - _lastSpeedCheck >= 1000)
-    { // 每秒计算一次速度
-        _currentSpeed = (_currentLength - _lastBytes) * 1000.0 / (now - _lastSpeedCheck);
-        _lastBytes = _currentLength;
-        _lastSpeedCheck = now;
+/**
+ * 安排一次非阻塞重启
+ */
+void OTAManager::scheduleRestart(const char *reason, uint32_t deadline)
+{
+    if (_restartPending)
+    {
+        return;
     }
 
-    // 发送进度
-    if (now - _ota_progress_millis > 100)
-    { // 每100ms发送一次进度
-        float progress = (float)_currentLength / (float)_contentLength * 100.0;
-        sendUpdateProgress(progress, _currentLength, _contentLength);
-        _ota_progress_millis = now;
+    _restartPending = true;
+    _restartReason = reason;
+    _restartScheduledAt = millis();
+    _restartDeadline = deadline;
+    _closeSentAt = 0;
+
+    if (_wsManager)
+    {
+        StaticJsonDocument<96> restartDoc;
+        restartDoc["type"] = "restart";
+        restartDoc["reason"] = reason;
+        restartDoc["deadline"] = deadline;
+        _wsManager->broadcastDocument(restartDoc);
     }
+}
+
+/**
+ * 是否有计划中的重启
+ */
+bool OTAManager::isRestartPending() const
+{
+    return _restartPending;
+}
+
+/**
+ * 设置重启前回调
+ */
+void OTAManager::onBeforeRestart(RestartHandler handler)
+{
+    _beforeRestart = handler;
+}
 
-    if (final)
+/**
+ * 跟踪上传请求
+ */
+void OTAManager::watchRequest(void *request)
+{
+    _responseDone = false;
+    ((AsyncWebServerRequest *)request)->onDisconnect([this, request]()
+                                                     {
+                                                         // 上传中断时释放更新，其他传输方式可以重新开始
+                                                         abortUpdate(request);
+                                                         _responseDone = true; });
+}
+
+/**
+ * 处理固件更新请求
+ */
+void OTAManager::handleFirmwareUpdate(void *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)
+{
+    if (!index)
+    { // 首次接收数据
+        BLOG("开始接收固件更新, 文件名: %s\n", filename);
+        watchRequest(request);
+        beginUpdate(request, 1, ((AsyncWebServerRequest *)request)->contentLength());
+    }
+
+    // 其他所有者正在更新时写入失败，数据被丢弃
+    if (writeUpdate(request, data, len) && final)
     { // 文件上传完成
-        if (Update.end(true))
-        {
-            Serial.printf("更新成功! 共计 %u bytes\n", _currentLength);
-            // 发送100%进度
-            sendUpdateProgress(100.0, _contentLength, _contentLength);
-            // 重启设备
-            delay(1000);
-            ESP.restart();
-        }
-        else
-        {
-            Update.printError(Serial);
-        }
+        endUpdate(request);
     }
 }
 
@@ -134,51 +210,121 @@ void OTAManager::handleFilesystemUpdate(void *request, const String &filename, s
 {
     if (!index)
     { // 首次接收数据
-        Serial.println("开始接收文件系统更新...");
-        Serial.printf("文件名: %s\n", filename.c_str());
-
-        // 保存内容长度
-        _contentLength = ((AsyncWebServerRequest *)request)->contentLength();
-        _totalLength = _contentLength;
-        _currentLength = 0;
-        _isUpdating = true;
-        _updateType = 2; // 文件系统更新
-
-        // 初始化速度计算
-        _lastBytes = 0;
-        _lastSpeedCheck = millis();
-        _currentSpeed = 0;
-
-// 初始化更新
+        BLOG("开始接收文件系统更新, 文件名: %s\n", filename);
+        watchRequest(request);
+        beginUpdate(request, 2, ((AsyncWebServerRequest *)request)->contentLength());
+    }
+
+    if (writeUpdate(request, data, len) && final)
+    { // 文件上传完成
+        endUpdate(request);
+    }
+}
+
+/**
+ * 开始一次更新
+ */
+bool OTAManager::beginUpdate(const void *owner, uint8_t updateType, size_t size, const char *md5)
+{
+    if (_restartPending)
+    {
+        BLOG("设备即将重启, 拒绝新的更新\n");
+        return false;
+    }
+
+    // 占用更新，其他所有者的更新（包括等待续传的）不能被取代
+    OTA_OWNER_LOCK();
+    bool busy = _updateOwner && _updateOwner != owner;
+    if (!busy)
+    {
+        _updateOwner = owner;
+    }
+    OTA_OWNER_UNLOCK();
+    if (busy)
+    {
+        BLOG("其他上传正在更新, 拒绝新的更新\n");
+        return false;
+    }
+
+    // 同一所有者重新开始时放弃之前写入的数据
+    releaseUpdate();
+
+    // 保存内容长度
+    _contentLength = size;
+    _totalLength = size;
+    _currentLength = 0;
+    _updateType = updateType; // 1: 固件更新, 2: 文件系统更新
+
+    // 初始化速度计算
+    _lastBytes = 0;
+    _lastSpeedCheck = millis();
+    _currentSpeed = 0;
+
+    // 初始化更新
+    bool started;
 #if defined(ESP8266)
-        if (!Update.begin(_contentLength, U_FS))
-        {
+    if (updateType == 1)
+    {
+        Update.runAsync(true);
+        started = Update.begin(size, U_FLASH);
+    }
+    else
+    {
+        started = Update.begin(size, U_FS);
+    }
 #elif defined(ESP32)
-        if (!Update.begin(_contentLength, U_SPIFFS))
-        {
+    started = Update.begin(size, updateType == 1 ? U_FLASH : U_SPIFFS);
 #else
-        if (!Update.begin(_contentLength))
-        {
+    started = Update.begin(size);
 #endif
-            Update.printError(Serial);
-            return;
-        }
+
+    if (!started)
+    {
+        Update.printError(Serial);
+        _isUpdating = false;
+        _updateOwner = nullptr;
+        return false;
+    }
+
+#if defined(ESP32) || defined(ESP8266)
+    if (md5 && strlen(md5) == 32)
+    {
+        Update.setMD5(md5);
+    }
+#endif
+
+    _isUpdating = true;
+    return true;
+}
+
+/**
+ * 写入更新数据
+ */
+bool OTAManager::writeUpdate(const void *owner, const uint8_t *data, size_t len)
+{
+    if (!_isUpdating || _updateOwner != owner)
+    {
+        return false;
     }
 
     // 写入数据
-    if (Update.write(data, len) != len)
+    if (Update.write((uint8_t *)data, len) != len)
     {
         Update.printError(Serial);
-        return;
+        releaseUpdate();
+        _updateOwner = nullptr;
+        return false;
     }
 
     _currentLength += len;
+    otaBytesMetric.inc(len);
 
     // 更新速度
     unsigned long now = millis();
     if (now - _lastSpeedCheck >= 1000)
     { // 每秒计算一次速度
         _currentSpeed = (_currentLength - _lastBytes) * 1000.0 / (now - _lastSpeedCheck);
+        otaSpeedMetric.set((int32_t)_currentSpeed);
         _lastBytes = _currentLength;
         _lastSpeedCheck = now;
     }
@@ -190,23 +336,102 @@ void OTAManager::handleFilesystemUpdate(void *request, const String &filename, s
         sendUpdateProgress(progress, _currentLength, _contentLength);
         _ota_progress_millis = now;
     }
+    return true;
+}
 
-    if (final)
-    { // 文件上传完成
-        if (Update.end(true))
-        {
-            Serial.printf("文件系统更新成功! 共计 %u bytes\n", _currentLength);
-            // 发送100%进度
-            sendUpdateProgress(100.0, _contentLength, _contentLength);
-            // 重启设备
-            delay(1000);
-            ESP.restart();
-        }
-        else
-        {
-            Update.printError(Serial);
-        }
+/**
+ * 完成更新
+ */
+bool OTAManager::endUpdate(const void *owner)
+{
+    if (!_isUpdating || _updateOwner != owner)
+    {
+        return false;
     }
+    _isUpdating = false;
+    _updateOwner = nullptr;
+    otaSpeedMetric.set(0);
+
+    if (!Update.end(true))
+    {
+        Update.printError(Serial);
+        otaFailedMetric.inc();
+        return false;
+    }
+    otaSuccessMetric.inc();
+
+    if (_updateType == 1)
+    {
+        BLOG("更新成功! 共计 %u bytes\n", _currentLength);
+    }
+    else
+    {
+        BLOG("文件系统更新成功! 共计 %u bytes\n", _currentLength);
+    }
+
+    // 发送100%进度
+    sendUpdateProgress(100.0, _contentLength, _contentLength);
+    // 响应发送完毕后在主循环中重启，不阻塞上传回调
+    scheduleRestart(_updateType == 1 ? "firmware_update" : "filesystem_update");
+    return true;
+}
+
+/**
+ * 放弃当前更新
+ */
+void OTAManager::abortUpdate(const void *owner)
+{
+    if (_updateOwner != owner)
+    {
+        return;
+    }
+    releaseUpdate();
+    _updateOwner = nullptr;
+}
+
+/**
+ * 当前更新是否属于指定的所有者
+ */
+bool OTAManager::isUpdateOwner(const void *owner) const
+{
+    return _isUpdating && _updateOwner == owner;
+}
+
+/**
+ * 放弃当前更新（调用方已确认所有者，并负责清除所有者）
+ */
+void OTAManager::releaseUpdate()
+{
+    if (!_isUpdating)
+    {
+        return;
+    }
+    _isUpdating = false;
+    otaSpeedMetric.set(0);
+    otaFailedMetric.inc();
+
+#if defined(ESP32)
+    Update.abort();
+#else
+    Update.end(false);
+#endif
+    BLOG("更新已取消, 已写入 %u bytes\n", _currentLength);
+}
+
+/**
+ * 是否正在更新
+ */
+bool OTAManager::isUpdating() const
+{
+    return _isUpdating;
+}
+
+/**
+ * 获取已写入的字节数
+ */
+size_t OTAManager::getUpdateProgress() const
+{
+    return _currentLength;
 }
 
 /**
@@ -227,10 +452,8 @@ void OTAManager::sendUpdateProgress(float progress, size_t current, size_t total
         progressDoc["speed"] = _currentSpeed;
         progressDoc["speedText"] = speedText;
 
-        String progressJson;
-        serializeJson(progressDoc, progressJson);
-
-        _wsManager->broadcastTXT(progressJson);
+        // 每个客户端按协商的编码接收
+        _wsManager->broadcastDocument(progressDoc);
     }
 }
 
@@ -29,10 +29,23 @@
 #include <LittleFS.h>
 #include <Update.h>
 #include <ArduinoJson.h>
+#include <functional>
+
+// 重启配置
+#define OTA_RESTART_MIN_DELAY 200   // 安排重启后至少等待的时间（毫秒），让最后的WebSocket帧发出
+#define OTA_RESTART_DEADLINE 3000   // 等待HTTP响应完成的最长时间（毫秒）
+#define OTA_RESTART_CLOSE_GRACE 100 // 发送WebSocket关闭帧后等待的时间（毫秒）
 
 // 前向声明
 class WebSocketManager;
 
+/**
+ * 重启前回调，用于保存需要持久化的状态
+ *
+ * @param reason 重启原因
+ */
+typedef std::function<void(const char *reason)> RestartHandler;
+
 /**
  * OTA管理器类
  *
@@ -53,6 +66,36 @@ public:
      */
     void begin();
 
+    /**
+     * 处理计划中的重启，需要在loop()中调用
+     */
+    void handle();
+
+    /**
+     * 安排一次非阻塞重启
+     *
+     * 先通知WebSocket客户端，等待HTTP响应发送完毕（或到达截止时间）后
+     * 执行重启前回调、关闭WebSocket连接，然后重启
+     *
+     * @param reason 重启原因（字符串常量），会发送给客户端
+     * @param deadline 最长等待时间（毫秒）
+     */
+    void scheduleRestart(const char *reason, uint32_t deadline = OTA_RESTART_DEADLINE);
+
+    /**
+     * 是否有计划中的重启
+     *
+     * @return 是否等待重启
+     */
+    bool isRestartPending() const;
+
+    /**
+     * 设置重启前回调
+     *
+     * @param handler 回调函数
+     */
+    void onBeforeRestart(RestartHandler handler);
+
     /**
      * 处理固件更新请求
      *
@@ -77,6 +120,67 @@ public:
      */
     void handleFilesystemUpdate(void *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final);
 
+    /**
+     * 开始一次更新，HTTP上传、WebSocket上传和设备间分发共用的写入路径
+     *
+     * 同一时间只有一个所有者可以更新，其他所有者开始更新时返回失败（忙），
+     * 之后的写入、完成和放弃都需要传入同一个所有者
+     *
+     * @param owner 所有者（HTTP上传为请求对象，其他为模块实例）
+     * @param updateType 更新类型 (1: 固件更新, 2: 文件系统更新)
+     * @param size 镜像大小
+     * @param md5 镜像的MD5（32位十六进制字符串），nullptr表示不校验
+     * @return 是否开始成功
+     */
+    bool beginUpdate(const void *owner, uint8_t updateType, size_t size, const char *md5 = nullptr);
+
+    /**
+     * 写入更新数据，并按时间间隔发送进度
+     *
+     * @param owner 所有者
+     * @param data 数据
+     * @param len 数据长度
+     * @return 是否写入成功, 失败时更新会被放弃
+     */
+    bool writeUpdate(const void *owner, const uint8_t *data, size_t len);
+
+    /**
+     * 完成更新，成功后安排重启
+     *
+     * @param owner 所有者
+     * @return 是否校验并完成成功
+     */
+    bool endUpdate(const void *owner);
+
+    /**
+     * 放弃当前更新，不是所有者时不做任何事
+     *
+     * @param owner 所有者
+     */
+    void abortUpdate(const void *owner);
+
+    /**
+     * 当前更新是否属于指定的所有者
+     *
+     * @param owner 所有者
+     * @return 是否正在为该所有者更新
+     */
+    bool isUpdateOwner(const void *owner) const;
+
+    /**
+     * 是否正在更新
+     *
+     * @return 是否正在更新
+     */
+    bool isUpdating() const;
+
+    /**
+     * 获取当前更新已写入的字节数
+     *
+     * @return 字节数
+     */
+    size_t getUpdateProgress() const;
+
     /**
      * 发送OTA更新进度
      *
@@ -101,7 +205,11 @@ private:
     size_t _currentLength;
     size_t _totalLength;
     bool _isUpdating;
-    uint8_t _updateType; // 0: 无更新, 1: 固件更新, 2: 文件系统更新
+    uint8_t _updateType;               // 0: 无更新, 1: 固件更新, 2: 文件系统更新
+    const void *volatile _updateOwner; // 当前更新的所有者
+#if defined(ESP32)
+    portMUX_TYPE _ownerLock; // 保护所有者的自旋锁，HTTP上传在网络任务中开始更新
+#endif
 
     // 速度计算变量
     unsigned long _lastBytes;
@@ -109,6 +217,27 @@ private:
     float _currentSpeed;
     unsigned long _ota_progress_millis;
 
+    // 计划重启变量
+    bool _restartPending;
+    const char *_restartReason;
+    unsigned long _restartScheduledAt;
+    uint32_t _restartDeadline;
+    volatile bool _responseDone; // 上传请求的连接是否已关闭
+    unsigned long _closeSentAt;  // 发送关闭帧的时间, 0表示尚未发送
+    RestartHandler _beforeRestart;
+
+    /**
+     * 跟踪上传请求，连接关闭即表示响应已发送
+     *
+     * @param request 异步请求对象
+     */
+    void watchRequest(void *request);
+
+    /**
+     * 放弃当前更新（调用方已确认所有者，并负责清除所有者）
+     */
+    void releaseUpdate();
+
     /**
      * 计算并格式化传输速度
      *
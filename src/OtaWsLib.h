@@ -0,0 +1,477 @@
+/**
+ * OtaWsLib.h
+ *
+ * 编译期模块组合，只包含选定的模块
+ *
+ * 每个模块作为基类直接嵌入，不经过堆分配和指针调用；
+ * 未选择的模块是空基类，不占用RAM，相关代码也不会被链接。
+ * 日志环形缓冲区（BinaryLog）总是存在；选择WithOTA时，
+ * OTAManager.cpp中的OTA指标对象也会随之链接；选择WithWebSocket时，
+ * WsEventRouter.cpp中的WebSocket指标对象也会随之链接
+ *
+ * 用法:
+ *   OtaWsLib<WithWiFi, WithWebSocket, WithOTA> otaLib("Sensor", "1.0.0");
+ *
+ * @file OtaWsLib.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef OTA_WS_LIB_H
+#define OTA_WS_LIB_H
+
+#include <Arduino.h>
+#include <type_traits>
+#include "OTAManager.h"
+#include "WiFiManager.h"
+#include "WebSocketManager.h"
+#include "WebServerManager.h"
+#include "SystemMonitor.h"
+#include "StatusIndicator.h"
+#include "BinaryLog.h"
+#include "WsEventRouter.h"
+
+// 可选模块标记
+struct WithWiFi
+{
+};
+struct WithWebSocket
+{
+};
+struct WithWebServer
+{
+};
+struct WithOTA
+{
+};
+struct WithMonitor
+{
+};
+struct WithStatusLed
+{
+};
+
+namespace OtaWsDetail
+{
+    /**
+     * 判断模块标记是否在列表中
+     */
+    template <typename Tag, typename... Modules>
+    struct HasModule : std::false_type
+    {
+    };
+
+    template <typename Tag, typename First, typename... Rest>
+    struct HasModule<Tag, First, Rest...>
+        : std::integral_constant<bool, std::is_same<Tag, First>::value || HasModule<Tag, Rest...>::value>
+    {
+    };
+
+    // WiFi模块
+    template <bool Enabled>
+    class WiFiSlot
+    {
+    public:
+        WiFiManager *getWiFiManager()
+        {
+            return &_wifiManager;
+        }
+
+    protected:
+        WiFiManager _wifiManager;
+
+        void beginWiFi()
+        {
+            _wifiManager.begin();
+        }
+        void handleWiFi()
+        {
+            _wifiManager.handle();
+        }
+        bool wifiConnected()
+        {
+            return _wifiManager.isConnected();
+        }
+    };
+
+    template <>
+    class WiFiSlot<false>
+    {
+    protected:
+        void beginWiFi()
+        {
+        }
+        void handleWiFi()
+        {
+        }
+        bool wifiConnected()
+        {
+            // 网络由应用自行管理
+            return WiFi.status() == WL_CONNECTED;
+        }
+    };
+
+    // WebSocket模块
+    template <bool Enabled>
+    class WebSocketSlot
+    {
+    public:
+        WebSocketManager *getWebSocketManager()
+        {
+            return &_wsManager;
+        }
+
+        /**
+         * 发送消息到所有连接的WebSocket客户端
+         *
+         * @param message 要发送的消息
+         */
+        void broadcastMessage(const String &message)
+        {
+            _wsManager.broadcastTXT(message);
+        }
+
+    protected:
+        WebSocketManager _wsManager;
+        WsEventRouter _wsRouter;
+
+        WebSocketSlot(uint16_t port) : _wsManager(port),
+                                       _wsRouter(&_wsManager)
+        {
+        }
+
+        WebSocketManager *webSocketOrNull()
+        {
+            return &_wsManager;
+        }
+        void beginWebSocket()
+        {
+            _wsManager.begin();
+            _wsRouter.begin();
+
+            // 日志同时以二进制帧推送给WebSocket客户端，新连接的客户端先收到格式表
+            BinaryLog::instance().setWebSocketOutput(&_wsManager, &_wsRouter);
+        }
+        void handleWebSocket()
+        {
+            _wsManager.handle();
+        }
+    };
+
+    template <>
+    class WebSocketSlot<false>
+    {
+    protected:
+        WebSocketSlot(uint16_t)
+        {
+        }
+
+        WebSocketManager *webSocketOrNull()
+        {
+            return nullptr;
+        }
+        void beginWebSocket()
+        {
+        }
+        void handleWebSocket()
+        {
+        }
+    };
+
+    // Web服务器模块
+    template <bool Enabled>
+    class WebServerSlot
+    {
+    public:
+        WebServerManager *getWebServerManager()
+        {
+            return &_webServer;
+        }
+
+    protected:
+        WebServerManager _webServer;
+
+        WebServerSlot(uint16_t port) : _webServer(port)
+        {
+        }
+
+        void beginWebServer()
+        {
+            _webServer.begin();
+        }
+    };
+
+    template <>
+    class WebServerSlot<false>
+    {
+    protected:
+        WebServerSlot(uint16_t)
+        {
+        }
+
+        void beginWebServer()
+        {
+        }
+    };
+
+    // OTA模块
+    template <bool Enabled>
+    class OTASlot
+    {
+    public:
+        OTAManager *getOTAManager()
+        {
+            return &_otaManager;
+        }
+
+    protected:
+        OTAManager _otaManager;
+
+        OTASlot(WebSocketManager *wsManager) : _otaManager(wsManager)
+        {
+        }
+
+        void beginOTA()
+        {
+            _otaManager.begin();
+        }
+        void handleOTA()
+        {
+            _otaManager.handle();
+        }
+    };
+
+    template <>
+    class OTASlot<false>
+    {
+    protected:
+        OTASlot(WebSocketManager *)
+        {
+        }
+
+        void beginOTA()
+        {
+        }
+        void handleOTA()
+        {
+        }
+    };
+
+    // 系统监控模块
+    template <bool Enabled>
+    class MonitorSlot
+    {
+    public:
+        SystemMonitor *getSystemMonitor()
+        {
+            return &_sysMonitor;
+        }
+
+        /**
+         * 设置自动重启间隔
+         *
+         * @param hours 重启间隔小时数, 0表示禁用
+         */
+        void setRebootInterval(int hours)
+        {
+            _sysMonitor.setupRebootTimer(hours);
+        }
+
+    protected:
+        SystemMonitor _sysMonitor;
+
+        MonitorSlot(const String &deviceName, const String &firmwareVersion) : _sysMonitor(deviceName, firmwareVersion)
+        {
+        }
+
+        void beginMonitor()
+        {
+            _sysMonitor.begin();
+        }
+        void handleMonitor()
+        {
+            _sysMonitor.handle();
+        }
+    };
+
+    template <>
+    class MonitorSlot<false>
+    {
+    protected:
+        MonitorSlot(const String &, const String &)
+        {
+        }
+
+        void beginMonitor()
+        {
+        }
+        void handleMonitor()
+        {
+        }
+    };
+
+    // 状态指示器模块（仅ESP32/ESP8266）
+    template <bool Enabled>
+    class StatusLedSlot
+    {
+#if !defined(ESP32) && !defined(ESP8266)
+        static_assert(!Enabled, "WithStatusLed 只支持ESP32和ESP8266");
+#endif
+
+    public:
+        StatusIndicator *getStatusIndicator()
+        {
+            return &_statusIndicator;
+        }
+
+    protected:
+        StatusIndicator _statusIndicator;
+
+        StatusLedSlot(uint8_t ledPin) : _statusIndicator(ledPin)
+        {
+        }
+
+        void beginStatusLed()
+        {
+            _statusIndicator.begin();
+            _statusIndicator.enableTimedRendering(true);
+        }
+        void handleStatusLed()
+        {
+            _statusIndicator.handle();
+        }
+        void showNetworkState(bool connected)
+        {
+            _statusIndicator.setMode(connected ? LED_CONNECTED : LED_AP_MODE);
+        }
+    };
+
+    template <>
+    class StatusLedSlot<false>
+    {
+    protected:
+        StatusLedSlot(uint8_t)
+        {
+        }
+
+        void beginStatusLed()
+        {
+        }
+        void handleStatusLed()
+        {
+        }
+        void showNetworkState(bool)
+        {
+        }
+    };
+}
+
+/**
+ * 按模块组合的OTA WebSocket库
+ *
+ * 只提供所选模块的获取函数，访问未选择的模块会在编译时报错
+ *
+ * @tparam Modules 模块标记: WithWiFi, WithWebSocket, WithWebServer, WithOTA, WithMonitor, WithStatusLed
+ */
+template <typename... Modules>
+class OtaWsLib : public OtaWsDetail::WiFiSlot<OtaWsDetail::HasModule<WithWiFi, Modules...>::value>,
+                 public OtaWsDetail::WebSocketSlot<OtaWsDetail::HasModule<WithWebSocket, Modules...>::value>,
+                 public OtaWsDetail::WebServerSlot<OtaWsDetail::HasModule<WithWebServer, Modules...>::value>,
+                 public OtaWsDetail::OTASlot<OtaWsDetail::HasModule<WithOTA, Modules...>::value>,
+                 public OtaWsDetail::MonitorSlot<OtaWsDetail::HasModule<WithMonitor, Modules...>::value>,
+                 public OtaWsDetail::StatusLedSlot<OtaWsDetail::HasModule<WithStatusLed, Modules...>::value>
+{
+    typedef OtaWsDetail::WiFiSlot<OtaWsDetail::HasModule<WithWiFi, Modules...>::value> WiFiBase;
+    typedef OtaWsDetail::WebSocketSlot<OtaWsDetail::HasModule<WithWebSocket, Modules...>::value> WebSocketBase;
+    typedef OtaWsDetail::WebServerSlot<OtaWsDetail::HasModule<WithWebServer, Modules...>::value> WebServerBase;
+    typedef OtaWsDetail::OTASlot<OtaWsDetail::HasModule<WithOTA, Modules...>::value> OTABase;
+    typedef OtaWsDetail::MonitorSlot<OtaWsDetail::HasModule<WithMonitor, Modules...>::value> MonitorBase;
+    typedef OtaWsDetail::StatusLedSlot<OtaWsDetail::HasModule<WithStatusLed, Modules...>::value> StatusLedBase;
+
+public:
+    /**
+     * 构造函数
+     *
+     * @param deviceName 设备名称前缀
+     * @param firmwareVersion 固件版本
+     * @param webServerPort Web服务器端口号
+     * @param wsServerPort WebSocket服务器端口号
+     * @param ledPin NeoPixel LED引脚
+     */
+    OtaWsLib(const char *deviceName = "ESP_Device",
+             const char *firmwareVersion = "1.0.0",
+             uint16_t webServerPort = 80,
+             uint16_t wsServerPort = 81,
+             uint8_t ledPin = 8) : WebSocketBase(wsServerPort),
+                                   WebServerBase(webServerPort),
+                                   OTABase(this->webSocketOrNull()),
+                                   MonitorBase(deviceName, firmwareVersion),
+                                   StatusLedBase(ledPin)
+    {
+    }
+
+    /**
+     * 初始化所选模块
+     *
+     * 与ESP32_OTA_WS_Lib::begin()相同，Web服务器从LittleFS提供界面，
+     * 使用嵌入的Web界面（EMBEDDED_WEB_UI_AVAILABLE）时无需挂载文件系统
+     *
+     * @param mountFS 是否挂载文件系统
+     * @return 初始化是否成功
+     */
+    bool begin(bool mountFS = true)
+    {
+        Serial.begin(115200);
+
+        this->beginStatusLed();
+        this->beginWiFi();
+
+        // 挂载文件系统
+        bool fsInitialized = true;
+        if (mountFS)
+        {
+#if defined(ESP32) || defined(ESP8266)
+            fsInitialized = LittleFS.begin();
+            if (!fsInitialized)
+            {
+                BLOG("文件系统挂载失败\n");
+            }
+            else
+            {
+                BLOG("文件系统挂载成功\n");
+            }
+#else
+            Serial.println("当前平台不支持LittleFS");
+            fsInitialized = false;
+#endif
+        }
+
+        this->beginWebSocket();
+        this->beginWebServer();
+        this->beginOTA();
+        this->beginMonitor();
+        this->showNetworkState(this->wifiConnected());
+
+        // 输出初始化期间缓存的日志
+        BinaryLog::instance().drain(BINARY_LOG_MAX_FORMATS);
+        return fsInitialized;
+    }
+
+    /**
+     * 处理循环函数，需要在loop()中调用
+     */
+    void handle()
+    {
+        this->handleWiFi();
+        this->handleWebSocket();
+        this->handleOTA();
+        this->handleStatusLed();
+        this->handleMonitor();
+
+        // OTAManager等模块只通过BLOG输出日志，在主循环中格式化并输出
+        BinaryLog::instance().drain();
+    }
+};
+
+#endif // OTA_WS_LIB_H
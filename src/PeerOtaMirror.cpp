@@ -0,0 +1,728 @@
+/**
+ * PeerOtaMirror.cpp
+ *
+ * 设备间固件分发模块的实现
+ *
+ * @file PeerOtaMirror.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "PeerOtaMirror.h"
+#include "OTAManager.h"
+#include "BinaryLog.h"
+#include "MessageCodec.h"
+#include <ArduinoJson.h>
+
+#if defined(ESP32)
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#endif
+
+namespace
+{
+    /**
+     * 统计逗号分隔列表中的设备数量
+     */
+    size_t countPeers(const String &peers)
+    {
+        if (!peers.length())
+        {
+            return 0;
+        }
+
+        size_t count = 1;
+        for (size_t i = 0; i < peers.length(); i++)
+        {
+            if (peers[i] == ',')
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * 取出列表中从first开始的count台设备
+     */
+    String slicePeers(const String &peers, size_t first, size_t count)
+    {
+        String result;
+        size_t index = 0;
+        int start = 0;
+        int length = peers.length();
+
+        while (count && start < length)
+        {
+            int end = peers.indexOf(',', start);
+            if (end < 0)
+            {
+                end = length;
+            }
+
+            if (index >= first)
+            {
+                if (result.length())
+                {
+                    result += ',';
+                }
+                result += peers.substring(start, end);
+                count--;
+            }
+
+            index++;
+            start = end + 1;
+        }
+        return result;
+    }
+
+    /**
+     * 表单字段编码
+     */
+    void appendEncoded(String &out, const String &value)
+    {
+        static const char hex[] = "0123456789ABCDEF";
+        for (size_t i = 0; i < value.length(); i++)
+        {
+            char c = value[i];
+            if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+            {
+                out += c;
+            }
+            else
+            {
+                out += '%';
+                out += hex[(uint8_t)c >> 4];
+                out += hex[(uint8_t)c & 0x0F];
+            }
+        }
+    }
+}
+
+/**
+ * 构造函数
+ */
+PeerOtaMirror::PeerOtaMirror(OTAManager *otaManager, fs::FS &fs, uint16_t httpPort) : _otaManager(otaManager),
+                                                                                      _fs(fs),
+                                                                                      _httpPort(httpPort),
+                                                                                      _runningSize(0),
+                                                                                      _state(PEER_OTA_IDLE),
+                                                                                      _size(0),
+                                                                                      _attempts(0),
+                                                                                      _nextAttempt(0),
+                                                                                      _nextGroup(0),
+                                                                                      _groupSkip(0),
+                                                                                      _received(0),
+                                                                                      _lastData(0),
+                                                                                      _request(PEER_OTA_REQUEST_NONE),
+                                                                                      _requestCode(-1)
+{
+}
+
+/**
+ * 读取重启前保存的分发状态
+ */
+void PeerOtaMirror::begin()
+{
+    if (!_fs.exists(PEER_OTA_STATE_FILE))
+    {
+        return;
+    }
+
+    File file = _fs.open(PEER_OTA_STATE_FILE, "r");
+    DynamicJsonDocument stateDoc(file ? file.size() + 128 : 128);
+    DeserializationError err = file ? deserializeJson(stateDoc, file) : DeserializationError::EmptyInput;
+    file.close();
+
+    // 状态文件只使用一次，转发中途断电不会重复分发
+    clearState();
+
+    if (err)
+    {
+        return;
+    }
+
+    _md5 = stateDoc["md5"] | "";
+    _size = stateDoc["size"] | 0;
+    _peers = stateDoc["peers"] | "";
+
+    if (!_md5.equalsIgnoreCase(getRunningMD5()))
+    {
+        BLOG("分发的固件未能启动, 放弃向 %u 台设备转发\n", countPeers(_peers));
+        finish();
+        return;
+    }
+
+    // 以自己为source继续分发
+    _source = "";
+    _state = PEER_OTA_FANOUT_WAIT;
+}
+
+/**
+ * 推进下载和转发
+ */
+void PeerOtaMirror::handle()
+{
+    if (_request == PEER_OTA_REQUEST_PENDING)
+    {
+        return;
+    }
+
+    if (_request == PEER_OTA_REQUEST_DONE)
+    {
+        _request = PEER_OTA_REQUEST_NONE;
+        if (_state == PEER_OTA_PULL_START)
+        {
+            if (!onPullResponse(_requestCode))
+            {
+                failPull("start_failed");
+            }
+        }
+        else if (_state == PEER_OTA_FANOUT)
+        {
+            onFanoutResponse(_requestCode);
+        }
+        return;
+    }
+
+    switch (_state)
+    {
+    case PEER_OTA_PULL_START:
+        if (_md5.equalsIgnoreCase(getRunningMD5()))
+        {
+            // 已在运行这个固件，直接转发
+            BLOG("已在运行目标固件, 跳过下载\n");
+            _source = "";
+            _state = PEER_OTA_FANOUT_WAIT;
+        }
+        else if (millis() >= _nextAttempt && !startPull())
+        {
+            failPull("start_failed");
+        }
+        break;
+
+    case PEER_OTA_PULLING:
+        continuePull();
+        break;
+
+    case PEER_OTA_FANOUT_WAIT:
+        if (WiFi.status() == WL_CONNECTED)
+        {
+            _nextGroup = 0;
+            _groupSkip = 0;
+            _attempts = 0;
+            _nextAttempt = 0;
+            _state = PEER_OTA_FANOUT;
+        }
+        break;
+
+    case PEER_OTA_FANOUT:
+        if (millis() >= _nextAttempt)
+        {
+            continueFanout();
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * 注册API路由
+ */
+void PeerOtaMirror::attach(ApiRouter &router)
+{
+    router.on("/api/ota/image", HTTP_GET, [this](AsyncWebServerRequest *request)
+              {
+                  size_t size = getRunningSize();
+                  if (!size)
+                  {
+                      request->send(503, "application/json", "{\"error\":\"image_unavailable\"}");
+                      return;
+                  }
+
+                  AsyncWebServerResponse *response = request->beginResponse(
+                      "application/octet-stream", size,
+                      [this](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                      { return readImage(buffer, maxLen, index); });
+                  response->addHeader("X-Image-MD5", getRunningMD5());
+                  request->send(response); });
+
+    router.on("/api/ota/mirror", HTTP_GET, [this](AsyncWebServerRequest *request)
+              {
+                  static const char *stateNames[] = {"idle", "pull_start", "pulling", "fanout_wait", "fanout"};
+
+                  StaticJsonDocument<256> statusDoc;
+                  statusDoc["type"] = "peer_ota";
+                  statusDoc["state"] = stateNames[_state];
+                  statusDoc["runningMd5"] = getRunningMD5().c_str();
+                  statusDoc["runningSize"] = getRunningSize();
+                  statusDoc["md5"] = _md5.c_str();
+                  statusDoc["received"] = _received;
+                  statusDoc["size"] = _size;
+                  statusDoc["peers"] = countPeers(_peers);
+                  statusDoc["nextGroup"] = _nextGroup;
+
+                  // 支持 Accept: application/msgpack
+                  MessageCodec::send(request, statusDoc); });
+
+    router.on("/api/ota/mirror", HTTP_POST, [this](AsyncWebServerRequest *request)
+              { handleMirrorRequest(request); });
+}
+
+/**
+ * 获取正在运行的固件的MD5
+ */
+const String &PeerOtaMirror::getRunningMD5()
+{
+    if (!_runningMD5.length())
+    {
+        _runningMD5 = ESP.getSketchMD5();
+    }
+    return _runningMD5;
+}
+
+/**
+ * 获取正在运行的固件的大小
+ */
+size_t PeerOtaMirror::getRunningSize()
+{
+    if (!_runningSize)
+    {
+        _runningSize = ESP.getSketchSize();
+    }
+    return _runningSize;
+}
+
+/**
+ * 获取当前状态
+ */
+PeerOtaState PeerOtaMirror::getState() const
+{
+    return _state;
+}
+
+/**
+ * 处理分发指令
+ */
+void PeerOtaMirror::handleMirrorRequest(AsyncWebServerRequest *request)
+{
+    if (_state != PEER_OTA_IDLE || _otaManager->isUpdating())
+    {
+        request->send(409, "application/json", "{\"error\":\"busy\"}");
+        return;
+    }
+
+    if (!request->hasParam("md5", true) || !request->hasParam("source", true))
+    {
+        request->send(400, "application/json", "{\"error\":\"missing_parameter\"}");
+        return;
+    }
+
+    String md5 = request->getParam("md5", true)->value();
+    if (md5.length() != 32)
+    {
+        request->send(400, "application/json", "{\"error\":\"invalid_md5\"}");
+        return;
+    }
+
+    _md5 = md5;
+    _source = request->getParam("source", true)->value();
+    _size = request->hasParam("size", true) ? request->getParam("size", true)->value().toInt() : 0;
+    _peers = request->hasParam("peers", true) ? request->getParam("peers", true)->value() : String();
+    _peers.replace(" ", "");
+    _attempts = 0;
+    _nextAttempt = 0;
+    _received = 0;
+
+    // 下载和MD5计算在主循环中进行
+    _state = PEER_OTA_PULL_START;
+
+    BLOG("收到分发指令, 需要继续分发 %u 台设备\n", countPeers(_peers));
+    request->send(202, "application/json", "{\"type\":\"peer_ota\",\"accepted\":true}");
+}
+
+/**
+ * 输出镜像数据
+ */
+size_t PeerOtaMirror::readImage(uint8_t *buffer, size_t maxLen, size_t index)
+{
+    size_t size = getRunningSize();
+    if (index >= size)
+    {
+        return 0;
+    }
+
+    size_t len = size - index < maxLen ? size - index : maxLen;
+#if defined(ESP32)
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (!running || esp_partition_read(running, index, buffer, len) != ESP_OK)
+    {
+        return 0;
+    }
+#elif defined(ESP8266)
+    // 程序从闪存地址0开始（与ESP.getSketchMD5()一致）
+    if (!ESP.flashRead(index, buffer, len))
+    {
+        return 0;
+    }
+#else
+    return 0;
+#endif
+    return len;
+}
+
+/**
+ * 发起HTTP请求
+ */
+bool PeerOtaMirror::startRequest(const String &url, const String &body)
+{
+    _requestUrl = url;
+    _requestBody = body;
+    _requestCode = -1;
+
+#if defined(ESP32)
+    _request = PEER_OTA_REQUEST_PENDING;
+    if (xTaskCreate(requestTask, "peer_ota_http", PEER_OTA_TASK_STACK, this,
+                    uxTaskPriorityGet(nullptr), nullptr) != pdPASS)
+    {
+        BLOG("无法创建HTTP请求任务\n");
+        _request = PEER_OTA_REQUEST_NONE;
+        return false;
+    }
+#else
+    // ESP8266没有可用的任务，在主循环中同步执行
+    runRequest();
+#endif
+    return true;
+}
+
+/**
+ * 执行HTTP请求并记录结果
+ */
+void PeerOtaMirror::runRequest()
+{
+#if defined(ESP32)
+    const uint16_t timeout = PEER_OTA_HTTP_TIMEOUT;
+#else
+    const uint16_t timeout = PEER_OTA_SYNC_TIMEOUT;
+#endif
+    int code = -1;
+
+    if (_requestBody.length())
+    {
+        WiFiClient client;
+        HTTPClient http;
+#if defined(ESP32)
+        http.setConnectTimeout(timeout);
+#endif
+        http.setTimeout(timeout);
+        if (http.begin(client, _requestUrl))
+        {
+            http.addHeader("Content-Type", "application/x-www-form-urlencoded");
+            code = http.POST(_requestBody);
+            http.end();
+        }
+    }
+    else
+    {
+        // 下载连接保持打开，由continuePull()在主循环中读取
+#if defined(ESP32)
+        _http.setConnectTimeout(timeout);
+#endif
+        _http.setTimeout(timeout);
+        if (_http.begin(_client, _requestUrl))
+        {
+            code = _http.GET();
+        }
+    }
+
+    _requestCode = code;
+    _request = PEER_OTA_REQUEST_DONE;
+}
+
+/**
+ * 后台HTTP请求任务
+ */
+void PeerOtaMirror::requestTask(void *arg)
+{
+#if defined(ESP32)
+    ((PeerOtaMirror *)arg)->runRequest();
+    vTaskDelete(nullptr);
+#endif
+}
+
+/**
+ * 开始下载
+ */
+bool PeerOtaMirror::startPull()
+{
+    _attempts++;
+    BLOG("开始下载固件 (第 %u 次)\n", _attempts);
+
+    // 结果由handle()交给onPullResponse()
+    return startRequest(_source, String());
+}
+
+/**
+ * 下载请求应答后检查大小并开始写入
+ */
+bool PeerOtaMirror::onPullResponse(int code)
+{
+    if (code != HTTP_CODE_OK)
+    {
+        BLOG("下载固件失败, HTTP %d\n", code);
+        _http.end();
+        return false;
+    }
+
+    int length = _http.getSize();
+    if (length <= 0 || (_size && (size_t)length != _size))
+    {
+        BLOG("固件大小不一致: %d\n", length);
+        _http.end();
+        return false;
+    }
+    _size = length;
+
+    if (!_otaManager->beginUpdate(this, 1, _size, _md5.c_str()))
+    {
+        _http.end();
+        return false;
+    }
+
+    _received = 0;
+    _lastData = millis();
+    _state = PEER_OTA_PULLING;
+    return true;
+}
+
+/**
+ * 写入一部分下载的数据
+ */
+void PeerOtaMirror::continuePull()
+{
+    WiFiClient *stream = _http.getStreamPtr();
+    size_t budget = PEER_OTA_READ_PER_LOOP;
+
+    while (budget && _received < _size)
+    {
+        size_t available = stream ? stream->available() : 0;
+        if (!available)
+        {
+            break;
+        }
+
+        size_t len = available < sizeof(_buffer) ? available : sizeof(_buffer);
+        len = len < _size - _received ? len : _size - _received;
+        len = stream->readBytes(_buffer, len);
+        if (!len || !_otaManager->writeUpdate(this, _buffer, len))
+        {
+            failPull("write_failed");
+            return;
+        }
+
+        _received += len;
+        _lastData = millis();
+        budget = len < budget ? budget - len : 0;
+    }
+
+    if (_received < _size)
+    {
+        if (millis() - _lastData > PEER_OTA_STALL_TIMEOUT || (stream && !stream->connected() && !stream->available()))
+        {
+            failPull("stalled");
+        }
+        return;
+    }
+
+    _http.end();
+
+    // 重启前保存状态，新固件启动后继续分发
+    bool saved = !countPeers(_peers) || saveState();
+    if (!_otaManager->endUpdate(this))
+    {
+        clearState();
+        failPull("verify_failed");
+        return;
+    }
+    if (!saved)
+    {
+        BLOG("无法保存分发状态, 重启后不会继续转发\n");
+    }
+
+    // 等待OTAManager安排的重启
+    _state = PEER_OTA_IDLE;
+}
+
+/**
+ * 下载失败
+ */
+void PeerOtaMirror::failPull(const char *reason)
+{
+    BLOG("下载固件失败: %s\n", reason);
+    _otaManager->abortUpdate(this);
+    _http.end();
+
+    if (_attempts < PEER_OTA_MAX_ATTEMPTS)
+    {
+        _nextAttempt = millis() + PEER_OTA_RETRY_INTERVAL;
+        _state = PEER_OTA_PULL_START;
+        return;
+    }
+
+    // 放弃更新自己，但不让下游设备失去固件来源
+    BLOG("放弃下载, 把指令原样转发给下游设备\n");
+    _state = PEER_OTA_FANOUT_WAIT;
+}
+
+/**
+ * 向下一个分组发送指令
+ */
+void PeerOtaMirror::continueFanout()
+{
+    size_t first, count;
+    if (!getGroup(_nextGroup, first, count))
+    {
+        BLOG("分发完成\n");
+        finish();
+        return;
+    }
+
+    if (_groupSkip >= count)
+    {
+        // 整组都不可达
+        _nextGroup++;
+        _groupSkip = 0;
+        _attempts = 0;
+        return;
+    }
+
+    String child = slicePeers(_peers, first + _groupSkip, 1);
+    String rest = slicePeers(_peers, first + _groupSkip + 1, count - _groupSkip - 1);
+
+    String source = _source;
+    if (!source.length())
+    {
+        source = "http://" + WiFi.localIP().toString();
+        if (_httpPort != 80)
+        {
+            source += ':';
+            source += _httpPort;
+        }
+        source += "/api/ota/image";
+    }
+
+    String body;
+    body.reserve(64 + source.length() + rest.length());
+    body = "source=";
+    appendEncoded(body, source);
+    body += "&md5=";
+    body += _md5;
+    body += "&size=";
+    body += _size;
+    body += "&peers=";
+    appendEncoded(body, rest);
+
+    // 结果由handle()交给onFanoutResponse()
+    if (!startRequest("http://" + child + "/api/ota/mirror", body))
+    {
+        onFanoutResponse(-1);
+    }
+}
+
+/**
+ * 处理转发指令的应答
+ */
+void PeerOtaMirror::onFanoutResponse(int code)
+{
+    size_t first, count;
+    if (!getGroup(_nextGroup, first, count))
+    {
+        return;
+    }
+    String child = slicePeers(_peers, first + _groupSkip, 1);
+
+    if (code == 202)
+    {
+        BLOG("已向 %s 转发, 由它继续分发 %u 台设备\n", child.c_str(), count - _groupSkip - 1);
+        _nextGroup++;
+        _groupSkip = 0;
+        _attempts = 0;
+        return;
+    }
+
+    BLOG("向 %s 转发失败, HTTP %d\n", child.c_str(), code);
+    if (++_attempts < PEER_OTA_MAX_ATTEMPTS)
+    {
+        _nextAttempt = millis() + PEER_OTA_RETRY_INTERVAL;
+        return;
+    }
+
+    // 设备不可达，由组内下一台设备接替
+    _groupSkip++;
+    _attempts = 0;
+}
+
+/**
+ * 获取第group个分组的范围
+ */
+bool PeerOtaMirror::getGroup(uint8_t group, size_t &first, size_t &count) const
+{
+    size_t total = countPeers(_peers);
+    size_t groups = total < PEER_OTA_FANOUT ? total : PEER_OTA_FANOUT;
+    if (group >= groups)
+    {
+        return false;
+    }
+
+    // 各组大小相差不超过1，树的深度约为log(设备数)
+    size_t base = total / groups;
+    size_t extra = total % groups;
+    first = group * base + (group < extra ? group : extra);
+    count = base + (group < extra ? 1 : 0);
+    return true;
+}
+
+/**
+ * 保存重启后需要继续的分发状态
+ */
+bool PeerOtaMirror::saveState()
+{
+    File file = _fs.open(PEER_OTA_STATE_FILE, "w");
+    if (!file)
+    {
+        return false;
+    }
+
+    StaticJsonDocument<128> stateDoc;
+    stateDoc["md5"] = _md5.c_str();
+    stateDoc["size"] = _size;
+    stateDoc["peers"] = _peers.c_str();
+    bool ok = serializeJson(stateDoc, file) > 0;
+    file.close();
+    return ok;
+}
+
+/**
+ * 清除分发状态
+ */
+void PeerOtaMirror::clearState()
+{
+    _fs.remove(PEER_OTA_STATE_FILE);
+}
+
+/**
+ * 结束当前分发任务
+ */
+void PeerOtaMirror::finish()
+{
+    _state = PEER_OTA_IDLE;
+    _source = "";
+    _peers = "";
+    _nextGroup = 0;
+    _groupSkip = 0;
+    _attempts = 0;
+}
@@ -0,0 +1,244 @@
+/**
+ * PeerOtaMirror.h
+ *
+ * 设备间固件分发模块，已更新的设备把正在运行的固件提供给其他设备，
+ * 并把分发指令转发下去，形成树状的批量更新
+ *
+ * GET  /api/ota/image   正在运行的固件镜像（响应头 X-Image-MD5）
+ * GET  /api/ota/mirror  分发状态
+ * POST /api/ota/mirror  分发指令（表单字段）:
+ *                       source 固件镜像的URL
+ *                       md5    镜像MD5
+ *                       size   镜像大小
+ *                       peers  需要继续分发的设备，逗号分隔的 "主机[:端口]"
+ *
+ * 收到指令的设备从source下载固件（已在运行同一固件时跳过），重启后把peers
+ * 分成PEER_OTA_FANOUT组，向每组的第一台设备发送以自己为source的指令，
+ * 组内其余设备由它继续分发
+ *
+ * 建立下载连接和发送指令可能阻塞到超时，ESP32上在独立任务中执行，
+ * handle()只检查结果；ESP8266没有可用的任务，使用较短的超时同步执行
+ *
+ * @file PeerOtaMirror.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef PEER_OTA_MIRROR_H
+#define PEER_OTA_MIRROR_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+#include "ApiRouter.h"
+
+#if defined(ESP8266)
+#include <ESP8266HTTPClient.h>
+#else
+#include <HTTPClient.h>
+#endif
+
+// 分发配置
+#define PEER_OTA_FANOUT 2                    // 每台设备转发的分支数
+#define PEER_OTA_STATE_FILE "/peer_ota.json" // 重启后继续分发的状态文件
+#define PEER_OTA_BUFFER 1024                 // 下载缓冲区大小
+#define PEER_OTA_READ_PER_LOOP 8192          // 每次handle()最多写入的字节数
+#define PEER_OTA_STALL_TIMEOUT 15000         // 下载无数据超时（毫秒）
+#define PEER_OTA_MAX_ATTEMPTS 3              // 下载和转发的最多尝试次数
+#define PEER_OTA_RETRY_INTERVAL 5000         // 重试间隔（毫秒）
+#define PEER_OTA_HTTP_TIMEOUT 5000           // HTTP连接和应答超时（毫秒，ESP32后台任务）
+#define PEER_OTA_SYNC_TIMEOUT 1000           // HTTP连接和应答超时（毫秒，ESP8266在主循环中同步执行）
+#define PEER_OTA_TASK_STACK 6144             // 后台HTTP请求任务的栈大小
+
+// 分发状态
+enum PeerOtaState
+{
+    PEER_OTA_IDLE,        // 空闲
+    PEER_OTA_PULL_START,  // 等待开始下载
+    PEER_OTA_PULLING,     // 下载中
+    PEER_OTA_FANOUT_WAIT, // 等待WiFi连接后转发
+    PEER_OTA_FANOUT       // 转发中
+};
+
+// 后台HTTP请求状态
+enum PeerOtaRequest : uint8_t
+{
+    PEER_OTA_REQUEST_NONE,    // 没有请求
+    PEER_OTA_REQUEST_PENDING, // 请求进行中
+    PEER_OTA_REQUEST_DONE     // 已完成，等待handle()处理结果
+};
+
+// 前向声明
+class OTAManager;
+
+/**
+ * 设备间固件分发类
+ */
+class PeerOtaMirror
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param otaManager OTA管理器，用于写入下载的固件
+     * @param fs 保存分发状态的文件系统
+     * @param httpPort 本机Web服务器端口，用于生成source URL
+     */
+    PeerOtaMirror(OTAManager *otaManager, fs::FS &fs, uint16_t httpPort = 80);
+
+    /**
+     * 读取重启前保存的分发状态
+     *
+     * 正在运行的固件与保存的MD5一致时，WiFi连接后继续向peers分发
+     */
+    void begin();
+
+    /**
+     * 推进下载和转发，需要在loop()中调用
+     */
+    void handle();
+
+    /**
+     * 注册API路由
+     *
+     * @param router API路由器，路由与库的其他API一起分发并记录延迟统计
+     */
+    void attach(ApiRouter &router);
+
+    /**
+     * 获取正在运行的固件的MD5（首次调用时计算）
+     *
+     * @return MD5（十六进制）
+     */
+    const String &getRunningMD5();
+
+    /**
+     * 获取正在运行的固件的大小
+     *
+     * @return 字节数
+     */
+    size_t getRunningSize();
+
+    /**
+     * 获取当前状态
+     */
+    PeerOtaState getState() const;
+
+private:
+    OTAManager *_otaManager; // OTA管理器
+    fs::FS &_fs;             // 文件系统
+    uint16_t _httpPort;      // 本机Web服务器端口
+    String _runningMD5;      // 正在运行的固件MD5（缓存）
+    size_t _runningSize;     // 正在运行的固件大小（缓存）
+
+    // 当前分发任务
+    PeerOtaState _state;        // 状态
+    String _source;             // 固件镜像URL
+    String _md5;                // 镜像MD5
+    size_t _size;               // 镜像大小
+    String _peers;              // 需要继续分发的设备
+    uint8_t _attempts;          // 当前步骤已尝试次数
+    unsigned long _nextAttempt; // 下次尝试的时间
+    uint8_t _nextGroup;         // 下一个需要转发的分组
+    size_t _groupSkip;          // 当前分组中已跳过的不可达设备数
+
+    // 下载状态
+    WiFiClient _client;               // 下载连接
+    HTTPClient _http;                 // HTTP客户端
+    size_t _received;                 // 已写入的字节数
+    unsigned long _lastData;          // 上次收到数据的时间
+    uint8_t _buffer[PEER_OTA_BUFFER]; // 下载缓冲区
+
+    // 后台HTTP请求，进行中时只由请求任务访问
+    volatile PeerOtaRequest _request; // 请求状态
+    int _requestCode;                 // HTTP状态码或负数错误码
+    String _requestUrl;               // 请求URL
+    String _requestBody;              // POST内容，为空时是下载固件的GET请求
+
+    /**
+     * 处理分发指令
+     */
+    void handleMirrorRequest(AsyncWebServerRequest *request);
+
+    /**
+     * 输出镜像数据
+     */
+    size_t readImage(uint8_t *buffer, size_t maxLen, size_t index);
+
+    /**
+     * 发起HTTP请求，ESP32上在后台任务中执行
+     *
+     * @param url 请求URL
+     * @param body POST内容，为空时以GET开始下载固件
+     * @return 是否已发起
+     */
+    bool startRequest(const String &url, const String &body);
+
+    /**
+     * 执行HTTP请求并记录结果
+     */
+    void runRequest();
+
+    /**
+     * 后台HTTP请求任务
+     */
+    static void requestTask(void *arg);
+
+    /**
+     * 开始下载
+     */
+    bool startPull();
+
+    /**
+     * 下载请求应答后检查大小并开始写入
+     *
+     * @param code HTTP状态码
+     */
+    bool onPullResponse(int code);
+
+    /**
+     * 写入一部分下载的数据
+     */
+    void continuePull();
+
+    /**
+     * 下载失败，重试或把指令原样转发给peers
+     */
+    void failPull(const char *reason);
+
+    /**
+     * 向下一个分组发送指令
+     */
+    void continueFanout();
+
+    /**
+     * 处理转发指令的应答
+     *
+     * @param code HTTP状态码
+     */
+    void onFanoutResponse(int code);
+
+    /**
+     * 获取第group个分组的范围
+     *
+     * @param group 分组序号
+     * @param first 输出：分组中第一台设备的序号
+     * @param count 输出：分组中的设备数量
+     * @return 分组是否存在
+     */
+    bool getGroup(uint8_t group, size_t &first, size_t &count) const;
+
+    /**
+     * 保存和清除重启后需要继续的分发状态
+     */
+    bool saveState();
+    void clearState();
+
+    /**
+     * 结束当前分发任务
+     */
+    void finish();
+};
+
+#endif // PEER_OTA_MIRROR_H
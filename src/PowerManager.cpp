@@ -0,0 +1,460 @@
+/**
+ * PowerManager.cpp
+ *
+ * 电源管理模块的实现
+ *
+ * @file PowerManager.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "PowerManager.h"
+#include "MessageCodec.h"
+#include "MetricsRegistry.h"
+#include "BinaryLog.h"
+#include <ArduinoJson.h>
+
+#if defined(ESP8266)
+#include <ESP8266WiFi.h>
+#else
+#include <WiFi.h>
+#endif
+
+#if defined(ESP32)
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <esp_idf_version.h>
+#if CONFIG_PM_ENABLE && (ESP_IDF_VERSION_MAJOR >= 5 || CONFIG_IDF_TARGET_ESP32)
+#include <esp_pm.h>
+#define POWER_HAS_AUTO_LIGHT_SLEEP 1
+#endif
+#endif
+
+static MetricCounter powerActiveMetric("power_state_milliseconds", "各电源状态的累计时间", "state=\"active\"");
+static MetricCounter powerIdleMetric("power_state_milliseconds", "各电源状态的累计时间", "state=\"idle\"");
+static MetricCounter powerSleepMetric("power_state_milliseconds", "各电源状态的累计时间", "state=\"sleep\"");
+static MetricGauge powerStateMetric("power_state", "当前电源状态（0: 活跃, 1: 空闲, 2: 睡眠）");
+static const uint32_t overshootBounds[] = {100, 500, 1000, 2000, 5000, 10000, 50000};
+static MetricHistogram overshootMetric("power_sleep_overshoot_microseconds", "主循环比截止时间晚恢复的时间（调度延迟）",
+                                       overshootBounds, sizeof(overshootBounds) / sizeof(overshootBounds[0]));
+
+static MetricCounter *const stateMetrics[POWER_STATE_COUNT] = {&powerActiveMetric, &powerIdleMetric, &powerSleepMetric};
+
+/**
+ * 获取微秒时间戳（64位，不回绕）
+ */
+static uint64_t nowMicros()
+{
+#if defined(ESP32)
+    return esp_timer_get_time();
+#elif defined(ESP8266)
+    return micros64();
+#else
+    return micros();
+#endif
+}
+
+/**
+ * 构造函数
+ */
+PowerManager::PowerManager() : _enabled(false),
+                               _lightSleep(false),
+                               _state(POWER_STATE_ACTIVE),
+                               _maxSleep(POWER_MAX_IDLE_SLEEP),
+                               _lastActivity(0),
+                               _lastAccount(0),
+                               _stateSince(0),
+                               _overshoot(),
+                               _activityCount(0),
+                               _deadlineCount(0)
+{
+    memset(_stateMicros, 0, sizeof(_stateMicros));
+    memset(_exportedMillis, 0, sizeof(_exportedMillis));
+}
+
+/**
+ * 开始计时
+ */
+void PowerManager::begin()
+{
+    _stateSince = nowMicros();
+    _lastAccount = millis();
+}
+
+/**
+ * 更新电源状态
+ */
+void PowerManager::handle()
+{
+    unsigned long now = millis();
+
+    // 长时间停留在同一状态时也定期更新指标
+    if (now - _lastAccount >= 1000)
+    {
+        _lastAccount = now;
+        account(nowMicros());
+    }
+
+    if (!_enabled)
+    {
+        return;
+    }
+
+    if (isActive(now))
+    {
+        if (_state != POWER_STATE_ACTIVE)
+        {
+            enterState(POWER_STATE_ACTIVE);
+        }
+        return;
+    }
+
+    if (_state == POWER_STATE_ACTIVE)
+    {
+        enterState(POWER_STATE_IDLE);
+    }
+
+    uint32_t wait = nextDeadline(now);
+    if (wait >= POWER_MIN_IDLE_SLEEP)
+    {
+        sleep(wait);
+    }
+}
+
+/**
+ * 启用或禁用省电
+ */
+void PowerManager::setEnabled(bool enable)
+{
+    if (enable == _enabled)
+    {
+        return;
+    }
+    _enabled = enable;
+
+    if (enable)
+    {
+        // 从活跃状态开始，由handle()根据活动情况切换
+        _lastActivity = millis();
+        applyRadio(POWER_STATE_ACTIVE);
+    }
+    else if (_state != POWER_STATE_ACTIVE)
+    {
+        enterState(POWER_STATE_ACTIVE);
+    }
+    BLOG("省电模式: %d\n", enable ? 1 : 0);
+}
+
+/**
+ * 是否已启用省电
+ */
+bool PowerManager::isEnabled() const
+{
+    return _enabled;
+}
+
+/**
+ * 空闲时允许CPU进入自动light-sleep
+ */
+bool PowerManager::enableLightSleep(bool enable)
+{
+#if defined(POWER_HAS_AUTO_LIGHT_SLEEP)
+    // 由电源管理驱动在空闲任务中进入light-sleep，WiFi不休眠时驱动持有锁，不会进入
+#if ESP_IDF_VERSION_MAJOR >= 5
+    esp_pm_config_t config;
+#else
+    esp_pm_config_esp32_t config;
+#endif
+    config.max_freq_mhz = getCpuFrequencyMhz();
+    config.min_freq_mhz = enable ? getXtalFrequencyMhz() : config.max_freq_mhz;
+    config.light_sleep_enable = enable;
+
+    esp_err_t err = esp_pm_configure(&config);
+    if (err != ESP_OK)
+    {
+        BLOG("无法配置自动light-sleep, 错误 %d\n", err);
+        _lightSleep = false;
+        return false;
+    }
+    _lightSleep = enable;
+    return true;
+#elif defined(ESP8266)
+    _lightSleep = enable;
+    if (_enabled && _state != POWER_STATE_ACTIVE)
+    {
+        applyRadio(_state);
+    }
+    return true;
+#else
+    (void)enable;
+    return false;
+#endif
+}
+
+/**
+ * 设置空闲时主循环单次最长等待时间
+ */
+void PowerManager::setMaxSleep(uint32_t ms)
+{
+    _maxSleep = ms;
+}
+
+/**
+ * 注册活动来源
+ */
+bool PowerManager::addActivitySource(PowerActivitySource source)
+{
+    if (_activityCount >= POWER_MAX_SOURCES)
+    {
+        Serial.println("活动来源数量已达上限");
+        return false;
+    }
+
+    _activity[_activityCount++] = source;
+    return true;
+}
+
+/**
+ * 注册截止时间来源
+ */
+bool PowerManager::addDeadlineSource(PowerDeadlineSource source)
+{
+    if (_deadlineCount >= POWER_MAX_SOURCES)
+    {
+        Serial.println("截止时间来源数量已达上限");
+        return false;
+    }
+
+    _deadlines[_deadlineCount++] = source;
+    return true;
+}
+
+/**
+ * 记录一次活动
+ */
+void PowerManager::notifyActivity()
+{
+    _lastActivity = millis();
+}
+
+/**
+ * 获取当前电源状态
+ */
+PowerState PowerManager::getState() const
+{
+    return _state;
+}
+
+/**
+ * 获取在某个状态的累计时间
+ */
+uint32_t PowerManager::getStateTime(PowerState state) const
+{
+    if (state >= POWER_STATE_COUNT)
+    {
+        return 0;
+    }
+
+    uint64_t total = _stateMicros[state];
+    if (state == _state)
+    {
+        total += nowMicros() - _stateSince;
+    }
+    return total / 1000;
+}
+
+/**
+ * 获取唤醒延迟统计
+ */
+const PowerOvershootStats &PowerManager::getSleepOvershoot() const
+{
+    return _overshoot;
+}
+
+/**
+ * 注册API路由
+ */
+void PowerManager::attach(ApiRouter &router)
+{
+    router.on("/api/power", HTTP_GET, [this](AsyncWebServerRequest *request)
+              {
+                  StaticJsonDocument<384> powerDoc;
+                  powerDoc["type"] = "power";
+                  powerDoc["enabled"] = _enabled;
+                  powerDoc["lightSleep"] = _lightSleep;
+                  powerDoc["state"] = stateName(_state);
+                  powerDoc["maxSleep"] = _maxSleep;
+
+                  JsonObject time = powerDoc.createNestedObject("time");
+                  for (uint8_t i = 0; i < POWER_STATE_COUNT; i++)
+                  {
+                      time[stateName((PowerState)i)] = getStateTime((PowerState)i);
+                  }
+
+                  JsonObject overshoot = powerDoc.createNestedObject("sleepOvershoot");
+                  overshoot["count"] = _overshoot.count;
+                  overshoot["last"] = _overshoot.last;
+                  overshoot["max"] = _overshoot.max;
+                  overshoot["avg"] = _overshoot.count ? (uint32_t)(_overshoot.total / _overshoot.count) : 0;
+
+                  MessageCodec::send(request, powerDoc); });
+
+    router.on("/api/power", HTTP_POST, [this](AsyncWebServerRequest *request)
+              {
+                  if (request->hasParam("enabled", true))
+                  {
+                      setEnabled(request->getParam("enabled", true)->value().toInt() != 0);
+                  }
+                  if (request->hasParam("lightSleep", true) &&
+                      !enableLightSleep(request->getParam("lightSleep", true)->value().toInt() != 0))
+                  {
+                      request->send(501, "application/json", "{\"error\":\"light_sleep_unsupported\"}");
+                      return;
+                  }
+                  request->send(200, "application/json", "{\"success\":true}"); });
+}
+
+/**
+ * 获取状态名称
+ */
+const char *PowerManager::stateName(PowerState state)
+{
+    static const char *names[POWER_STATE_COUNT] = {"active", "idle", "sleep"};
+    return state < POWER_STATE_COUNT ? names[state] : "unknown";
+}
+
+/**
+ * 根据活动来源判断是否需要保持活跃
+ */
+bool PowerManager::isActive(unsigned long now)
+{
+    for (uint8_t i = 0; i < _activityCount; i++)
+    {
+        if (_activity[i]())
+        {
+            // 活动结束后同样保持一段时间，避免客户端重连时反复切换
+            _lastActivity = now;
+            return true;
+        }
+    }
+    return now - _lastActivity < POWER_ACTIVITY_HOLD;
+}
+
+/**
+ * 计算距离最近截止时间的毫秒数
+ */
+uint32_t PowerManager::nextDeadline(unsigned long now)
+{
+    uint32_t wait = _maxSleep;
+    for (uint8_t i = 0; i < _deadlineCount && wait > 0; i++)
+    {
+        uint32_t deadline = _deadlines[i](now);
+        if (deadline < wait)
+        {
+            wait = deadline;
+        }
+    }
+    return wait;
+}
+
+/**
+ * 累计当前状态的时间并更新指标
+ */
+void PowerManager::account(uint64_t now)
+{
+    _stateMicros[_state] += now - _stateSince;
+    _stateSince = now;
+
+    // 指标以毫秒计数，32位回绕与计数器重置的处理方式相同
+    uint32_t millisTotal = (uint32_t)(_stateMicros[_state] / 1000);
+    stateMetrics[_state]->inc(millisTotal - _exportedMillis[_state]);
+    _exportedMillis[_state] = millisTotal;
+}
+
+/**
+ * 切换状态
+ */
+void PowerManager::enterState(PowerState state)
+{
+    account(nowMicros());
+
+    bool wasActive = _state == POWER_STATE_ACTIVE;
+    _state = state;
+    powerStateMetric.set(state);
+
+    // 空闲和睡眠之间只是主循环是否在等待，WiFi设置不变
+    if (wasActive != (state == POWER_STATE_ACTIVE))
+    {
+        applyRadio(state);
+    }
+}
+
+/**
+ * 按状态配置WiFi省电模式
+ */
+void PowerManager::applyRadio(PowerState state)
+{
+#if defined(ESP32)
+    if (state != POWER_STATE_ACTIVE)
+    {
+        // 最大modem-sleep按监听间隔接收信标，下行数据在AP缓存到下次唤醒；
+        // 监听间隔也随关联请求告知AP，已连接时下次关联生效
+        wifi_config_t config;
+        if (esp_wifi_get_config(WIFI_IF_STA, &config) == ESP_OK && config.sta.listen_interval != POWER_LISTEN_INTERVAL)
+        {
+            config.sta.listen_interval = POWER_LISTEN_INTERVAL;
+            esp_err_t err = esp_wifi_set_config(WIFI_IF_STA, &config);
+            if (err != ESP_OK)
+            {
+                BLOG("无法设置WiFi监听间隔, 错误 %d\n", err);
+            }
+        }
+    }
+
+    esp_err_t err = esp_wifi_set_ps(state == POWER_STATE_ACTIVE ? WIFI_PS_NONE : WIFI_PS_MAX_MODEM);
+    if (err != ESP_OK)
+    {
+        BLOG("无法设置WiFi省电模式, 错误 %d\n", err);
+    }
+#elif defined(ESP8266)
+    if (state == POWER_STATE_ACTIVE)
+    {
+        WiFi.setSleepMode(WIFI_NONE_SLEEP);
+    }
+    else
+    {
+        WiFi.setSleepMode(_lightSleep ? WIFI_LIGHT_SLEEP : WIFI_MODEM_SLEEP, POWER_LISTEN_INTERVAL);
+    }
+#else
+    (void)state;
+#endif
+}
+
+/**
+ * 空闲时等待，并记录超出计划的时间
+ */
+void PowerManager::sleep(uint32_t ms)
+{
+    enterState(POWER_STATE_SLEEP);
+    uint64_t start = _stateSince;
+
+    // 主循环任务阻塞，空闲任务运行，CPU降频或进入light-sleep
+    delay(ms);
+
+    uint64_t elapsed = nowMicros() - start;
+    uint64_t planned = (uint64_t)ms * 1000;
+    // 这是调度器让主循环恢复的延迟，不是WiFi从modem-sleep唤醒的延迟
+    uint32_t overshoot = elapsed > planned ? (uint32_t)(elapsed - planned) : 0;
+
+    _overshoot.count++;
+    _overshoot.last = overshoot;
+    _overshoot.total += overshoot;
+    if (overshoot > _overshoot.max)
+    {
+        _overshoot.max = overshoot;
+    }
+    overshootMetric.observe(overshoot);
+
+    enterState(POWER_STATE_IDLE);
+}
@@ -0,0 +1,221 @@
+/**
+ * PowerManager.h
+ *
+ * 电源管理模块，按活动情况切换WiFi省电模式，空闲时让主循环等待到下一个模块的截止时间
+ *
+ * 活跃（有WebSocket客户端、OTA进行中或最近有活动）: WiFi不休眠，主循环不等待，延迟最低
+ * 空闲: WiFi最大modem-sleep（每隔监听间隔个信标周期接收一次），主循环等待到
+ *       下一个截止时间（最长POWER_MAX_IDLE_SLEEP），期间CPU可进入light-sleep
+ *
+ * @file PowerManager.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <ESPAsyncWebServer.h>
+#include "ApiRouter.h"
+
+// 电源管理配置
+#define POWER_MAX_SOURCES 8          // 最多注册的活动来源和截止时间来源数量
+#define POWER_ACTIVITY_HOLD 10000    // 最后一次活动后保持活跃状态的时间（毫秒）
+#define POWER_MAX_IDLE_SLEEP 100     // 空闲时主循环单次最长等待（毫秒），也是新连接的最大额外延迟
+#define POWER_MIN_IDLE_SLEEP 2       // 短于此时间的等待不值得进入睡眠（毫秒）
+#define POWER_LISTEN_INTERVAL 3      // 空闲时的WiFi监听间隔（信标周期）
+#define POWER_NO_DEADLINE 0xFFFFFFFF // 截止时间来源：暂时不需要主循环
+
+// 电源状态
+enum PowerState : uint8_t
+{
+    POWER_STATE_ACTIVE, // 活跃：WiFi不休眠
+    POWER_STATE_IDLE,   // 空闲：WiFi modem-sleep，主循环在运行
+    POWER_STATE_SLEEP,  // 空闲：主循环在等待下一个截止时间
+    POWER_STATE_COUNT
+};
+
+/**
+ * 活动来源
+ *
+ * @return 是否需要保持活跃状态（低延迟）
+ */
+typedef std::function<bool()> PowerActivitySource;
+
+/**
+ * 截止时间来源
+ *
+ * @param now 当前时间（millis）
+ * @return 距离模块下次需要主循环的毫秒数, 0表示立即, POWER_NO_DEADLINE表示不需要
+ */
+typedef std::function<uint32_t(unsigned long now)> PowerDeadlineSource;
+
+// 睡眠超出时间统计（微秒）：主循环实际恢复时间比计划的截止时间晚多少，反映调度延迟
+struct PowerOvershootStats
+{
+    uint32_t count; // 睡眠次数
+    uint32_t last;  // 最近一次
+    uint32_t max;   // 最大值
+    uint64_t total; // 总和，用于计算平均值
+};
+
+/**
+ * 电源管理器类
+ */
+class PowerManager
+{
+public:
+    /**
+     * 构造函数
+     */
+    PowerManager();
+
+    /**
+     * 开始计时，默认不启用省电
+     */
+    void begin();
+
+    /**
+     * 更新电源状态，空闲时等待到下一个截止时间，需要在loop()的最后调用
+     */
+    void handle();
+
+    /**
+     * 启用或禁用省电
+     *
+     * 禁用时恢复WiFi不休眠，主循环不再等待
+     *
+     * @param enable 是否启用
+     */
+    void setEnabled(bool enable);
+
+    /**
+     * 是否已启用省电
+     */
+    bool isEnabled() const;
+
+    /**
+     * 空闲时允许CPU进入自动light-sleep
+     *
+     * ESP32需要固件启用CONFIG_PM_ENABLE和CONFIG_FREERTOS_USE_TICKLESS_IDLE，
+     * 否则只降低WiFi功耗
+     *
+     * @param enable 是否启用
+     * @return 当前平台是否支持
+     */
+    bool enableLightSleep(bool enable);
+
+    /**
+     * 设置空闲时主循环单次最长等待时间
+     *
+     * @param ms 毫秒，越大越省电，新WebSocket连接和未注册截止时间的任务等待越久
+     */
+    void setMaxSleep(uint32_t ms);
+
+    /**
+     * 注册活动来源，任一来源返回true时保持活跃状态
+     *
+     * @param source 活动来源
+     * @return 是否注册成功
+     */
+    bool addActivitySource(PowerActivitySource source);
+
+    /**
+     * 注册截止时间来源，空闲时主循环等待到最近的截止时间
+     *
+     * @param source 截止时间来源
+     * @return 是否注册成功
+     */
+    bool addDeadlineSource(PowerDeadlineSource source);
+
+    /**
+     * 记录一次活动，之后POWER_ACTIVITY_HOLD毫秒内保持活跃状态
+     *
+     * 可以在HTTP处理函数等任意任务中调用
+     */
+    void notifyActivity();
+
+    /**
+     * 获取当前电源状态
+     */
+    PowerState getState() const;
+
+    /**
+     * 获取在某个状态的累计时间
+     *
+     * @param state 电源状态
+     * @return 毫秒
+     */
+    uint32_t getStateTime(PowerState state) const;
+
+    /**
+     * 获取睡眠超出时间统计
+     */
+    const PowerOvershootStats &getSleepOvershoot() const;
+
+    /**
+     * 注册API路由
+     *
+     * GET /api/power  当前状态、各状态累计时间和睡眠超出时间
+     * POST /api/power 表单字段 enabled=0|1, lightSleep=0|1
+     *
+     * @param router API路由器，路由与库的其他API一起分发并记录延迟统计
+     */
+    void attach(ApiRouter &router);
+
+    /**
+     * 获取状态名称
+     */
+    static const char *stateName(PowerState state);
+
+private:
+    bool _enabled;                                     // 是否启用省电
+    bool _lightSleep;                                  // 是否启用自动light-sleep
+    PowerState _state;                                 // 当前状态
+    uint32_t _maxSleep;                                // 主循环单次最长等待
+    volatile unsigned long _lastActivity;              // 最后一次活动的时间
+    unsigned long _lastAccount;                        // 上次更新指标的时间
+    uint64_t _stateSince;                              // 当前状态开始计时的时间（微秒）
+    uint64_t _stateMicros[POWER_STATE_COUNT];          // 各状态的累计时间（微秒）
+    uint32_t _exportedMillis[POWER_STATE_COUNT];       // 已计入指标的毫秒数
+    PowerOvershootStats _overshoot;                    // 睡眠超出时间统计
+    PowerActivitySource _activity[POWER_MAX_SOURCES];  // 活动来源
+    uint8_t _activityCount;                            // 活动来源数量
+    PowerDeadlineSource _deadlines[POWER_MAX_SOURCES]; // 截止时间来源
+    uint8_t _deadlineCount;                            // 截止时间来源数量
+
+    /**
+     * 根据活动来源判断是否需要保持活跃
+     */
+    bool isActive(unsigned long now);
+
+    /**
+     * 计算距离最近截止时间的毫秒数
+     */
+    uint32_t nextDeadline(unsigned long now);
+
+    /**
+     * 累计当前状态的时间并更新指标
+     */
+    void account(uint64_t now);
+
+    /**
+     * 切换状态，累计上一状态的时间
+     */
+    void enterState(PowerState state);
+
+    /**
+     * 按状态配置WiFi省电模式
+     */
+    void applyRadio(PowerState state);
+
+    /**
+     * 空闲时等待，并记录超出计划的时间
+     */
+    void sleep(uint32_t ms);
+};
+
+#endif // POWER_MANAGER_H
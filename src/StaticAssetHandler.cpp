@@ -0,0 +1,374 @@
+/**
+ * StaticAssetHandler.cpp
+ *
+ * 静态Web资源处理模块的实现
+ *
+ * @file StaticAssetHandler.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "StaticAssetHandler.h"
+
+namespace
+{
+    // FNV-1a 32位哈希参数
+    const uint32_t FNV_OFFSET_BASIS = 2166136261UL;
+    const uint32_t FNV_PRIME = 16777619UL;
+
+    inline uint32_t fnv1a(uint32_t hash, const uint8_t *data, size_t len)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            hash ^= data[i];
+            hash *= FNV_PRIME;
+        }
+        return hash;
+    }
+}
+
+/**
+ * 构造函数
+ */
+StaticAssetHandler::StaticAssetHandler(fs::FS &fs, const char *uriPrefix, const char *fsRoot) : _fs(fs),
+                                                                                              _uriPrefix(uriPrefix),
+                                                                                              _fsRoot(fsRoot),
+                                                                                              _cacheControl("no-cache"),
+                                                                                              _ramBudget(STATIC_ASSET_DEFAULT_BUDGET),
+                                                                                              _ramUsage(0),
+                                                                                              _useCounter(0)
+{
+    if (_fsRoot.endsWith("/"))
+    {
+        _fsRoot.remove(_fsRoot.length() - 1);
+    }
+    invalidate();
+}
+
+/**
+ * 设置Cache-Control头
+ */
+void StaticAssetHandler::setCacheControl(const char *cacheControl)
+{
+    _cacheControl = cacheControl;
+}
+
+/**
+ * 设置内存缓存预算
+ */
+void StaticAssetHandler::setRamCacheBudget(size_t bytes)
+{
+    _ramBudget = bytes;
+    reserveRam(0, nullptr);
+}
+
+/**
+ * 清空所有缓存
+ */
+void StaticAssetHandler::invalidate()
+{
+    for (uint8_t i = 0; i < STATIC_ASSET_MAX_ENTRIES; i++)
+    {
+        releaseData(&_entries[i]);
+        _entries[i].path[0] = '\0';
+        _entries[i].lastUsed = 0;
+    }
+}
+
+/**
+ * 获取内存缓存当前占用
+ */
+size_t StaticAssetHandler::getRamCacheUsage() const
+{
+    return _ramUsage;
+}
+
+/**
+ * 判断请求是否由本处理器处理
+ */
+bool StaticAssetHandler::canHandle(AsyncWebServerRequest *request)
+{
+    if (request->method() != HTTP_GET && request->method() != HTTP_HEAD)
+    {
+        return false;
+    }
+
+    String path;
+    if (!mapPath(request->url(), path))
+    {
+        return false;
+    }
+
+    // 已缓存的路径无需访问文件系统
+    bool known = false;
+    for (uint8_t i = 0; i < STATIC_ASSET_MAX_ENTRIES && !known; i++)
+    {
+        known = path == _entries[i].path;
+    }
+    if (!known && !_fs.exists(path) && !_fs.exists(path + ".gz"))
+    {
+        return false;
+    }
+
+    request->addInterestingHeader("If-None-Match");
+    request->addInterestingHeader("Accept-Encoding");
+    return true;
+}
+
+/**
+ * 处理静态资源请求
+ */
+void StaticAssetHandler::handleRequest(AsyncWebServerRequest *request)
+{
+    String path;
+    mapPath(request->url(), path);
+
+    bool acceptGzip = request->hasHeader("Accept-Encoding") &&
+                      request->header("Accept-Encoding").indexOf("gzip") >= 0;
+
+    CachedAsset *asset = getAsset(path, acceptGzip);
+    if (!asset)
+    {
+        // 路径过长无法缓存时直接从文件系统发送
+        if (_fs.exists(path))
+        {
+            request->send(_fs, path, contentTypeFor(path));
+        }
+        else
+        {
+            request->send(404);
+        }
+        return;
+    }
+
+    AsyncWebServerResponse *response;
+    bool notModified = request->hasHeader("If-None-Match") &&
+                       request->header("If-None-Match") == asset->etag;
+
+    if (notModified)
+    {
+        // 客户端缓存仍然有效
+        response = request->beginResponse(304);
+    }
+    else if (asset->data)
+    {
+        // 从内存缓存发送，回调持有数据的引用，淘汰条目不影响进行中的响应
+        std::shared_ptr<uint8_t> data = asset->data;
+        size_t size = asset->size;
+        response = request->beginResponse(asset->contentType, size,
+                                          [data, size](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                          {
+                                              size_t len = size - index;
+                                              if (len > maxLen)
+                                              {
+                                                  len = maxLen;
+                                              }
+                                              memcpy(buffer, data.get() + index, len);
+                                              return len;
+                                          });
+    }
+    else
+    {
+        response = request->beginResponse(_fs, asset->gzip ? path + ".gz" : path, asset->contentType);
+    }
+
+    if (asset->gzip && !notModified)
+    {
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset->etag);
+    response->addHeader("Cache-Control", _cacheControl);
+    response->addHeader("Vary", "Accept-Encoding");
+    request->send(response);
+}
+
+/**
+ * 将请求URL映射为文件路径
+ */
+bool StaticAssetHandler::mapPath(const String &url, String &path) const
+{
+    if (!url.startsWith(_uriPrefix) || url.indexOf("..") >= 0)
+    {
+        return false;
+    }
+
+    String relative = url.substring(_uriPrefix.length());
+    if (!relative.startsWith("/"))
+    {
+        relative = "/" + relative;
+    }
+
+    path = _fsRoot + relative;
+    if (path.endsWith("/"))
+    {
+        path += "index.html";
+    }
+    return true;
+}
+
+/**
+ * 查找或加载资源
+ */
+CachedAsset *StaticAssetHandler::getAsset(const String &path, bool acceptGzip)
+{
+    for (uint8_t i = 0; i < STATIC_ASSET_MAX_ENTRIES; i++)
+    {
+        CachedAsset *entry = &_entries[i];
+        if (entry->acceptGzip == acceptGzip && path == entry->path)
+        {
+            entry->lastUsed = ++_useCounter;
+            return entry;
+        }
+    }
+
+    if (path.length() >= STATIC_ASSET_PATH_LENGTH)
+    {
+        return nullptr;
+    }
+
+    bool gzip = acceptGzip && _fs.exists(path + ".gz");
+    File file = _fs.open(gzip ? path + ".gz" : path, "r");
+    if (!file || file.isDirectory())
+    {
+        return nullptr;
+    }
+
+    CachedAsset *entry = allocateEntry();
+    strlcpy(entry->path, path.c_str(), sizeof(entry->path));
+    entry->contentType = contentTypeFor(path);
+    entry->acceptGzip = acceptGzip;
+    entry->gzip = gzip;
+    entry->size = file.size();
+    entry->lastUsed = ++_useCounter;
+
+    // 压缩与未压缩版本的内容不同，ETag也必须不同
+    uint8_t variant = gzip ? 1 : 0;
+    uint32_t hash = fnv1a(FNV_OFFSET_BASIS, &variant, 1);
+
+    if (entry->size <= STATIC_ASSET_MAX_CACHED_FILE && reserveRam(entry->size, entry))
+    {
+        uint8_t *buffer = (uint8_t *)malloc(entry->size ? entry->size : 1);
+        if (buffer && file.read(buffer, entry->size) == entry->size)
+        {
+            entry->data = std::shared_ptr<uint8_t>(buffer, free);
+            _ramUsage += entry->size;
+            hash = fnv1a(hash, buffer, entry->size);
+        }
+        else
+        {
+            free(buffer);
+            file.seek(0);
+        }
+    }
+
+    if (!entry->data)
+    {
+        // 不缓存内容时只流式计算哈希
+        uint8_t chunk[256];
+        size_t len;
+        while ((len = file.read(chunk, sizeof(chunk))) > 0)
+        {
+            hash = fnv1a(hash, chunk, len);
+        }
+    }
+    file.close();
+
+    snprintf(entry->etag, sizeof(entry->etag), "\"%08lx\"", (unsigned long)hash);
+    return entry;
+}
+
+/**
+ * 为新资源分配条目
+ */
+CachedAsset *StaticAssetHandler::allocateEntry()
+{
+    CachedAsset *victim = &_entries[0];
+    for (uint8_t i = 0; i < STATIC_ASSET_MAX_ENTRIES; i++)
+    {
+        if (_entries[i].path[0] == '\0')
+        {
+            return &_entries[i];
+        }
+        if (_entries[i].lastUsed < victim->lastUsed)
+        {
+            victim = &_entries[i];
+        }
+    }
+
+    releaseData(victim);
+    victim->path[0] = '\0';
+    return victim;
+}
+
+/**
+ * 释放条目的内存内容
+ */
+void StaticAssetHandler::releaseData(CachedAsset *entry)
+{
+    if (entry->data)
+    {
+        _ramUsage -= entry->size;
+        entry->data.reset();
+    }
+}
+
+/**
+ * 腾出内存缓存空间
+ */
+bool StaticAssetHandler::reserveRam(size_t bytes, const CachedAsset *keep)
+{
+    if (bytes > _ramBudget)
+    {
+        return false;
+    }
+
+    while (_ramUsage + bytes > _ramBudget)
+    {
+        // 淘汰最久未使用的内存内容，ETag记录保留
+        CachedAsset *victim = nullptr;
+        for (uint8_t i = 0; i < STATIC_ASSET_MAX_ENTRIES; i++)
+        {
+            CachedAsset *entry = &_entries[i];
+            if (entry != keep && entry->data && (!victim || entry->lastUsed < victim->lastUsed))
+            {
+                victim = entry;
+            }
+        }
+
+        if (!victim)
+        {
+            return false;
+        }
+        releaseData(victim);
+    }
+    return true;
+}
+
+/**
+ * 根据扩展名获取内容类型
+ */
+const char *StaticAssetHandler::contentTypeFor(const String &path)
+{
+    if (path.endsWith(".html") || path.endsWith(".htm"))
+        return "text/html";
+    if (path.endsWith(".css"))
+        return "text/css";
+    if (path.endsWith(".js"))
+        return "application/javascript";
+    if (path.endsWith(".json"))
+        return "application/json";
+    if (path.endsWith(".svg"))
+        return "image/svg+xml";
+    if (path.endsWith(".png"))
+        return "image/png";
+    if (path.endsWith(".jpg") || path.endsWith(".jpeg"))
+        return "image/jpeg";
+    if (path.endsWith(".ico"))
+        return "image/x-icon";
+    if (path.endsWith(".woff2"))
+        return "font/woff2";
+    if (path.endsWith(".txt"))
+        return "text/plain";
+    return "application/octet-stream";
+}
@@ -0,0 +1,146 @@
+/**
+ * StaticAssetHandler.h
+ *
+ * 静态Web资源处理模块，支持预压缩文件、ETag缓存验证和内存热缓存
+ *
+ * @file StaticAssetHandler.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef STATIC_ASSET_HANDLER_H
+#define STATIC_ASSET_HANDLER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <ESPAsyncWebServer.h>
+#include <memory>
+
+// 缓存配置
+#define STATIC_ASSET_MAX_ENTRIES 12       // 记录ETag的最大文件数
+#define STATIC_ASSET_MAX_CACHED_FILE 8192 // 可放入内存缓存的最大文件大小（字节）
+#define STATIC_ASSET_DEFAULT_BUDGET 16384 // 默认内存缓存总预算（字节）
+#define STATIC_ASSET_PATH_LENGTH 48       // 缓存的路径最大长度
+
+// 已知资源的缓存条目
+struct CachedAsset
+{
+    char path[STATIC_ASSET_PATH_LENGTH]; // 请求的文件路径（不含.gz后缀）
+    char etag[16];                       // 强ETag（含引号）
+    const char *contentType;             // 内容类型
+    bool acceptGzip;                     // 条目对应的客户端是否接受gzip
+    bool gzip;                           // 实际发送的是否为预压缩文件
+    size_t size;                         // 文件大小
+    std::shared_ptr<uint8_t> data;       // 内存中的文件内容（可能为空）
+    uint32_t lastUsed;                   // LRU计数
+};
+
+/**
+ * 静态资源处理器类
+ *
+ * 优先发送.gz预压缩文件，使用基于内容的强ETag响应304，
+ * 并将小的热点文件保存在内存中
+ */
+class StaticAssetHandler : public AsyncWebHandler
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param fs 文件系统
+     * @param uriPrefix 处理的URI前缀
+     * @param fsRoot 文件系统中的根目录
+     */
+    StaticAssetHandler(fs::FS &fs, const char *uriPrefix = "/", const char *fsRoot = "/");
+
+    /**
+     * 设置Cache-Control头
+     *
+     * @param cacheControl Cache-Control的值
+     */
+    void setCacheControl(const char *cacheControl);
+
+    /**
+     * 设置内存缓存预算
+     *
+     * @param bytes 预算字节数, 0表示不在内存中缓存文件内容
+     */
+    void setRamCacheBudget(size_t bytes);
+
+    /**
+     * 清空所有缓存，文件系统内容变化后调用
+     */
+    void invalidate();
+
+    /**
+     * 获取内存缓存当前占用
+     *
+     * @return 占用字节数
+     */
+    size_t getRamCacheUsage() const;
+
+    bool canHandle(AsyncWebServerRequest *request) override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+
+private:
+    fs::FS &_fs;                                    // 文件系统引用
+    String _uriPrefix;                              // URI前缀
+    String _fsRoot;                                 // 文件系统根目录
+    String _cacheControl;                           // Cache-Control的值
+    size_t _ramBudget;                              // 内存缓存预算
+    size_t _ramUsage;                               // 内存缓存占用
+    uint32_t _useCounter;                           // LRU计数器
+    CachedAsset _entries[STATIC_ASSET_MAX_ENTRIES]; // 缓存条目
+
+    /**
+     * 将请求URL映射为文件路径
+     *
+     * @param url 请求URL
+     * @param path 输出的文件路径
+     * @return 是否属于本处理器
+     */
+    bool mapPath(const String &url, String &path) const;
+
+    /**
+     * 查找或加载资源
+     *
+     * @param path 原始文件路径
+     * @param acceptGzip 客户端是否接受gzip
+     * @return 缓存条目，文件不存在时返回nullptr
+     */
+    CachedAsset *getAsset(const String &path, bool acceptGzip);
+
+    /**
+     * 为新资源分配条目（必要时淘汰最久未使用的条目）
+     *
+     * @return 空闲条目
+     */
+    CachedAsset *allocateEntry();
+
+    /**
+     * 释放条目的内存内容
+     *
+     * @param entry 缓存条目
+     */
+    void releaseData(CachedAsset *entry);
+
+    /**
+     * 腾出内存缓存空间
+     *
+     * @param bytes 需要的字节数
+     * @param keep 不能被淘汰的条目
+     * @return 是否腾出了足够空间
+     */
+    bool reserveRam(size_t bytes, const CachedAsset *keep);
+
+    /**
+     * 根据扩展名获取内容类型
+     *
+     * @param path 文件路径
+     * @return 内容类型
+     */
+    static const char *contentTypeFor(const String &path);
+};
+
+#endif // STATIC_ASSET_HANDLER_H
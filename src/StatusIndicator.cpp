@@ -0,0 +1,448 @@
+/**
+ * StatusIndicator.cpp
+ *
+ * 状态指示灯控制模块的实现
+ *
+ * 动画亮度来自预先计算的查找表，彩虹效果使用定点HSV转换，
+ * 只有颜色实际变化时才写入LED。在ESP32上可以改由定时器驱动渲染
+ *
+ * @file StatusIndicator.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "StatusIndicator.h"
+
+// 模式状态可能同时被主循环、网络任务和渲染定时器访问
+#if HAS_TIMED_LED
+#define LED_STATE_LOCK() portENTER_CRITICAL(&_stateLock)
+#define LED_STATE_UNLOCK() portEXIT_CRITICAL(&_stateLock)
+#else
+#define LED_STATE_LOCK()
+#define LED_STATE_UNLOCK()
+#endif
+
+namespace
+{
+    // 呼吸曲线查找表：(1 - cos) / 2 一个完整周期，已包含2.2伽马校正
+    const uint8_t BREATH_TABLE[64] PROGMEM = {
+        0, 0, 0, 0, 0, 1, 1, 2, 4, 6, 9, 14, 19, 26, 34, 44,
+        55, 68, 82, 97, 113, 130, 147, 164, 180, 196, 210, 223, 234, 243, 250, 254,
+        255, 254, 250, 243, 234, 223, 210, 196, 180, 164, 147, 130, 113, 97, 82, 68,
+        55, 44, 34, 26, 19, 14, 9, 6, 4, 2, 1, 1, 0, 0, 0, 0};
+
+    // 开机动画颜色序列
+    const uint32_t BOOT_COLORS[6] PROGMEM = {
+        0xFF0000, 0xFF8000, 0xFFFF00, 0x00FF00, 0x0000FF, 0x8000FF};
+
+    // 基础颜色
+    const uint32_t COLOR_RED = 0xFF0000;
+    const uint32_t COLOR_GREEN = 0x00FF00;
+    const uint32_t COLOR_BLUE = 0x0000FF;
+    const uint32_t COLOR_YELLOW = 0xFFFF00;
+    const uint32_t COLOR_ORANGE = 0xFF8000;
+    const uint32_t COLOR_OFF = 0x000000;
+
+    /**
+     * 按亮度缩放颜色
+     *
+     * @param color 打包的RGB颜色
+     * @param level 亮度 (0-255)
+     */
+    inline uint32_t scaleColor(uint32_t color, uint8_t level)
+    {
+        uint16_t scale = (uint16_t)level + 1;
+        uint32_t r = (((color >> 16) & 0xFF) * scale) >> 8;
+        uint32_t g = (((color >> 8) & 0xFF) * scale) >> 8;
+        uint32_t b = ((color & 0xFF) * scale) >> 8;
+        return (r << 16) | (g << 8) | b;
+    }
+
+    /**
+     * 定点HSV转RGB（饱和度和亮度均为最大）
+     *
+     * @param hue 色调 (0-65535 对应 0-360度)
+     */
+    inline uint32_t hueToColor(uint16_t hue)
+    {
+        uint32_t scaled = (uint32_t)hue * 6;
+        uint8_t sector = scaled >> 16;
+        uint8_t rise = (scaled & 0xFFFF) >> 8;
+        uint8_t fall = 255 - rise;
+
+        switch (sector)
+        {
+        case 0:
+            return 0xFF0000 | ((uint32_t)rise << 8);
+        case 1:
+            return ((uint32_t)fall << 16) | 0x00FF00;
+        case 2:
+            return 0x00FF00 | rise;
+        case 3:
+            return ((uint32_t)fall << 8) | 0x0000FF;
+        case 4:
+            return ((uint32_t)rise << 16) | 0x0000FF;
+        default:
+            return 0xFF0000 | fall;
+        }
+    }
+
+    /**
+     * 计算呼吸效果颜色
+     */
+    inline uint32_t breathColor(uint32_t color, unsigned long elapsed)
+    {
+        uint8_t index = (elapsed / (LED_BREATH_PERIOD / 64)) & 63;
+        return scaleColor(color, pgm_read_byte(&BREATH_TABLE[index]));
+    }
+
+    /**
+     * 计算闪烁效果颜色
+     */
+    inline uint32_t blinkColor(uint32_t color, unsigned long elapsed, unsigned long halfPeriod)
+    {
+        return ((elapsed / halfPeriod) & 1) ? COLOR_OFF : color;
+    }
+}
+
+/**
+ * 构造函数
+ */
+StatusIndicator::StatusIndicator(uint8_t ledPin) :
+#if HAS_NEOPIXEL
+                                                   _pixels(1, ledPin, NEO_GRB + NEO_KHZ800),
+#endif
+                                                   _ledPin(ledPin),
+                                                   _currentLedMode(LED_BOOT_ANIMATION),
+                                                   _modeBeforeApi(LED_CONNECTED),
+                                                   _ledPreviousMillis(0),
+                                                   _lastFrameMillis(0),
+                                                   _lastColor(0),
+                                                   _colorValid(false),
+                                                   _otaCompleteTime(0),
+                                                   _successBlinks(0),
+                                                   _rainbowHue(0),
+                                                   _apiActiveStart(0),
+                                                   _bootColorIndex(0),
+                                                   _timedRendering(false),
+                                                   _manualColorPending(false),
+                                                   _manualColor(0)
+{
+#if HAS_TIMED_LED
+    _renderTimer = nullptr;
+    portMUX_INITIALIZE(&_stateLock);
+#endif
+}
+
+/**
+ * 初始化状态指示器
+ */
+void StatusIndicator::begin()
+{
+#if HAS_NEOPIXEL
+    _pixels.begin();
+    _pixels.setBrightness(LED_MAX_BRIGHTNESS);
+#endif
+    _colorValid = false;
+    setMode(LED_BOOT_ANIMATION);
+    writeColor(COLOR_OFF);
+}
+
+/**
+ * 更新LED状态
+ */
+void StatusIndicator::handle()
+{
+    // 定时渲染时由定时器推进动画
+    if (_timedRendering)
+    {
+        return;
+    }
+
+    unsigned long now = millis();
+    if (_colorValid && now - _lastFrameMillis < LED_FRAME_INTERVAL)
+    {
+        return;
+    }
+    _lastFrameMillis = now;
+
+    renderTick(now);
+}
+
+/**
+ * 设置LED模式
+ */
+void StatusIndicator::setMode(LedMode mode)
+{
+    LED_STATE_LOCK();
+    applyMode(mode);
+    LED_STATE_UNLOCK();
+}
+
+/**
+ * 切换模式
+ */
+void StatusIndicator::applyMode(LedMode mode)
+{
+    if (mode == _currentLedMode && mode != LED_BOOT_ANIMATION)
+    {
+        return;
+    }
+
+    _currentLedMode = mode;
+    _ledPreviousMillis = millis();
+    _successBlinks = 0;
+    _bootColorIndex = 0;
+
+    if (mode == FIRMWARE_SUCCESS || mode == FILESYSTEM_SUCCESS)
+    {
+        _otaCompleteTime = _ledPreviousMillis;
+    }
+}
+
+/**
+ * 触发API活动指示
+ */
+void StatusIndicator::triggerApiActivity()
+{
+    LED_STATE_LOCK();
+    _apiActiveStart = millis();
+
+    // OTA和更新结果的指示优先级更高
+    if (_currentLedMode != LED_API_ACTIVE &&
+        _currentLedMode != LED_OTA_IN_PROGRESS &&
+        _currentLedMode != FIRMWARE_SUCCESS &&
+        _currentLedMode != FILESYSTEM_SUCCESS)
+    {
+        _modeBeforeApi = _currentLedMode;
+        applyMode(LED_API_ACTIVE);
+    }
+    LED_STATE_UNLOCK();
+}
+
+/**
+ * 获取当前LED模式
+ */
+LedMode StatusIndicator::getMode() const
+{
+    return _currentLedMode;
+}
+
+/**
+ * 使用特定颜色设置LED
+ */
+void StatusIndicator::setColor(uint8_t r, uint8_t g, uint8_t b)
+{
+    uint32_t color = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+
+    if (_timedRendering)
+    {
+        // 只在渲染定时器中写入LED，避免并发输出
+        _manualColor = color;
+        _manualColorPending = true;
+        return;
+    }
+
+    writeColor(color);
+}
+
+/**
+ * 启用或禁用定时器驱动的渲染
+ */
+bool StatusIndicator::enableTimedRendering(bool enable)
+{
+#if HAS_TIMED_LED
+    if (enable == _timedRendering)
+    {
+        return _timedRendering;
+    }
+
+    if (!enable)
+    {
+        esp_timer_stop(_renderTimer);
+        _timedRendering = false;
+        return false;
+    }
+
+    if (!_renderTimer)
+    {
+        esp_timer_create_args_t timerArgs = {};
+        timerArgs.callback = &StatusIndicator::onRenderTimer;
+        timerArgs.arg = this;
+        timerArgs.dispatch_method = ESP_TIMER_TASK;
+        timerArgs.name = "status_led";
+
+        if (esp_timer_create(&timerArgs, &_renderTimer) != ESP_OK)
+        {
+            _renderTimer = nullptr;
+            Serial.println("LED渲染定时器创建失败，使用轮询方式");
+            return false;
+        }
+    }
+
+    _timedRendering = true;
+    if (esp_timer_start_periodic(_renderTimer, (uint64_t)LED_FRAME_INTERVAL * 1000) != ESP_OK)
+    {
+        _timedRendering = false;
+        Serial.println("LED渲染定时器启动失败，使用轮询方式");
+    }
+    return _timedRendering;
+#else
+    // 当前平台的LED输出会关闭中断，保持轮询方式
+    (void)enable;
+    return false;
+#endif
+}
+
+/**
+ * 是否正在使用定时器驱动的渲染
+ */
+bool StatusIndicator::isTimedRendering() const
+{
+    return _timedRendering;
+}
+
+/**
+ * 计算当前帧的颜色
+ */
+uint32_t StatusIndicator::renderFrame(unsigned long now)
+{
+    if (_currentLedMode == LED_API_ACTIVE && now - _apiActiveStart > LED_API_ACTIVE_DURATION)
+    {
+        applyMode(_modeBeforeApi);
+    }
+
+    unsigned long elapsed = now - _ledPreviousMillis;
+
+    switch (_currentLedMode)
+    {
+    case LED_BOOT_ANIMATION:
+        return updateBootAnimation(elapsed);
+    case LED_AP_MODE:
+        return updateAPMode(elapsed);
+    case LED_CONNECTED:
+        return updateConnected(elapsed);
+    case LED_API_ACTIVE:
+        return updateAPIActive(elapsed);
+    case LED_OTA_IN_PROGRESS:
+        return updateOTAProgress(elapsed);
+    case FIRMWARE_SUCCESS:
+        return updateFirmwareSuccess(elapsed);
+    case FILESYSTEM_SUCCESS:
+        return updateFilesystemSuccess(elapsed);
+    case LED_ERROR:
+    default:
+        return updateError(elapsed);
+    }
+}
+
+/**
+ * 计算并输出一帧
+ */
+void StatusIndicator::renderTick(unsigned long now)
+{
+    uint32_t color;
+
+    if (_manualColorPending)
+    {
+        color = _manualColor;
+        _manualColorPending = false;
+    }
+    else
+    {
+        LED_STATE_LOCK();
+        color = renderFrame(now);
+        LED_STATE_UNLOCK();
+    }
+
+    // LED输出在锁外进行
+    writeColor(color);
+}
+
+/**
+ * 定时器回调
+ */
+void StatusIndicator::onRenderTimer(void *arg)
+{
+    StatusIndicator *indicator = static_cast<StatusIndicator *>(arg);
+    indicator->renderTick(millis());
+}
+
+/**
+ * 写入LED颜色
+ */
+void StatusIndicator::writeColor(uint32_t color)
+{
+    if (_colorValid && color == _lastColor)
+    {
+        return;
+    }
+    _lastColor = color;
+    _colorValid = true;
+
+#if HAS_NEOPIXEL
+    _pixels.setPixelColor(0, color);
+    _pixels.show();
+#endif
+}
+
+// 开机动画：依次显示彩色序列
+uint32_t StatusIndicator::updateBootAnimation(unsigned long elapsed)
+{
+    _bootColorIndex = (elapsed / 250) % 6;
+    return pgm_read_dword(&BOOT_COLORS[_bootColorIndex]);
+}
+
+// AP模式：红色呼吸
+uint32_t StatusIndicator::updateAPMode(unsigned long elapsed)
+{
+    return breathColor(COLOR_RED, elapsed);
+}
+
+// 已连接：绿色呼吸
+uint32_t StatusIndicator::updateConnected(unsigned long elapsed)
+{
+    return breathColor(COLOR_GREEN, elapsed);
+}
+
+// API活动：黄色闪烁
+uint32_t StatusIndicator::updateAPIActive(unsigned long elapsed)
+{
+    return blinkColor(COLOR_YELLOW, elapsed, 100);
+}
+
+// OTA进行中：彩虹效果，约2秒一个周期
+uint32_t StatusIndicator::updateOTAProgress(unsigned long elapsed)
+{
+    _rainbowHue = (uint16_t)(elapsed << 5);
+    return hueToColor(_rainbowHue);
+}
+
+// 固件更新成功：蓝色闪烁
+uint32_t StatusIndicator::updateFirmwareSuccess(unsigned long elapsed)
+{
+    _successBlinks = elapsed / 500;
+    if (_successBlinks >= LED_SUCCESS_BLINKS)
+    {
+        return COLOR_BLUE;
+    }
+    return blinkColor(COLOR_BLUE, elapsed, 250);
+}
+
+// 文件系统更新成功：橙色闪烁
+uint32_t StatusIndicator::updateFilesystemSuccess(unsigned long elapsed)
+{
+    _successBlinks = elapsed / 500;
+    if (_successBlinks >= LED_SUCCESS_BLINKS)
+    {
+        return COLOR_ORANGE;
+    }
+    return blinkColor(COLOR_ORANGE, elapsed, 250);
+}
+
+// 错误：红色快闪
+uint32_t StatusIndicator::updateError(unsigned long elapsed)
+{
+    return blinkColor(COLOR_RED, elapsed, 100);
+}
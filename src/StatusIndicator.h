@@ -21,10 +21,30 @@
 #define HAS_NEOPIXEL 0
 #endif
 
+// 确定是否支持定时器驱动的渲染
+// ESP32上Adafruit_NeoPixel通过RMT外设输出，不需要关闭中断；
+// ESP8266使用软件时序输出，会关闭中断，因此保持轮询方式
+#if HAS_NEOPIXEL && defined(ESP32)
+#define HAS_TIMED_LED 1
+#else
+#define HAS_TIMED_LED 0
+#endif
+
 #if HAS_NEOPIXEL
 #include <Adafruit_NeoPixel.h>
 #endif
 
+#if HAS_TIMED_LED
+#include <esp_timer.h>
+#endif
+
+// LED动画配置
+#define LED_FRAME_INTERVAL 20        // 动画帧间隔（毫秒）
+#define LED_BREATH_PERIOD 2560       // 呼吸周期（毫秒），为呼吸表长度的整数倍
+#define LED_API_ACTIVE_DURATION 1000 // API活动指示持续时间（毫秒）
+#define LED_SUCCESS_BLINKS 10        // 更新成功后的闪烁次数
+#define LED_MAX_BRIGHTNESS 64        // LED最大亮度 (0-255)
+
 // LED状态模式
 enum LedMode
 {
@@ -93,31 +113,93 @@ public:
      */
     void setColor(uint8_t r, uint8_t g, uint8_t b);
 
+    /**
+     * 启用或禁用定时器驱动的渲染
+     *
+     * 启用后动画由硬件定时器按LED_FRAME_INTERVAL推进，不再依赖handle()的调用频率；
+     * 不支持的平台保持轮询方式
+     *
+     * @param enable 是否启用
+     * @return 定时渲染是否处于启用状态
+     */
+    bool enableTimedRendering(bool enable);
+
+    /**
+     * 是否正在使用定时器驱动的渲染
+     *
+     * @return 是否使用定时渲染
+     */
+    bool isTimedRendering() const;
+
 private:
 #if HAS_NEOPIXEL
     Adafruit_NeoPixel _pixels; // NeoPixel实例
 #endif
-    uint8_t _ledPin;                  // LED引脚
-    LedMode _currentLedMode;          // 当前LED模式
-    unsigned long _ledPreviousMillis; // 上次更新LED状态的时间
-    int _breathBrightness;            // 呼吸效果亮度
-    bool _breathIncreasing;           // 呼吸效果方向
-    bool _blinkState;                 // 闪烁状态
-    unsigned long _otaCompleteTime;   // OTA完成时间
-    uint8_t _successBlinks;           // 成功闪烁次数
-    uint16_t _rainbowHue;             // 彩虹效果色调
-    unsigned long _apiActiveStart;    // API活动开始时间
-    uint8_t _bootColorIndex;          // 引导动画颜色索引
+    uint8_t _ledPin;                   // LED引脚
+    LedMode _currentLedMode;           // 当前LED模式
+    LedMode _modeBeforeApi;            // API活动指示结束后恢复的模式
+    unsigned long _ledPreviousMillis;  // 当前模式开始的时间，用于计算动画相位
+    unsigned long _lastFrameMillis;    // 上次计算帧的时间
+    uint32_t _lastColor;               // 上次写入LED的颜色
+    bool _colorValid;                  // _lastColor是否有效
+    unsigned long _otaCompleteTime;    // OTA完成时间
+    uint8_t _successBlinks;            // 成功闪烁次数
+    uint16_t _rainbowHue;              // 彩虹效果色调 (0-65535)
+    unsigned long _apiActiveStart;     // API活动开始时间
+    uint8_t _bootColorIndex;           // 引导动画颜色索引
+    volatile bool _timedRendering;     // 是否由定时器驱动渲染
+    volatile bool _manualColorPending; // 定时渲染时是否有待写入的手动颜色
+    volatile uint32_t _manualColor;    // 待写入的手动颜色
+#if HAS_TIMED_LED
+    esp_timer_handle_t _renderTimer; // 渲染定时器
+    portMUX_TYPE _stateLock;         // 保护模式状态的自旋锁
+#endif
+
+    /**
+     * 切换模式（调用方负责加锁）
+     *
+     * @param mode LED状态模式
+     */
+    void applyMode(LedMode mode);
+
+    /**
+     * 计算并输出一帧
+     *
+     * @param now 当前时间（毫秒）
+     */
+    void renderTick(unsigned long now);
+
+    /**
+     * 定时器回调
+     *
+     * @param arg StatusIndicator实例
+     */
+    static void onRenderTimer(void *arg);
+
+    /**
+     * 计算当前帧的颜色
+     *
+     * @param now 当前时间（毫秒）
+     * @return 打包的RGB颜色 (0x00RRGGBB)
+     */
+    uint32_t renderFrame(unsigned long now);
+
+    /**
+     * 写入LED颜色，颜色未变化时跳过
+     *
+     * @param color 打包的RGB颜色
+     */
+    void writeColor(uint32_t color);
 
     // LED效果方法
-    void updateBootAnimation();
-    void updateAPMode();
-    void updateConnected();
-    void updateAPIActive();
-    void updateOTAProgress();
-    void updateFirmwareSuccess();
-    void updateFilesystemSuccess();
-    void updateError();
+    uint32_t updateBootAnimation(unsigned long elapsed);
+    uint32_t updateAPMode(unsigned long elapsed);
+    uint32_t updateConnected(unsigned long elapsed);
+    uint32_t updateAPIActive(unsigned long elapsed);
+    uint32_t updateOTAProgress(unsigned long elapsed);
+    uint32_t updateFirmwareSuccess(unsigned long elapsed);
+    uint32_t updateFilesystemSuccess(unsigned long elapsed);
+    uint32_t updateError(unsigned long elapsed);
 };
 
 #endif // STATUS_INDICATOR_H
\ No newline at end of file
@@ -0,0 +1,163 @@
+/**
+ * WebSocketEncoding.cpp
+ *
+ * WebSocketManager按客户端编码发送文档的部分
+ *
+ * @file WebSocketEncoding.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "WebSocketManager.h"
+
+// 位图只能记录32个客户端
+static_assert(WEBSOCKETS_SERVER_CLIENT_MAX <= 32, "WEBSOCKETS_SERVER_CLIENT_MAX超出编码位图容量");
+
+namespace
+{
+    /**
+     * 序列化缓冲区，小消息使用栈上空间
+     */
+    class EncodeBuffer
+    {
+    public:
+        EncodeBuffer(const JsonDocument &doc, MessageEncoding encoding) : _data(_stack),
+                                                                          _length(0)
+        {
+            size_t size = MessageCodec::measure(doc, encoding) + 1;
+            if (size > sizeof(_stack))
+            {
+                _data = (uint8_t *)malloc(size);
+                if (!_data)
+                {
+                    return;
+                }
+            }
+            _length = MessageCodec::serialize(doc, encoding, _data, size);
+        }
+
+        ~EncodeBuffer()
+        {
+            if (_data && _data != _stack)
+            {
+                free(_data);
+            }
+        }
+
+        const uint8_t *data() const { return _data; }
+        size_t length() const { return _length; }
+
+    private:
+        uint8_t _stack[MESSAGE_CODEC_STACK_BUFFER];
+        uint8_t *_data;
+        size_t _length;
+    };
+}
+
+/**
+ * 广播文档
+ */
+void WebSocketManager::broadcastDocument(const JsonDocument &doc)
+{
+    if (!_msgpackClients)
+    {
+        // 所有客户端都使用JSON
+        EncodeBuffer json(doc, MESSAGE_JSON);
+        if (json.length())
+        {
+            _webSocketServer.broadcastTXT(json.data(), json.length());
+        }
+        return;
+    }
+
+    EncodeBuffer msgpack(doc, MESSAGE_MSGPACK);
+    bool hasJsonClient = false;
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+    {
+        if (!_webSocketServer.clientIsConnected(num))
+        {
+            continue;
+        }
+        if (_msgpackClients & (1UL << num))
+        {
+            // 缓冲区分配失败时不发送空帧
+            if (msgpack.length())
+            {
+                _webSocketServer.sendBIN(num, msgpack.data(), msgpack.length());
+            }
+        }
+        else
+        {
+            hasJsonClient = true;
+        }
+    }
+
+    if (!hasJsonClient)
+    {
+        return;
+    }
+
+    EncodeBuffer json(doc, MESSAGE_JSON);
+    if (!json.length())
+    {
+        return;
+    }
+    for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+    {
+        if (!(_msgpackClients & (1UL << num)) && _webSocketServer.clientIsConnected(num))
+        {
+            _webSocketServer.sendTXT(num, json.data(), json.length());
+        }
+    }
+}
+
+/**
+ * 按客户端协商的编码发送文档
+ */
+void WebSocketManager::sendDocument(uint8_t num, const JsonDocument &doc)
+{
+    MessageEncoding encoding = getClientEncoding(num);
+    EncodeBuffer buffer(doc, encoding);
+    if (!buffer.length())
+    {
+        return;
+    }
+
+    if (encoding == MESSAGE_MSGPACK)
+    {
+        _webSocketServer.sendBIN(num, buffer.data(), buffer.length());
+    }
+    else
+    {
+        _webSocketServer.sendTXT(num, buffer.data(), buffer.length());
+    }
+}
+
+/**
+ * 设置客户端的消息编码
+ */
+void WebSocketManager::setClientEncoding(uint8_t num, MessageEncoding encoding)
+{
+    if (num >= WEBSOCKETS_SERVER_CLIENT_MAX)
+    {
+        return;
+    }
+
+    if (encoding == MESSAGE_MSGPACK)
+    {
+        _msgpackClients |= 1UL << num;
+    }
+    else
+    {
+        _msgpackClients &= ~(1UL << num);
+    }
+}
+
+/**
+ * 获取客户端的消息编码
+ */
+MessageEncoding WebSocketManager::getClientEncoding(uint8_t num) const
+{
+    return num < WEBSOCKETS_SERVER_CLIENT_MAX && (_msgpackClients & (1UL << num)) ? MESSAGE_MSGPACK : MESSAGE_JSON;
+}
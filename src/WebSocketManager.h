@@ -15,6 +15,48 @@
 #include <Arduino.h>
 #include <WebSockets.h>
 #include <WebSocketsServer.h>
+#include <ArduinoJson.h>
+#include "MessageCodec.h"
+
+// 关闭帧配置
+#define WS_CLOSE_SERVICE_RESTART 1012 // 关闭状态码：服务正在重启
+#define WS_CLOSE_MAX_PAYLOAD 125      // 控制帧载荷上限（2字节状态码 + 原因）
+
+/**
+ * WebSocket服务器
+ *
+ * WebSocketsServer::disconnect()发送的关闭帧不带状态码，
+ * 这里通过库的受保护接口发送带状态码和原因的关闭帧
+ */
+class WsServer : public WebSocketsServer
+{
+public:
+    using WebSocketsServer::WebSocketsServer;
+
+    /**
+     * 发送带状态码和原因的关闭帧并断开客户端
+     *
+     * @param num 客户端编号
+     * @param code 关闭状态码
+     * @param reason 原因（最多123字节），nullptr表示不带原因
+     */
+    void close(uint8_t num, uint16_t code, const char *reason)
+    {
+        if (num >= WEBSOCKETS_SERVER_CLIENT_MAX || _clients[num].status == WSC_NOT_CONNECTED)
+        {
+            return;
+        }
+
+        uint8_t payload[WS_CLOSE_MAX_PAYLOAD];
+        size_t reasonLen = reason ? strnlen(reason, sizeof(payload) - 2) : 0;
+        payload[0] = code >> 8;
+        payload[1] = code & 0xFF;
+        memcpy(payload + 2, reason, reasonLen);
+
+        // 未完成握手的连接不发送关闭帧，直接断开
+        WebSockets::clientDisconnect(&_clients[num], code, (char *)payload, reasonLen + 2);
+    }
+};
 
 /**
  * WebSocket管理器类
@@ -56,6 +98,18 @@ public:
      */
     void sendTXT(uint8_t num, const String &text);
 
+    /**
+     * 向特定客户端发送文本消息（不创建String）
+     *
+     * @param num 客户端的编号
+     * @param text 要发送的文本
+     * @param length 文本长度
+     */
+    void sendTXT(uint8_t num, const char *text, size_t length)
+    {
+        _webSocketServer.sendTXT(num, text, length);
+    }
+
     /**
      * 广播二进制数据给所有连接的客户端
      *
@@ -73,6 +127,39 @@ public:
      */
     void sendBIN(uint8_t num, const uint8_t *payload, size_t length);
 
+    /**
+     * 广播文档，每个客户端按协商的编码接收（JSON文本帧或MessagePack二进制帧）
+     *
+     * 每种编码只序列化一次
+     *
+     * @param doc 要发送的文档
+     */
+    void broadcastDocument(const JsonDocument &doc);
+
+    /**
+     * 按客户端协商的编码发送文档
+     *
+     * @param num 客户端的编号
+     * @param doc 要发送的文档
+     */
+    void sendDocument(uint8_t num, const JsonDocument &doc);
+
+    /**
+     * 设置客户端的消息编码
+     *
+     * @param num 客户端的编号
+     * @param encoding 编码
+     */
+    void setClientEncoding(uint8_t num, MessageEncoding encoding);
+
+    /**
+     * 获取客户端的消息编码
+     *
+     * @param num 客户端的编号
+     * @return 编码
+     */
+    MessageEncoding getClientEncoding(uint8_t num) const;
+
     /**
      * 设置WebSocket事件回调
      *
@@ -87,9 +174,27 @@ public:
      */
     size_t getClientCount();
 
+    /**
+     * 向所有客户端发送带状态码和原因的关闭帧并断开连接
+     *
+     * @param code 关闭状态码，例如WS_CLOSE_SERVICE_RESTART
+     * @param reason 原因，nullptr表示不带原因
+     */
+    void disconnectAll(uint16_t code, const char *reason)
+    {
+        for (uint8_t num = 0; num < WEBSOCKETS_SERVER_CLIENT_MAX; num++)
+        {
+            _webSocketServer.close(num, code, reason);
+        }
+    }
+
 private:
-    WebSocketsServer _webSocketServer; // WebSocket服务器实例
-    uint16_t _port;                    // 服务器端口
+    // 事件路由器在转发未处理的事件时调用webSocketEvent
+    friend class WsEventRouter;
+
+    WsServer _webSocketServer;    // WebSocket服务器实例
+    uint16_t _port;               // 服务器端口
+    uint32_t _msgpackClients = 0; // 使用MessagePack的客户端（位图）
 
     // WebSocket 事件处理函数
     static void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length);
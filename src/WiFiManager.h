@@ -84,6 +84,8 @@ public:
     /**
      * 扫描可用的WiFi网络
      *
+     * 同步扫描，会阻塞主循环；Web界面请使用WiFiScanner的异步缓存扫描
+     *
      * @return JSON格式的WiFi网络列表
      */
     String scanNetworks();
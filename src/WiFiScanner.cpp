@@ -0,0 +1,320 @@
+/**
+ * WiFiScanner.cpp
+ *
+ * 异步WiFi扫描模块的实现
+ *
+ * @file WiFiScanner.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "WiFiScanner.h"
+#include "WebSocketManager.h"
+#include "JsonResponseWriter.h"
+#include <memory>
+
+/**
+ * 构造函数
+ */
+WiFiScanner::WiFiScanner(WebSocketManager *wsManager, uint32_t cacheTTL) : _wsManager(wsManager),
+                                                                           _networkCount(0),
+                                                                           _generation(0),
+                                                                           _scanRequested(false),
+                                                                           _scanning(false),
+                                                                           _cacheTTL(cacheTTL),
+                                                                           _lastScanTime(0),
+                                                                           _scanStartTime(0),
+                                                                           _pendingClients(0)
+{
+}
+
+/**
+ * 推进扫描状态机
+ */
+void WiFiScanner::handle()
+{
+    if (!_scanning)
+    {
+        if (_scanRequested)
+        {
+            if (hasFreshResults())
+            {
+                // 请求到达后缓存已被其他请求刷新
+                _scanRequested = false;
+                notifyPendingClients();
+            }
+            else
+            {
+                startScan();
+            }
+        }
+        return;
+    }
+
+    int16_t result = WiFi.scanComplete();
+    if (result == WIFI_SCAN_RUNNING)
+    {
+        if (millis() - _scanStartTime > WIFI_SCAN_TIMEOUT)
+        {
+            Serial.println("WiFi扫描超时");
+            WiFi.scanDelete();
+            failScan();
+        }
+        return;
+    }
+
+    if (result < 0)
+    {
+        Serial.println("WiFi扫描失败");
+        WiFi.scanDelete();
+        failScan();
+        return;
+    }
+
+    collectResults(result);
+    WiFi.scanDelete();
+}
+
+/**
+ * 请求一次扫描
+ */
+bool WiFiScanner::requestScan()
+{
+    if (!_scanning && hasFreshResults())
+    {
+        return true;
+    }
+
+    // 扫描进行中时只需等待，不会重复发起
+    _scanRequested = true;
+    return false;
+}
+
+/**
+ * 为WebSocket客户端请求扫描结果
+ */
+void WiFiScanner::requestScanFor(uint8_t clientNum)
+{
+    if (clientNum < 32)
+    {
+        _pendingClients |= (1UL << clientNum);
+    }
+
+    // 即使缓存有效也交给handle()在主循环中发送
+    _scanRequested = true;
+}
+
+/**
+ * 处理HTTP扫描请求
+ */
+void WiFiScanner::handleRequest(AsyncWebServerRequest *request)
+{
+    requestScan();
+
+    std::shared_ptr<ScanSnapshot> snapshot;
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse(
+        "application/json",
+        [this, snapshot](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t
+        {
+            if (!snapshot)
+            {
+                // 等待进行中的扫描完成
+                if (isScanning())
+                {
+                    return RESPONSE_TRY_AGAIN;
+                }
+
+                // 之后的块都从快照输出，中途完成的新扫描不会截断响应
+                std::shared_ptr<ScanSnapshot> copy(new ScanSnapshot());
+                if (!takeSnapshot(*copy))
+                {
+                    return RESPONSE_TRY_AGAIN;
+                }
+                snapshot = copy;
+            }
+
+            ChunkWindowPrint window(buffer, maxLen, index);
+            writeJson(window, snapshot->networks, snapshot->count, snapshot->age);
+            return window.length();
+        });
+    response->addHeader("Cache-Control", "no-store");
+    request->send(response);
+}
+
+/**
+ * 将缓存的扫描结果以JSON格式写入输出流
+ */
+size_t WiFiScanner::writeJson(Print &out) const
+{
+    // 在主循环中调用，缓存不会同时被修改
+    return writeJson(out, _networks, _networkCount, _generation ? (int32_t)(millis() - _lastScanTime) : -1);
+}
+
+/**
+ * 将扫描结果以JSON格式写入输出流
+ */
+size_t WiFiScanner::writeJson(Print &out, const ScannedNetwork *networks, uint8_t count, int32_t age)
+{
+    size_t written = out.print("{\"type\":\"wifi_scan\",\"networks\":[");
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        // 每次只为一个网络构建文档
+        StaticJsonDocument<128> networkDoc;
+        networkDoc["ssid"] = (const char *)networks[i].ssid;
+        networkDoc["rssi"] = networks[i].rssi;
+        networkDoc["channel"] = networks[i].channel;
+        networkDoc["secure"] = networks[i].secure;
+
+        if (i > 0)
+        {
+            written += out.write(',');
+        }
+        written += serializeJson(networkDoc, out);
+    }
+
+    // 分块输出会多次调用本函数，年龄由调用方在快照时确定，输出内容保持稳定
+    if (age < 0)
+    {
+        written += out.print("],\"age\":null}");
+    }
+    else
+    {
+        written += out.printf("],\"age\":%ld}", (long)age);
+    }
+    return written;
+}
+
+/**
+ * 复制缓存的结果
+ */
+bool WiFiScanner::takeSnapshot(ScanSnapshot &snapshot) const
+{
+    uint32_t generation = _generation;
+    uint8_t count = _networkCount;
+
+    memcpy(snapshot.networks, _networks, count * sizeof(ScannedNetwork));
+    snapshot.count = count;
+    snapshot.age = generation ? (int32_t)(millis() - _lastScanTime) : -1;
+
+    // collectResults()只在扫描期间写入缓存，完成时递增版本号
+    return !_scanning && generation == _generation;
+}
+
+/**
+ * 是否正在扫描
+ */
+bool WiFiScanner::isScanning() const
+{
+    return _scanning || _scanRequested;
+}
+
+/**
+ * 缓存的结果是否仍在有效期内
+ */
+bool WiFiScanner::hasFreshResults() const
+{
+    return _generation > 0 && millis() - _lastScanTime < _cacheTTL;
+}
+
+/**
+ * 设置缓存有效期
+ */
+void WiFiScanner::setCacheTTL(uint32_t cacheTTL)
+{
+    _cacheTTL = cacheTTL;
+}
+
+/**
+ * 获取缓存的网络数量
+ */
+size_t WiFiScanner::getNetworkCount() const
+{
+    return _networkCount;
+}
+
+/**
+ * 开始异步扫描
+ */
+void WiFiScanner::startScan()
+{
+    _scanStartTime = millis();
+    _scanning = true;
+    _scanRequested = false;
+
+#if defined(ESP32) || defined(ESP8266)
+    WiFi.scanNetworks(true);
+#else
+    // 不支持异步扫描的平台退化为同步扫描
+    collectResults(WiFi.scanNetworks());
+    WiFi.scanDelete();
+#endif
+}
+
+/**
+ * 扫描失败或超时
+ */
+void WiFiScanner::failScan()
+{
+    // 不更新版本号和扫描时间，缓存过期后下次请求会重新扫描
+    _scanning = false;
+    notifyPendingClients();
+}
+
+/**
+ * 读取扫描结果到缓存
+ */
+void WiFiScanner::collectResults(int16_t count)
+{
+    if (count > WIFI_SCAN_MAX_NETWORKS)
+    {
+        count = WIFI_SCAN_MAX_NETWORKS;
+    }
+
+    for (int16_t i = 0; i < count; i++)
+    {
+        strlcpy(_networks[i].ssid, WiFi.SSID(i).c_str(), sizeof(_networks[i].ssid));
+        _networks[i].rssi = WiFi.RSSI(i);
+        _networks[i].channel = WiFi.channel(i);
+#if defined(ESP32)
+        _networks[i].secure = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
+#else
+        _networks[i].secure = WiFi.encryptionType(i) != ENC_TYPE_NONE;
+#endif
+    }
+
+    _networkCount = count;
+    _lastScanTime = millis();
+    _generation++;
+    _scanning = false;
+
+    Serial.printf("WiFi扫描完成，发现 %d 个网络\n", count);
+
+    notifyPendingClients();
+}
+
+/**
+ * 向等待中的WebSocket客户端发送结果
+ */
+void WiFiScanner::notifyPendingClients()
+{
+    if (!_wsManager || !_pendingClients)
+    {
+        return;
+    }
+
+    // 结果只序列化一次，缓冲区容量保留给下次使用
+    _wsPayload = "";
+    writeJson(_wsPayload);
+
+    for (uint8_t num = 0; num < 32; num++)
+    {
+        if (_pendingClients & (1UL << num))
+        {
+            _wsManager->sendTXT(num, _wsPayload);
+        }
+    }
+    _pendingClients = 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * WiFiScanner.h
+ *
+ * 异步WiFi扫描模块，带结果缓存和流式JSON输出
+ *
+ * @file WiFiScanner.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef WIFI_SCANNER_H
+#define WIFI_SCANNER_H
+
+#include <Arduino.h>
+
+// 平台特定包含
+#if defined(ESP8266)
+#include <ESP8266WiFi.h>
+#elif defined(ESP32)
+#include <WiFi.h>
+#elif defined(TARGET_RP2040)
+#include <WiFi.h>
+#endif
+
+#include <ESPAsyncWebServer.h>
+#include <StreamString.h>
+#include <ArduinoJson.h>
+
+// 扫描配置
+#define WIFI_SCAN_MAX_NETWORKS 24    // 缓存的最大网络数量
+#define WIFI_SCAN_DEFAULT_TTL 30000  // 默认缓存有效期（毫秒）
+#define WIFI_SCAN_TIMEOUT 15000      // 单次扫描超时时间（毫秒）
+
+// 前向声明
+class WebSocketManager;
+
+// 扫描到的网络
+struct ScannedNetwork
+{
+    char ssid[33];   // SSID (最长32字节 + 结束符)
+    int8_t rssi;     // 信号强度
+    uint8_t channel; // 信道
+    bool secure;     // 是否加密
+};
+
+// 扫描结果快照，HTTP响应在开始时复制一份，分块输出期间新的扫描不会影响它
+struct ScanSnapshot
+{
+    ScannedNetwork networks[WIFI_SCAN_MAX_NETWORKS]; // 网络列表
+    uint8_t count;                                   // 网络数量
+    int32_t age;                                     // 复制时结果的年龄（毫秒），-1表示还没有结果
+};
+
+/**
+ * WiFi扫描器类
+ *
+ * 扫描由handle()异步推进，结果按TTL缓存并由所有请求方共享。
+ * 扫描进行中到达的请求会等待当前扫描完成，而不会重新发起扫描。
+ * 失败或超时的扫描不替换缓存，下次请求会重新扫描。
+ */
+class WiFiScanner
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param wsManager WebSocket管理器，用于向等待中的客户端推送结果
+     * @param cacheTTL 结果缓存有效期（毫秒）
+     */
+    WiFiScanner(WebSocketManager *wsManager, uint32_t cacheTTL = WIFI_SCAN_DEFAULT_TTL);
+
+    /**
+     * 推进扫描状态机，需要在loop()中调用
+     */
+    void handle();
+
+    /**
+     * 请求一次扫描
+     *
+     * 缓存仍然有效时不会发起新的扫描
+     *
+     * @return 缓存是否可以直接使用
+     */
+    bool requestScan();
+
+    /**
+     * 为WebSocket客户端请求扫描结果
+     *
+     * 结果就绪后会通过sendTXT发送给该客户端
+     *
+     * @param clientNum 客户端编号
+     */
+    void requestScanFor(uint8_t clientNum);
+
+    /**
+     * 处理HTTP扫描请求
+     *
+     * 使用分块传输输出缓存结果的快照，扫描进行中时响应会等待扫描完成
+     *
+     * @param request 异步请求对象
+     */
+    void handleRequest(AsyncWebServerRequest *request);
+
+    /**
+     * 将缓存的扫描结果以JSON格式写入输出流
+     *
+     * @param out 输出流
+     * @return 写入的字节数
+     */
+    size_t writeJson(Print &out) const;
+
+    /**
+     * 是否正在扫描（包括已请求但尚未开始的扫描）
+     *
+     * @return 是否正在扫描
+     */
+    bool isScanning() const;
+
+    /**
+     * 缓存的结果是否仍在有效期内
+     *
+     * @return 缓存是否有效
+     */
+    bool hasFreshResults() const;
+
+    /**
+     * 设置缓存有效期
+     *
+     * @param cacheTTL 缓存有效期（毫秒）
+     */
+    void setCacheTTL(uint32_t cacheTTL);
+
+    /**
+     * 获取缓存的网络数量
+     *
+     * @return 网络数量
+     */
+    size_t getNetworkCount() const;
+
+private:
+    WebSocketManager *_wsManager;                      // WebSocket管理器引用
+    ScannedNetwork _networks[WIFI_SCAN_MAX_NETWORKS]; // 缓存的扫描结果
+    volatile uint8_t _networkCount;                    // 缓存的网络数量
+    volatile uint32_t _generation;                     // 结果版本号，每次扫描完成后递增
+    volatile bool _scanRequested;                      // 是否有待处理的扫描请求
+    volatile bool _scanning;                           // 扫描是否进行中
+    uint32_t _cacheTTL;                                // 缓存有效期
+    unsigned long _lastScanTime;                       // 上次扫描完成的时间
+    unsigned long _scanStartTime;                      // 本次扫描开始的时间
+    uint32_t _pendingClients;                          // 等待结果的WebSocket客户端位图
+    StreamString _wsPayload;                           // WebSocket发送缓冲区（重复使用，避免反复分配）
+
+    /**
+     * 复制缓存的结果
+     *
+     * @param snapshot 输出：快照
+     * @return 快照是否完整，复制期间开始了新的扫描时返回false
+     */
+    bool takeSnapshot(ScanSnapshot &snapshot) const;
+
+    /**
+     * 将扫描结果以JSON格式写入输出流
+     *
+     * @param out 输出流
+     * @param networks 网络列表
+     * @param count 网络数量
+     * @param age 结果的年龄（毫秒），-1表示还没有结果
+     * @return 写入的字节数
+     */
+    static size_t writeJson(Print &out, const ScannedNetwork *networks, uint8_t count, int32_t age);
+
+    /**
+     * 开始异步扫描
+     */
+    void startScan();
+
+    /**
+     * 扫描失败或超时，保留原有的缓存
+     */
+    void failScan();
+
+    /**
+     * 读取扫描结果到缓存
+     *
+     * @param count 扫描到的网络数量
+     */
+    void collectResults(int16_t count);
+
+    /**
+     * 向等待中的WebSocket客户端发送结果
+     */
+    void notifyPendingClients();
+};
+
+#endif // WIFI_SCANNER_H
@@ -0,0 +1,293 @@
+/**
+ * WsCommandDispatcher.cpp
+ *
+ * WebSocket命令分发模块的实现
+ *
+ * @file WsCommandDispatcher.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "WsCommandDispatcher.h"
+#include "WebSocketManager.h"
+#include "WsEventRouter.h"
+#include "MetricsRegistry.h"
+#include <string.h>
+
+// 导出到 /metrics 的命令指标
+static MetricCounter wsCommandOkMetric("ws_commands", "处理的WebSocket命令数", "result=\"ok\"");
+static MetricCounter wsCommandErrorMetric("ws_commands", "处理的WebSocket命令数", "result=\"error\"");
+
+/**
+ * 检查消息中是否有 "cmd" 键，只有命令消息才会被原地解析
+ */
+static bool hasCommandKey(const uint8_t *payload, size_t length)
+{
+    static const char key[] = "\"cmd\"";
+    const size_t keyLen = sizeof(key) - 1;
+
+    const uint8_t *cursor = payload;
+    const uint8_t *end = payload + length;
+    while (cursor < end)
+    {
+        const uint8_t *found = (const uint8_t *)memmem(cursor, end - cursor, key, keyLen);
+        if (!found)
+        {
+            return false;
+        }
+
+        // 键后面是冒号，排除值为 "cmd" 的字符串
+        const uint8_t *next = found + keyLen;
+        while (next < end && (*next == ' ' || *next == '\t' || *next == '\r' || *next == '\n'))
+        {
+            next++;
+        }
+        if (next < end && *next == ':')
+        {
+            return true;
+        }
+        cursor = found + keyLen;
+    }
+    return false;
+}
+
+/**
+ * 命令上下文
+ */
+WsCommandContext::WsCommandContext(uint8_t client, JsonObjectConst request, JsonDocument &reply) : _client(client),
+                                                                                                   _request(request),
+                                                                                                   _reply(reply),
+                                                                                                   _error(nullptr)
+{
+}
+
+/**
+ * 获取应答中的result对象
+ */
+JsonObject WsCommandContext::result()
+{
+    JsonObject result = _reply["result"];
+    if (result.isNull())
+    {
+        result = _reply.createNestedObject("result");
+    }
+    return result;
+}
+
+/**
+ * 以错误应答
+ */
+void WsCommandContext::error(const char *code)
+{
+    _error = code;
+}
+
+/**
+ * 构造函数
+ */
+WsCommandDispatcher::WsCommandDispatcher(WebSocketManager *wsManager) : _wsManager(wsManager),
+                                                                        _commandCount(0)
+{
+}
+
+/**
+ * 注册到事件路由器
+ */
+void WsCommandDispatcher::begin(WsEventRouter *router)
+{
+    // 用于测量往返延迟
+    on("ping", [](WsCommandContext &ctx)
+       { ctx.result()["uptime"] = millis(); });
+
+    // 切换本连接的消息编码，应答已使用新编码
+    on("set_encoding", [this](WsCommandContext &ctx)
+       {
+           MessageEncoding encoding;
+           if (!MessageCodec::parse(ctx.request()["encoding"].as<const char *>(), encoding))
+           {
+               ctx.error("invalid_encoding");
+               return;
+           }
+           _wsManager->setClientEncoding(ctx.client(), encoding);
+           ctx.result()["encoding"] = MessageCodec::name(encoding); });
+
+    router->addListener([this](uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+                        { return type == WStype_TEXT && handleMessage(num, payload, length); });
+}
+
+/**
+ * 注册命令
+ */
+bool WsCommandDispatcher::on(const char *name, WsCommandHandler handler)
+{
+    uint32_t hash = wsCommandHash(name);
+    if (_commandCount >= WS_COMMAND_MAX_HANDLERS || find(hash, name))
+    {
+        Serial.printf("无法注册WebSocket命令: %s\n", name);
+        return false;
+    }
+
+    // 插入排序，保持按哈希值升序
+    uint8_t pos = _commandCount;
+    while (pos > 0 && _commands[pos - 1].hash > hash)
+    {
+        _commands[pos] = _commands[pos - 1];
+        pos--;
+    }
+
+    _commands[pos].hash = hash;
+    _commands[pos].name = name;
+    _commands[pos].handler = handler;
+    _commandCount++;
+    return true;
+}
+
+/**
+ * 处理一条文本消息
+ */
+bool WsCommandDispatcher::handleMessage(uint8_t num, uint8_t *payload, size_t length)
+{
+    if (!hasCommandKey(payload, length))
+    {
+        return false;
+    }
+
+    // 传入可写的char*，字符串值直接指向payload而不复制到文档
+    DeserializationError err = deserializeJson(_requestDoc, (char *)payload, length);
+    if (err)
+    {
+        sendError(num, JsonVariantConst(), "invalid_json");
+        return true;
+    }
+
+    JsonObjectConst request = _requestDoc.as<JsonObjectConst>();
+    JsonVariantConst id = request["id"];
+    const char *name = request["cmd"];
+    if (!name)
+    {
+        sendError(num, id, "invalid_command");
+        return true;
+    }
+
+    const CommandEntry *entry = find(wsCommandHash(name), name);
+    if (!entry)
+    {
+        sendError(num, id, "unknown_command");
+        return true;
+    }
+
+    _replyDoc.clear();
+    _replyDoc["type"] = "reply";
+    _replyDoc["id"] = id;
+    _replyDoc["ok"] = true;
+
+    WsCommandContext ctx(num, request, _replyDoc);
+    entry->handler(ctx);
+
+    if (ctx._error)
+    {
+        sendError(num, id, ctx._error);
+        return true;
+    }
+
+    wsCommandOkMetric.inc();
+
+    // 没有id的请求为通知，不需要应答
+    if (!id.isNull())
+    {
+        sendReply(num);
+    }
+    return true;
+}
+
+/**
+ * 按哈希值查找命令
+ */
+const WsCommandDispatcher::CommandEntry *WsCommandDispatcher::find(uint32_t hash, const char *name) const
+{
+    int low = 0;
+    int high = (int)_commandCount - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        if (_commands[mid].hash < hash)
+        {
+            low = mid + 1;
+        }
+        else if (_commands[mid].hash > hash)
+        {
+            high = mid - 1;
+        }
+        else
+        {
+            // 哈希冲突时向两侧查找同名的命令
+            for (int i = mid; i >= 0 && _commands[i].hash == hash; i--)
+            {
+                if (strcmp(_commands[i].name, name) == 0)
+                {
+                    return &_commands[i];
+                }
+            }
+            for (int i = mid + 1; i < _commandCount && _commands[i].hash == hash; i++)
+            {
+                if (strcmp(_commands[i].name, name) == 0)
+                {
+                    return &_commands[i];
+                }
+            }
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * 发送应答
+ */
+void WsCommandDispatcher::sendReply(uint8_t num)
+{
+    if (_replyDoc.overflowed() || !sendBuffered(num, _replyDoc))
+    {
+        sendError(num, _replyDoc["id"], "reply_too_large");
+    }
+}
+
+/**
+ * 发送错误应答
+ */
+void WsCommandDispatcher::sendError(uint8_t num, JsonVariantConst id, const char *code)
+{
+    wsCommandErrorMetric.inc();
+
+    // 使用独立的小文档，不受应答文档溢出的影响
+    StaticJsonDocument<128> errorDoc;
+    errorDoc["type"] = "reply";
+    errorDoc["id"] = id;
+    errorDoc["ok"] = false;
+    errorDoc["error"] = code;
+    sendBuffered(num, errorDoc);
+}
+
+/**
+ * 按客户端的编码序列化到应答缓冲区并发送
+ */
+bool WsCommandDispatcher::sendBuffered(uint8_t num, const JsonDocument &doc)
+{
+    MessageEncoding encoding = _wsManager->getClientEncoding(num);
+    if (MessageCodec::measure(doc, encoding) >= sizeof(_replyBuffer))
+    {
+        return false;
+    }
+
+    size_t len = MessageCodec::serialize(doc, encoding, (uint8_t *)_replyBuffer, sizeof(_replyBuffer));
+    if (encoding == MESSAGE_MSGPACK)
+    {
+        _wsManager->sendBIN(num, (const uint8_t *)_replyBuffer, len);
+    }
+    else
+    {
+        _wsManager->sendTXT(num, _replyBuffer, len);
+    }
+    return true;
+}
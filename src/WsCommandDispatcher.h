@@ -0,0 +1,179 @@
+/**
+ * WsCommandDispatcher.h
+ *
+ * WebSocket命令分发模块，按命令名称把文本消息交给注册的处理函数
+ *
+ * 请求: {"cmd":"relay","id":7,"on":true}
+ * 应答: {"type":"reply","id":7,"ok":true,"result":{...}}
+ *       {"type":"reply","id":7,"ok":false,"error":"unknown_command"}
+ *
+ * 没有id的请求不发送成功应答
+ *
+ * @file WsCommandDispatcher.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef WS_COMMAND_DISPATCHER_H
+#define WS_COMMAND_DISPATCHER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include <WebSocketsServer.h>
+
+// 分发配置
+#define WS_COMMAND_MAX_HANDLERS 24      // 最多注册的命令数量
+#define WS_COMMAND_REQUEST_DOC_SIZE 512 // 请求文档大小（字符串不占用文档空间）
+#define WS_COMMAND_REPLY_DOC_SIZE 512   // 应答文档大小
+#define WS_COMMAND_REPLY_BUFFER 768     // 应答序列化缓冲区大小
+
+// 前向声明
+class WebSocketManager;
+class WsEventRouter;
+class WsCommandDispatcher;
+
+/**
+ * 计算命令名称的FNV-1a哈希，可在编译期求值
+ *
+ * @param name 命令名称
+ * @param hash 初始值
+ * @return 哈希值
+ */
+constexpr uint32_t wsCommandHash(const char *name, uint32_t hash = 2166136261u)
+{
+    return *name ? wsCommandHash(name + 1, (hash ^ (uint8_t)*name) * 16777619u) : hash;
+}
+
+/**
+ * 命令上下文，只在处理函数执行期间有效
+ */
+class WsCommandContext
+{
+public:
+    /**
+     * 获取发送命令的客户端编号
+     */
+    uint8_t client() const { return _client; }
+
+    /**
+     * 获取完整的请求对象
+     *
+     * 字符串直接指向收到的数据帧，处理函数返回后失效，需要保存时应复制
+     */
+    JsonObjectConst request() const { return _request; }
+
+    /**
+     * 获取应答中的result对象，处理函数向其中写入返回值
+     */
+    JsonObject result();
+
+    /**
+     * 以错误应答
+     *
+     * @param code 错误代码（字符串常量）
+     */
+    void error(const char *code);
+
+private:
+    friend class WsCommandDispatcher;
+
+    WsCommandContext(uint8_t client, JsonObjectConst request, JsonDocument &reply);
+
+    uint8_t _client;          // 客户端编号
+    JsonObjectConst _request; // 请求对象
+    JsonDocument &_reply;     // 应答文档
+    const char *_error;       // 错误代码
+};
+
+/**
+ * 命令处理函数
+ *
+ * @param ctx 命令上下文
+ */
+typedef std::function<void(WsCommandContext &ctx)> WsCommandHandler;
+
+/**
+ * WebSocket命令分发器类
+ *
+ * 只处理包含 "cmd" 键的文本消息，其他消息原样交给后续监听器。
+ * 消息在接收缓冲区中原地解析（ArduinoJson零拷贝模式），命令按名称哈希二分查找，
+ * 应答序列化到固定缓冲区，处理一条消息不分配堆内存
+ */
+class WsCommandDispatcher
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param wsManager WebSocket管理器
+     */
+    WsCommandDispatcher(WebSocketManager *wsManager);
+
+    /**
+     * 注册到事件路由器，并注册内置的ping和set_encoding命令
+     *
+     * @param router WebSocket事件路由器
+     */
+    void begin(WsEventRouter *router);
+
+    /**
+     * 注册命令
+     *
+     * @param name 命令名称（字符串常量）
+     * @param handler 处理函数
+     * @return 是否注册成功（数量超出上限或名称重复时失败）
+     */
+    bool on(const char *name, WsCommandHandler handler);
+
+    /**
+     * 处理一条文本消息
+     *
+     * @param num 客户端编号
+     * @param payload 消息内容，解析时会被修改
+     * @param length 消息长度
+     * @return 消息是否为命令
+     */
+    bool handleMessage(uint8_t num, uint8_t *payload, size_t length);
+
+private:
+    // 已注册的命令，按哈希值升序排列
+    struct CommandEntry
+    {
+        uint32_t hash;            // 名称哈希
+        const char *name;         // 命令名称
+        WsCommandHandler handler; // 处理函数
+    };
+
+    WebSocketManager *_wsManager;                                // WebSocket管理器
+    CommandEntry _commands[WS_COMMAND_MAX_HANDLERS];             // 已注册的命令
+    uint8_t _commandCount;                                       // 已注册的命令数量
+    StaticJsonDocument<WS_COMMAND_REQUEST_DOC_SIZE> _requestDoc; // 请求文档（复用）
+    StaticJsonDocument<WS_COMMAND_REPLY_DOC_SIZE> _replyDoc;     // 应答文档（复用）
+    char _replyBuffer[WS_COMMAND_REPLY_BUFFER];                  // 应答序列化缓冲区
+
+    /**
+     * 按哈希值查找命令
+     */
+    const CommandEntry *find(uint32_t hash, const char *name) const;
+
+    /**
+     * 发送应答
+     */
+    void sendReply(uint8_t num);
+
+    /**
+     * 发送错误应答
+     */
+    void sendError(uint8_t num, JsonVariantConst id, const char *code);
+
+    /**
+     * 按客户端的编码序列化到应答缓冲区并发送
+     *
+     * @return 缓冲区不足时返回false
+     */
+    bool sendBuffered(uint8_t num, const JsonDocument &doc);
+};
+
+#endif // WS_COMMAND_DISPATCHER_H
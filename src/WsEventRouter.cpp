@@ -0,0 +1,99 @@
+/**
+ * WsEventRouter.cpp
+ *
+ * WebSocket事件路由模块的实现
+ *
+ * @file WsEventRouter.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "WsEventRouter.h"
+#include "WebSocketManager.h"
+#include "MetricsRegistry.h"
+
+// 导出到 /metrics 的WebSocket指标
+static const uint32_t wsFrameSizeBounds[] = {16, 64, 256, 1024, 4096};
+static MetricGauge wsClientsMetric("ws_clients", "已连接的WebSocket客户端数量");
+static MetricCounter wsConnectsMetric("ws_connections", "WebSocket连接次数");
+static MetricCounter wsTextFramesMetric("ws_received_frames", "收到的WebSocket消息数", "type=\"text\"");
+static MetricCounter wsBinaryFramesMetric("ws_received_frames", "收到的WebSocket消息数", "type=\"binary\"");
+static MetricHistogram wsFrameSizeMetric("ws_received_frame_bytes", "收到的WebSocket消息大小",
+                                         wsFrameSizeBounds, sizeof(wsFrameSizeBounds) / sizeof(wsFrameSizeBounds[0]));
+
+/**
+ * 构造函数
+ */
+WsEventRouter::WsEventRouter(WebSocketManager *wsManager) : _wsManager(wsManager),
+                                                            _listenerCount(0)
+{
+}
+
+/**
+ * 安装事件回调
+ */
+void WsEventRouter::begin()
+{
+    _wsManager->onEvent([this](uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+                        { dispatch(num, type, payload, length); });
+}
+
+/**
+ * 注册监听器
+ */
+bool WsEventRouter::addListener(WsEventListener listener)
+{
+    if (_listenerCount >= WS_ROUTER_MAX_LISTENERS)
+    {
+        Serial.println("WebSocket监听器数量已达上限");
+        return false;
+    }
+
+    _listeners[_listenerCount++] = listener;
+    return true;
+}
+
+/**
+ * 分发事件
+ */
+void WsEventRouter::dispatch(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+{
+    switch (type)
+    {
+    case WStype_CONNECTED:
+        // 未完成握手的连接也会触发断开事件，按实际连接数设置而不是增减
+        wsClientsMetric.set((int32_t)_wsManager->getClientCount());
+        wsConnectsMetric.inc();
+        // 连接事件的payload为请求的URL
+        _wsManager->setClientEncoding(num, MessageCodec::fromUrl((const char *)payload));
+        break;
+    case WStype_DISCONNECTED:
+        wsClientsMetric.set((int32_t)_wsManager->getClientCount());
+        _wsManager->setClientEncoding(num, MESSAGE_JSON);
+        break;
+    case WStype_TEXT:
+        wsTextFramesMetric.inc();
+        wsFrameSizeMetric.observe(length);
+        break;
+    case WStype_BIN:
+        wsBinaryFramesMetric.inc();
+        wsFrameSizeMetric.observe(length);
+        break;
+    default:
+        break;
+    }
+
+    // 连接状态变化需要所有模块都知道
+    bool broadcast = type == WStype_CONNECTED || type == WStype_DISCONNECTED;
+
+    for (uint8_t i = 0; i < _listenerCount; i++)
+    {
+        if (_listeners[i](num, type, payload, length) && !broadcast)
+        {
+            return;
+        }
+    }
+
+    WebSocketManager::webSocketEvent(num, type, payload, length);
+}
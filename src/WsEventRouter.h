@@ -0,0 +1,78 @@
+/**
+ * WsEventRouter.h
+ *
+ * WebSocket事件路由模块，让多个模块共享同一个WebSocket服务器的事件
+ *
+ * @file WsEventRouter.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef WS_EVENT_ROUTER_H
+#define WS_EVENT_ROUTER_H
+
+#include <Arduino.h>
+#include <functional>
+#include <WebSocketsServer.h>
+
+// 路由配置
+#define WS_ROUTER_MAX_LISTENERS 6 // 最多注册的监听器数量
+
+// 前向声明
+class WebSocketManager;
+
+/**
+ * WebSocket事件监听器
+ *
+ * @param num 客户端编号
+ * @param type 事件类型
+ * @param payload 数据（可以原地修改）
+ * @param length 数据长度
+ * @return 事件是否已被处理, 返回true时不再传给后续监听器和默认处理函数
+ */
+typedef std::function<bool(uint8_t num, WStype_t type, uint8_t *payload, size_t length)> WsEventListener;
+
+/**
+ * WebSocket事件路由器类
+ *
+ * 接管WebSocketManager的事件回调，按注册顺序把事件交给监听器，
+ * 未被处理的事件仍交给WebSocketManager原有的处理函数
+ */
+class WsEventRouter
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param wsManager WebSocket管理器
+     */
+    WsEventRouter(WebSocketManager *wsManager);
+
+    /**
+     * 安装事件回调，需要在WebSocketManager::begin()之后调用
+     */
+    void begin();
+
+    /**
+     * 注册监听器
+     *
+     * 连接和断开事件总是传给所有监听器，不会被拦截
+     *
+     * @param listener 监听器
+     * @return 是否注册成功
+     */
+    bool addListener(WsEventListener listener);
+
+private:
+    WebSocketManager *_wsManager;                        // WebSocket管理器
+    WsEventListener _listeners[WS_ROUTER_MAX_LISTENERS]; // 监听器
+    uint8_t _listenerCount;                              // 监听器数量
+
+    /**
+     * 分发事件
+     */
+    void dispatch(uint8_t num, WStype_t type, uint8_t *payload, size_t length);
+};
+
+#endif // WS_EVENT_ROUTER_H
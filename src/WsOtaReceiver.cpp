@@ -0,0 +1,353 @@
+/**
+ * WsOtaReceiver.cpp
+ *
+ * WebSocket OTA接收模块的实现
+ *
+ * @file WsOtaReceiver.cpp
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#include "WsOtaReceiver.h"
+#include "WebSocketManager.h"
+#include "OTAManager.h"
+#include "WsEventRouter.h"
+#include "BinaryLog.h"
+
+#define WS_OTA_HEADER_SIZE 8
+#define WS_OTA_BEGIN_SIZE 8
+#define WS_OTA_ACK_SIZE 20
+#define WS_OTA_FLAG_RESUME 0x01
+
+namespace
+{
+    inline uint16_t readU16(const uint8_t *p)
+    {
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+    }
+
+    inline uint32_t readU32(const uint8_t *p)
+    {
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    inline void writeU16(uint8_t *p, uint16_t value)
+    {
+        p[0] = value;
+        p[1] = value >> 8;
+    }
+
+    inline void writeU32(uint8_t *p, uint32_t value)
+    {
+        p[0] = value;
+        p[1] = value >> 8;
+        p[2] = value >> 16;
+        p[3] = value >> 24;
+    }
+}
+
+/**
+ * 构造函数
+ */
+WsOtaReceiver::WsOtaReceiver(WebSocketManager *wsManager, OTAManager *otaManager) : _wsManager(wsManager),
+                                                                                    _otaManager(otaManager),
+                                                                                    _active(false),
+                                                                                    _ownerConnected(false),
+                                                                                    _owner(0),
+                                                                                    _updateType(0),
+                                                                                    _chunkSize(0),
+                                                                                    _totalSize(0),
+                                                                                    _nextSeq(0),
+                                                                                    _written(0),
+                                                                                    _unacked(0),
+                                                                                    _gapAcked(false),
+                                                                                    _lastActivity(0)
+{
+    _md5[0] = '\0';
+}
+
+/**
+ * 注册到WebSocket事件路由器
+ */
+void WsOtaReceiver::begin(WsEventRouter *router)
+{
+    router->addListener([this](uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+                        { return onEvent(num, type, payload, length); });
+}
+
+/**
+ * 处理会话超时
+ */
+void WsOtaReceiver::handle()
+{
+    if (!_active)
+    {
+        return;
+    }
+
+    uint32_t timeout = _ownerConnected ? WS_OTA_IDLE_TIMEOUT : WS_OTA_RESUME_TIMEOUT;
+    if (millis() - _lastActivity > timeout)
+    {
+        BLOG("WebSocket OTA会话超时, 已接收 %u / %u bytes\n", _written, _totalSize);
+        closeSession(true);
+    }
+}
+
+/**
+ * 是否有进行中的会话
+ */
+bool WsOtaReceiver::isActive() const
+{
+    return _active;
+}
+
+/**
+ * 处理WebSocket事件
+ */
+bool WsOtaReceiver::onEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length)
+{
+    if (type == WStype_DISCONNECTED)
+    {
+        if (_active && _ownerConnected && num == _owner)
+        {
+            // 保留会话，客户端可以重新连接后续传
+            _ownerConnected = false;
+            _lastActivity = millis();
+        }
+        return false;
+    }
+
+    if (type != WStype_BIN || length < WS_OTA_HEADER_SIZE || payload[0] != WS_OTA_MAGIC)
+    {
+        return false;
+    }
+
+    uint8_t op = payload[1];
+    uint32_t seq = readU32(payload + 4);
+    const uint8_t *data = payload + WS_OTA_HEADER_SIZE;
+    size_t dataLength = length - WS_OTA_HEADER_SIZE;
+
+    switch (op)
+    {
+    case WS_OTA_OP_BEGIN:
+        handleBegin(num, data, dataLength);
+        break;
+    case WS_OTA_OP_DATA:
+        handleData(num, seq, data, dataLength);
+        break;
+    case WS_OTA_OP_END:
+        handleEnd(num);
+        break;
+    case WS_OTA_OP_ABORT:
+        if (_active && num == _owner)
+        {
+            BLOG("WebSocket OTA已被客户端取消\n");
+            closeSession(true);
+            sendAck(num, WS_OTA_STATUS_OK);
+        }
+        else
+        {
+            sendAck(num, WS_OTA_STATUS_NO_SESSION);
+        }
+        break;
+    default:
+        sendAck(num, WS_OTA_STATUS_BAD_REQUEST);
+        break;
+    }
+    return true;
+}
+
+/**
+ * 处理BEGIN帧
+ */
+void WsOtaReceiver::handleBegin(uint8_t num, const uint8_t *data, size_t length)
+{
+    if (length < WS_OTA_BEGIN_SIZE)
+    {
+        sendAck(num, WS_OTA_STATUS_BAD_REQUEST);
+        return;
+    }
+
+    uint32_t totalSize = readU32(data);
+    uint8_t updateType = data[4];
+    uint8_t flags = data[5];
+    uint16_t chunkSize = readU16(data + 6);
+
+    if (chunkSize > WS_OTA_MAX_CHUNK)
+    {
+        chunkSize = WS_OTA_MAX_CHUNK;
+    }
+
+    char md5[33] = "";
+    if (length >= WS_OTA_BEGIN_SIZE + 32)
+    {
+        memcpy(md5, data + WS_OTA_BEGIN_SIZE, 32);
+        md5[32] = '\0';
+    }
+
+    // 同一镜像的续传请求，继续原来的会话（大小相同但内容不同的镜像由MD5区分）
+    if (_active && (flags & WS_OTA_FLAG_RESUME) && totalSize == _totalSize &&
+        updateType == _updateType && chunkSize == _chunkSize && strcasecmp(md5, _md5) == 0 &&
+        (!_ownerConnected || num == _owner) && _otaManager->isUpdateOwner(this))
+    {
+        _owner = num;
+        _ownerConnected = true;
+        _lastActivity = millis();
+        _unacked = 0;
+        BLOG("WebSocket OTA续传, 从 %u bytes 继续\n", _written);
+        sendAck(num, WS_OTA_STATUS_OK);
+        return;
+    }
+
+    if ((_active && _ownerConnected && num != _owner) ||
+        (_otaManager->isUpdating() && !_otaManager->isUpdateOwner(this)))
+    {
+        // 其他客户端、HTTP上传或设备间分发正在更新
+        sendAck(num, WS_OTA_STATUS_BUSY);
+        return;
+    }
+
+    if (!totalSize || !chunkSize || (updateType != 1 && updateType != 2))
+    {
+        sendAck(num, WS_OTA_STATUS_BAD_REQUEST);
+        return;
+    }
+
+    if (_active)
+    {
+        closeSession(true);
+    }
+
+    BLOG("开始接收WebSocket OTA, %u bytes, 块大小 %u\n", totalSize, chunkSize);
+    if (!_otaManager->beginUpdate(this, updateType, totalSize, md5[0] ? md5 : nullptr))
+    {
+        sendAck(num, WS_OTA_STATUS_FLASH_ERROR);
+        return;
+    }
+
+    _active = true;
+    _ownerConnected = true;
+    _owner = num;
+    _updateType = updateType;
+    _chunkSize = chunkSize;
+    _totalSize = totalSize;
+    strlcpy(_md5, md5, sizeof(_md5));
+    _nextSeq = 0;
+    _written = 0;
+    _unacked = 0;
+    _gapAcked = false;
+    _lastActivity = millis();
+
+    sendAck(num, WS_OTA_STATUS_OK);
+}
+
+/**
+ * 处理DATA帧
+ */
+void WsOtaReceiver::handleData(uint8_t num, uint32_t seq, const uint8_t *data, size_t length)
+{
+    if (!_active || num != _owner)
+    {
+        sendAck(num, WS_OTA_STATUS_NO_SESSION);
+        return;
+    }
+    _lastActivity = millis();
+
+    if (seq != _nextSeq)
+    {
+        // 重复的块直接确认；缺失的块之后的数据丢弃，客户端从确认的位置重发
+        if (seq < _nextSeq || !_gapAcked)
+        {
+            _gapAcked = seq > _nextSeq;
+            _unacked = 0;
+            sendAck(num, WS_OTA_STATUS_OK);
+        }
+        return;
+    }
+
+    bool last = _written + length == _totalSize;
+    if ((length != _chunkSize && !last) || _written + length > _totalSize)
+    {
+        closeSession(true);
+        sendAck(num, WS_OTA_STATUS_BAD_REQUEST);
+        return;
+    }
+
+    if (!_otaManager->writeUpdate(this, data, length))
+    {
+        closeSession(false);
+        sendAck(num, WS_OTA_STATUS_FLASH_ERROR);
+        return;
+    }
+
+    _written += length;
+    _nextSeq++;
+    _gapAcked = false;
+
+    // 累计确认，每半个窗口确认一次，客户端始终有数据可发
+    if (++_unacked >= WS_OTA_WINDOW / 2 || last)
+    {
+        _unacked = 0;
+        sendAck(num, WS_OTA_STATUS_OK);
+    }
+}
+
+/**
+ * 处理END帧
+ */
+void WsOtaReceiver::handleEnd(uint8_t num)
+{
+    if (!_active || num != _owner)
+    {
+        sendAck(num, WS_OTA_STATUS_NO_SESSION);
+        return;
+    }
+
+    if (_written != _totalSize)
+    {
+        // 数据还没有全部到达，告诉客户端从哪里继续
+        sendAck(num, WS_OTA_STATUS_OK);
+        return;
+    }
+
+    // 校验成功后OTAManager会安排重启，确认帧在重启前发出
+    bool verified = _otaManager->endUpdate(this);
+    closeSession(false);
+    sendAck(num, verified ? WS_OTA_STATUS_DONE : WS_OTA_STATUS_VERIFY_FAILED);
+}
+
+/**
+ * 发送确认
+ */
+void WsOtaReceiver::sendAck(uint8_t num, uint8_t status)
+{
+    uint8_t ack[WS_OTA_ACK_SIZE];
+    ack[0] = WS_OTA_MAGIC;
+    ack[1] = WS_OTA_OP_ACK;
+    ack[2] = status;
+    ack[3] = WS_OTA_WINDOW;
+    writeU32(ack + 4, _nextSeq);
+    writeU32(ack + 8, _written);
+    writeU32(ack + 12, _totalSize);
+    writeU16(ack + 16, _chunkSize);
+    writeU16(ack + 18, 0);
+
+    _wsManager->sendBIN(num, ack, sizeof(ack));
+}
+
+/**
+ * 结束会话
+ */
+void WsOtaReceiver::closeSession(bool abortUpdate)
+{
+    if (abortUpdate)
+    {
+        // 只放弃本会话的更新，不影响其他传输方式
+        _otaManager->abortUpdate(this);
+    }
+    _active = false;
+    _ownerConnected = false;
+    _unacked = 0;
+    _gapAcked = false;
+}
@@ -0,0 +1,134 @@
+/**
+ * WsOtaReceiver.h
+ *
+ * WebSocket OTA接收模块，通过WebSocket二进制帧接收固件，使用滑动窗口流控
+ *
+ * 帧格式（小端）:
+ *   客户端 -> 设备: 'O', 操作码, 2字节保留, uint32 序号, 数据
+ *     BEGIN: uint32 镜像大小, uint8 更新类型, uint8 标志(bit0: 续传), uint16 块大小, [32字节MD5]
+ *     DATA:  一个数据块, 序号从0开始连续递增
+ *     END:   无数据
+ *     ABORT: 无数据
+ *   设备 -> 客户端 (ACK): 'O', 0x80, 状态, 窗口大小, uint32 期望的下一个序号,
+ *     uint32 已写入字节数, uint32 总字节数, uint16 块大小, 2字节保留
+ *
+ * @file WsOtaReceiver.h
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+#ifndef WS_OTA_RECEIVER_H
+#define WS_OTA_RECEIVER_H
+
+#include <Arduino.h>
+#include <WebSocketsServer.h>
+
+// 传输配置
+#define WS_OTA_WINDOW 8             // 允许在途的最大块数
+#define WS_OTA_MAX_CHUNK 4096       // 最大块大小（字节）
+#define WS_OTA_RESUME_TIMEOUT 30000 // 客户端断开后保留会话等待续传的时间（毫秒）
+#define WS_OTA_IDLE_TIMEOUT 30000   // 会话无数据的最长时间（毫秒）
+
+// 帧标记和操作码
+#define WS_OTA_MAGIC 'O'
+#define WS_OTA_OP_BEGIN 0x01
+#define WS_OTA_OP_DATA 0x02
+#define WS_OTA_OP_END 0x03
+#define WS_OTA_OP_ABORT 0x04
+#define WS_OTA_OP_ACK 0x80
+
+// ACK状态
+#define WS_OTA_STATUS_OK 0
+#define WS_OTA_STATUS_DONE 1
+#define WS_OTA_STATUS_BUSY 2
+#define WS_OTA_STATUS_BAD_REQUEST 3
+#define WS_OTA_STATUS_FLASH_ERROR 4
+#define WS_OTA_STATUS_VERIFY_FAILED 5
+#define WS_OTA_STATUS_NO_SESSION 6
+
+// 前向声明
+class WebSocketManager;
+class OTAManager;
+class WsEventRouter;
+
+/**
+ * WebSocket OTA接收器类
+ *
+ * 数据块按序号写入OTAManager的更新路径（与HTTP上传相同），
+ * 每收到半个窗口的数据发送一次累计确认，确认中附带进度
+ */
+class WsOtaReceiver
+{
+public:
+    /**
+     * 构造函数
+     *
+     * @param wsManager WebSocket管理器, 用于发送确认
+     * @param otaManager OTA管理器, 负责写入闪存
+     */
+    WsOtaReceiver(WebSocketManager *wsManager, OTAManager *otaManager);
+
+    /**
+     * 注册到WebSocket事件路由器
+     *
+     * @param router 事件路由器
+     */
+    void begin(WsEventRouter *router);
+
+    /**
+     * 处理会话超时，需要在loop()中调用
+     */
+    void handle();
+
+    /**
+     * 是否有进行中的会话
+     *
+     * @return 是否有会话
+     */
+    bool isActive() const;
+
+private:
+    WebSocketManager *_wsManager; // WebSocket管理器
+    OTAManager *_otaManager;      // OTA管理器
+    bool _active;                 // 是否有进行中的会话
+    bool _ownerConnected;         // 会话所属客户端是否在线
+    uint8_t _owner;               // 会话所属客户端编号
+    uint8_t _updateType;          // 更新类型
+    uint16_t _chunkSize;          // 块大小
+    uint32_t _totalSize;          // 镜像大小
+    char _md5[33];                // BEGIN中的镜像MD5，没有时为空
+    uint32_t _nextSeq;            // 期望的下一个序号
+    uint32_t _written;            // 已写入字节数
+    uint8_t _unacked;             // 未确认的块数
+    bool _gapAcked;               // 乱序时是否已发送过确认
+    unsigned long _lastActivity;  // 最后一次收到数据或断开的时间
+
+    /**
+     * 处理WebSocket事件
+     *
+     * @return 事件是否属于本模块
+     */
+    bool onEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t length);
+
+    void handleBegin(uint8_t num, const uint8_t *data, size_t length);
+    void handleData(uint8_t num, uint32_t seq, const uint8_t *data, size_t length);
+    void handleEnd(uint8_t num);
+
+    /**
+     * 发送确认
+     *
+     * @param num 客户端编号
+     * @param status 状态
+     */
+    void sendAck(uint8_t num, uint8_t status);
+
+    /**
+     * 结束会话
+     *
+     * @param abortUpdate 是否放弃已写入的更新
+     */
+    void closeSession(bool abortUpdate);
+};
+
+#endif // WS_OTA_RECEIVER_H
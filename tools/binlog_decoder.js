@@ -0,0 +1,180 @@
+/**
+ * binlog_decoder.js
+ *
+ * 浏览器端二进制日志解码器，配合BinaryLog模块使用
+ *
+ * 用法:
+ *   const decoder = new BinaryLogDecoder();
+ *   ws.binaryType = 'arraybuffer';
+ *   ws.onmessage = (event) => {
+ *       if (typeof event.data === 'string') {
+ *           if (decoder.handleText(event.data)) return;
+ *           // 其他文本消息
+ *       } else {
+ *           decoder.handleBinary(event.data).forEach((line) => console.log(line.time, line.text));
+ *       }
+ *   };
+ *
+ * @file binlog_decoder.js
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+class BinaryLogDecoder {
+    constructor() {
+        this.formats = [];
+    }
+
+    /**
+     * 处理文本消息，识别格式字符串表
+     *
+     * @param {string} text 文本消息
+     * @return {boolean} 是否为格式表消息
+     */
+    handleText(text) {
+        let message;
+        try {
+            message = JSON.parse(text);
+        } catch (e) {
+            return false;
+        }
+        if (!message || message.type !== 'log_formats') {
+            return false;
+        }
+        message.formats.forEach((format, i) => {
+            this.formats[message.base + i] = format;
+        });
+        return true;
+    }
+
+    /**
+     * 解码二进制日志帧
+     *
+     * @param {ArrayBuffer} buffer 二进制帧
+     * @return {Array<{time: number, text: string}>} 日志行
+     */
+    handleBinary(buffer) {
+        const view = new DataView(buffer);
+        const lines = [];
+        // 帧头: 'L', 版本号, 2字节保留
+        if (view.byteLength < 4 || view.getUint8(0) !== 0x4c || view.getUint8(1) !== 1) {
+            return lines;
+        }
+
+        let offset = 4;
+        while (offset + 8 <= view.byteLength) {
+            const header = view.getUint32(offset, true);
+            const size = header & 0xffff;
+            if (size < 8 || offset + size > view.byteLength) {
+                break;
+            }
+            const formatId = (header >>> 16) & 0x7fff;
+            const time = view.getUint32(offset + 4, true);
+            const args = this.readArgs(view, offset + 8, offset + size);
+            const format = this.formats[formatId];
+            lines.push({
+                time,
+                text: format !== undefined ? this.format(format, args) : `<未知格式 ${formatId}> ${args.join(' ')}`,
+            });
+            offset += size;
+        }
+        return lines;
+    }
+
+    readArgs(view, offset, end) {
+        const args = [];
+        let argc = view.getUint8(offset++);
+        while (argc-- > 0 && offset < end) {
+            const tag = String.fromCharCode(view.getUint8(offset++));
+            if (tag === 's') {
+                const len = view.getUint8(offset++);
+                args.push(new TextDecoder().decode(new Uint8Array(view.buffer, view.byteOffset + offset, len)));
+                offset += len;
+            } else if (tag === 'i') {
+                args.push(view.getInt32(offset, true));
+                offset += 4;
+            } else if (tag === 'u') {
+                args.push(view.getUint32(offset, true));
+                offset += 4;
+            } else if (tag === 'f') {
+                args.push(view.getFloat32(offset, true));
+                offset += 4;
+            } else {
+                break;
+            }
+        }
+        return args;
+    }
+
+    /**
+     * 简化的printf实现，支持标志、宽度和精度
+     */
+    format(format, args) {
+        let index = 0;
+        return format.replace(/%([-+ 0#]*)(\d*)(?:\.(\d+))?[hlLqjzt]*([diouxXcsfFeEgGp%])/g,
+            (match, flags, width, precision, conversion) => {
+                if (conversion === '%') {
+                    return '%';
+                }
+                if (index >= args.length) {
+                    return match;
+                }
+                const value = args[index++];
+                let text;
+                switch (conversion) {
+                    case 'd':
+                    case 'i':
+                    case 'u':
+                        text = String(Math.trunc(value));
+                        break;
+                    case 'o':
+                        text = (value >>> 0).toString(8);
+                        break;
+                    case 'x':
+                    case 'p':
+                        text = (value >>> 0).toString(16);
+                        break;
+                    case 'X':
+                        text = (value >>> 0).toString(16).toUpperCase();
+                        break;
+                    case 'c':
+                        text = String.fromCharCode(value);
+                        break;
+                    case 'f':
+                    case 'F':
+                        text = Number(value).toFixed(precision !== undefined ? Number(precision) : 6);
+                        break;
+                    case 'e':
+                    case 'E':
+                        text = Number(value).toExponential(precision !== undefined ? Number(precision) : 6);
+                        break;
+                    case 'g':
+                    case 'G':
+                        text = String(Number(Number(value).toPrecision(precision !== undefined ? Number(precision) || 1 : 6)));
+                        break;
+                    default:
+                        text = String(value);
+                        if (precision !== undefined) {
+                            text = text.substring(0, Number(precision));
+                        }
+                }
+                if (flags.includes('+') && typeof value === 'number' && value >= 0 && conversion !== 's') {
+                    text = '+' + text;
+                }
+                const padLength = Number(width || 0);
+                if (text.length < padLength) {
+                    if (flags.includes('-')) {
+                        text = text.padEnd(padLength);
+                    } else {
+                        text = text.padStart(padLength, flags.includes('0') && conversion !== 's' ? '0' : ' ');
+                    }
+                }
+                return text;
+            });
+    }
+}
+
+if (typeof module !== 'undefined') {
+    module.exports = BinaryLogDecoder;
+}
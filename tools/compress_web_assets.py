@@ -0,0 +1,186 @@
+#!/usr/bin/env python3
+"""
+compress_web_assets.py
+
+将 data/ 目录中的文本类 Web 资源预压缩为 .gz 文件，供 StaticAssetHandler
+以 Content-Encoding: gzip 直接发送。输出是确定性的（不写入时间戳），
+内容不变时生成的文件和 ETag 也不变。
+
+用法:
+    python tools/compress_web_assets.py [data目录] --output <输出目录>
+    python tools/compress_web_assets.py [data目录] [--remove-originals]
+
+指定 --output 时把 data 目录复制到输出目录，可压缩的文件只保留 .gz，
+不修改 data 目录；否则在 data 目录中原地生成 .gz。
+
+在 PlatformIO 中可以在构建文件系统镜像前运行，例如在 platformio.ini 中:
+    extra_scripts = pre:tools/compress_web_assets.py
+此时文件系统镜像由 $BUILD_DIR/data_gz 生成，data 目录保持不变。
+
+指定 --output 时 tools/ 中的浏览器端解码器（msgpack_decoder.js、binlog_decoder.js）
+也复制到输出目录的 js/ 下，data 目录中已有同名文件时使用 data 中的版本。
+"""
+
+import gzip
+import inspect
+import os
+import shutil
+import sys
+
+# 值得压缩的扩展名
+COMPRESSIBLE = (".html", ".htm", ".css", ".js", ".json", ".svg", ".txt", ".ico")
+
+# 随界面一起打包的浏览器端解码器: 资源路径 -> tools/ 中的文件名
+CLIENT_LIBS = {
+    "js/binlog_decoder.js": "binlog_decoder.js",
+    "js/msgpack_decoder.js": "msgpack_decoder.js",
+}
+
+
+def tools_dir():
+    # 作为PlatformIO extra_script执行时没有__file__
+    return os.path.dirname(os.path.abspath(inspect.getfile(tools_dir)))
+
+
+def stage_file(path, target):
+    """把一个文件写入暂存目录，压缩有收益时只写 .gz，返回 (原大小, 输出大小)"""
+    with open(path, "rb") as f:
+        raw = f.read()
+    packed = gzip.compress(raw, compresslevel=9, mtime=0)
+
+    if len(packed) < len(raw):
+        with open(target + ".gz", "wb") as f:
+            f.write(packed)
+    else:
+        packed = raw
+        shutil.copyfile(path, target)
+    return len(raw), len(packed)
+
+
+def compress_file(path, remove_original):
+    with open(path, "rb") as f:
+        raw = f.read()
+
+    # mtime=0 保证输出确定
+    packed = gzip.compress(raw, compresslevel=9, mtime=0)
+    gz_path = path + ".gz"
+
+    if len(packed) >= len(raw):
+        # 压缩无收益时删除旧的.gz，保留原文件
+        if os.path.exists(gz_path):
+            os.remove(gz_path)
+        return len(raw), len(raw)
+
+    with open(gz_path, "wb") as f:
+        f.write(packed)
+
+    if remove_original:
+        os.remove(path)
+    return len(raw), len(packed)
+
+
+def stage_directory(data_dir, out_dir):
+    """把 data_dir 复制到 out_dir，可压缩且有收益的文件只保留 .gz"""
+    if os.path.isdir(out_dir):
+        shutil.rmtree(out_dir)
+
+    total_raw = 0
+    total_packed = 0
+
+    for root, dirs, files in os.walk(data_dir):
+        dirs.sort()
+        target_root = os.path.normpath(os.path.join(out_dir, os.path.relpath(root, data_dir)))
+        os.makedirs(target_root, exist_ok=True)
+
+        for name in sorted(files):
+            path = os.path.join(root, name)
+            target = os.path.join(target_root, name)
+
+            if name.endswith(".gz") and os.path.exists(path[:-3]):
+                # 以前原地压缩留下的.gz，由原文件重新生成
+                continue
+
+            if not name.lower().endswith(COMPRESSIBLE):
+                shutil.copyfile(path, target)
+                continue
+
+            raw, packed = stage_file(path, target)
+            total_raw += raw
+            total_packed += packed
+            print("%-40s %7d -> %7d" % (os.path.relpath(path, data_dir), raw, packed))
+
+    for rel, name in sorted(CLIENT_LIBS.items()):
+        path = os.path.join(tools_dir(), name)
+        existing = os.path.join(data_dir, rel)
+        if os.path.exists(existing) or os.path.exists(existing + ".gz") or not os.path.exists(path):
+            continue
+        target = os.path.join(out_dir, rel)
+        os.makedirs(os.path.dirname(target), exist_ok=True)
+        raw, packed = stage_file(path, target)
+        total_raw += raw
+        total_packed += packed
+        print("%-40s %7d -> %7d" % (rel + " (tools/" + name + ")", raw, packed))
+
+    if total_raw:
+        print("合计: %d -> %d 字节 (%.1f%%)" % (total_raw, total_packed, 100.0 * total_packed / total_raw))
+
+
+def compress_directory(data_dir, remove_original=False):
+    total_raw = 0
+    total_packed = 0
+
+    for root, _, files in os.walk(data_dir):
+        for name in sorted(files):
+            if not name.lower().endswith(COMPRESSIBLE):
+                continue
+            path = os.path.join(root, name)
+            raw, packed = compress_file(path, remove_original)
+            total_raw += raw
+            total_packed += packed
+            print("%-40s %7d -> %7d" % (os.path.relpath(path, data_dir), raw, packed))
+
+    if total_raw:
+        print("合计: %d -> %d 字节 (%.1f%%)" % (total_raw, total_packed, 100.0 * total_packed / total_raw))
+
+
+def main(argv):
+    output = None
+    args = []
+    i = 0
+    while i < len(argv):
+        if argv[i] == "--output" and i + 1 < len(argv):
+            output = argv[i + 1]
+            i += 2
+            continue
+        if not argv[i].startswith("--"):
+            args.append(argv[i])
+        i += 1
+
+    data_dir = args[0] if args else "data"
+    if not os.path.isdir(data_dir):
+        print("目录不存在: %s" % data_dir)
+        return 1
+    if output:
+        stage_directory(data_dir, output)
+    else:
+        compress_directory(data_dir, "--remove-originals" in argv)
+    return 0
+
+
+try:
+    # 作为PlatformIO extra_script加载时，文件系统镜像改由暂存目录生成
+    Import("env")  # noqa: F821
+
+    _source_dir = env.subst("$PROJECT_DATA_DIR")  # noqa: F821
+    _staged_dir = os.path.join(env.subst("$BUILD_DIR"), "data_gz")  # noqa: F821
+    os.makedirs(_staged_dir, exist_ok=True)
+    env.Replace(PROJECT_DATA_DIR=_staged_dir)  # noqa: F821
+
+    def _before_buildfs(source, target, env):
+        stage_directory(_source_dir, _staged_dir)
+
+    env.AddPreAction("$BUILD_DIR/littlefs.bin", _before_buildfs)  # noqa: F821
+    env.AddPreAction("$BUILD_DIR/spiffs.bin", _before_buildfs)  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        sys.exit(main(sys.argv[1:]))
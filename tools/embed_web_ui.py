@@ -0,0 +1,215 @@
+#!/usr/bin/env python3
+"""
+embed_web_ui.py
+
+将 data/ 目录中的 Web 界面压缩后生成 src/EmbeddedWebUIData.h：
+每个文件是一个位于 Flash 中的 constexpr 字节数组，附带预先计算的 ETag，
+以及按路径排序的静态路由表，供 EmbeddedAssetHandler 使用。
+
+用法:
+    python tools/embed_web_ui.py [data目录] [输出文件]
+
+输出文件默认写入本库的 src/ 目录，与 EmbeddedAssetHandler.h 相邻，
+库中带引号的 __has_include("EmbeddedWebUIData.h") 才能找到它。
+
+在 PlatformIO 中可以在每次编译前自动生成：
+    extra_scripts = pre:tools/embed_web_ui.py
+此时头文件生成到 $BUILD_DIR/embedded_web_ui，并把该目录加入包含路径
+（库也使用项目的包含路径），不修改库和项目的源代码目录。
+
+tools/ 中的浏览器端解码器（msgpack_decoder.js、binlog_decoder.js）
+作为 /js/ 下的资源一起嵌入，data 目录中已有同名文件时使用 data 中的版本。
+"""
+
+import gzip
+import inspect
+import os
+import re
+import sys
+
+CONTENT_TYPES = {
+    ".html": "text/html",
+    ".htm": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".json": "application/json",
+    ".svg": "image/svg+xml",
+    ".png": "image/png",
+    ".jpg": "image/jpeg",
+    ".jpeg": "image/jpeg",
+    ".ico": "image/x-icon",
+    ".woff2": "font/woff2",
+    ".txt": "text/plain",
+}
+
+# 随界面一起嵌入的浏览器端解码器: 资源路径 -> tools/ 中的文件名
+CLIENT_LIBS = {
+    "js/binlog_decoder.js": "binlog_decoder.js",
+    "js/msgpack_decoder.js": "msgpack_decoder.js",
+}
+
+FNV_OFFSET_BASIS = 2166136261
+FNV_PRIME = 16777619
+
+
+def fnv1a(data, h=FNV_OFFSET_BASIS):
+    for b in data:
+        h ^= b
+        h = (h * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def symbol_for(rel_path):
+    return "asset_" + re.sub(r"[^0-9A-Za-z]", "_", rel_path)
+
+
+def tools_dir():
+    # 作为PlatformIO extra_script执行时没有__file__
+    return os.path.dirname(os.path.abspath(inspect.getfile(tools_dir)))
+
+
+def source_files(data_dir):
+    """data 目录中的文件和尚未包含的解码器，返回 (资源路径, 文件路径) 列表"""
+    files = []
+    for root, _, names in os.walk(data_dir):
+        for name in sorted(names):
+            path = os.path.join(root, name)
+            rel = os.path.relpath(path, data_dir).replace(os.sep, "/")
+            # 已经预压缩的文件跳过，由生成器自行压缩原文件
+            if rel.endswith(".gz") and os.path.exists(path[:-3]):
+                continue
+            files.append((rel, path))
+    if not files:
+        # 没有界面时不单独嵌入解码器
+        return files
+
+    present = set(rel[:-3] if rel.endswith(".gz") else rel for rel, _ in files)
+    for rel, name in sorted(CLIENT_LIBS.items()):
+        path = os.path.join(tools_dir(), name)
+        if rel not in present and os.path.exists(path):
+            files.append((rel, path))
+    return files
+
+
+def collect_assets(data_dir):
+    assets = []
+    for rel, path in source_files(data_dir):
+        with open(path, "rb") as f:
+            raw = f.read()
+
+        packed = gzip.compress(raw, compresslevel=9, mtime=0)
+        is_gzip = len(packed) < len(raw)
+        content = packed if is_gzip else raw
+
+        ext = os.path.splitext(rel)[1].lower()
+        # ETag与StaticAssetHandler的计算方式一致：变体字节 + 内容的FNV-1a
+        etag = fnv1a(content, fnv1a(bytes([1 if is_gzip else 0])))
+
+        assets.append({
+            "rel": rel,
+            "symbol": symbol_for(rel),
+            "content_type": CONTENT_TYPES.get(ext, "application/octet-stream"),
+            "etag": '\\"%08x\\"' % etag,
+            "data": content,
+            "gzip": is_gzip,
+            "raw_size": len(raw),
+        })
+    return assets
+
+
+def routes_for(assets):
+    routes = []
+    for asset in assets:
+        uri = "/" + asset["rel"]
+        routes.append((uri, asset))
+        # 目录首页同时映射到目录路径
+        if uri.endswith("/index.html"):
+            routes.append((uri[: -len("index.html")], asset))
+    # 处理器使用strcmp二分查找，按字节序排序
+    routes.sort(key=lambda r: r[0].encode("utf-8"))
+    return routes
+
+
+def write_header(assets, out_path):
+    lines = []
+    lines.append("/**")
+    lines.append(" * EmbeddedWebUIData.h")
+    lines.append(" *")
+    lines.append(" * 由 tools/embed_web_ui.py 自动生成，请勿手动修改")
+    lines.append(" */")
+    lines.append("")
+    lines.append("#ifndef EMBEDDED_WEB_UI_DATA_H")
+    lines.append("#define EMBEDDED_WEB_UI_DATA_H")
+    lines.append("")
+    lines.append("#define EMBEDDED_WEB_UI_AVAILABLE 1")
+    lines.append("")
+    lines.append("namespace EmbeddedWebUI")
+    lines.append("{")
+
+    for asset in assets:
+        data = asset["data"]
+        lines.append("    // %s: %d -> %d 字节" % (asset["rel"], asset["raw_size"], len(data)))
+        lines.append("    constexpr uint8_t %s[] PROGMEM = {" % asset["symbol"])
+        for i in range(0, len(data), 16):
+            lines.append("        " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+        lines.append("    };")
+        lines.append("")
+
+    routes = routes_for(assets)
+    lines.append("    // 按uri升序排列的路由表")
+    lines.append("    constexpr EmbeddedAsset ROUTES[] = {")
+    for uri, asset in routes:
+        lines.append('        {"%s", "%s", "%s", %s, sizeof(%s), %s},' % (
+            uri, asset["content_type"], asset["etag"], asset["symbol"], asset["symbol"],
+            "true" if asset["gzip"] else "false"))
+    lines.append("    };")
+    lines.append("")
+    lines.append("    constexpr size_t ROUTE_COUNT = sizeof(ROUTES) / sizeof(ROUTES[0]);")
+    lines.append("}")
+    lines.append("")
+    lines.append("#endif // EMBEDDED_WEB_UI_DATA_H")
+    lines.append("")
+
+    content = "\n".join(lines)
+    # 内容不变时不重写，避免触发重新编译
+    if os.path.exists(out_path):
+        with open(out_path, "r", encoding="utf-8") as f:
+            if f.read() == content:
+                return
+    with open(out_path, "w", encoding="utf-8") as f:
+        f.write(content)
+
+
+def generate(data_dir, out_path):
+    assets = collect_assets(data_dir)
+    if not assets:
+        print("未找到Web资源: %s" % data_dir)
+        return 1
+    write_header(assets, out_path)
+    total = sum(len(a["data"]) for a in assets)
+    print("已嵌入 %d 个文件, 共 %d 字节 -> %s" % (len(assets), total, out_path))
+    return 0
+
+
+def main(argv):
+    here = tools_dir()
+    data_dir = argv[0] if len(argv) > 0 else os.path.join(here, "..", "data")
+    out_path = argv[1] if len(argv) > 1 else os.path.join(here, "..", "src", "EmbeddedWebUIData.h")
+    if not os.path.isdir(data_dir):
+        print("目录不存在: %s" % data_dir)
+        return 1
+    return generate(data_dir, out_path)
+
+
+try:
+    # 作为PlatformIO extra_script加载时，编译前生成资源表
+    Import("env")  # noqa: F821
+    _out_dir = os.path.join(env.subst("$BUILD_DIR"), "embedded_web_ui")  # noqa: F821
+    os.makedirs(_out_dir, exist_ok=True)
+    generate(env.subst("$PROJECT_DATA_DIR"), os.path.join(_out_dir, "EmbeddedWebUIData.h"))  # noqa: F821
+
+    # 带引号的#include先搜索当前文件所在目录，再搜索-I目录
+    env.Append(CPPPATH=[_out_dir])  # noqa: F821
+except NameError:
+    if __name__ == "__main__":
+        sys.exit(main(sys.argv[1:]))
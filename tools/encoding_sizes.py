@@ -0,0 +1,214 @@
+#!/usr/bin/env python3
+"""
+encoding_sizes.py
+
+在主机上计算库实际发送的消息以 JSON 和 MessagePack 编码时的大小，
+不需要设备，也不需要安装 ArduinoJson。
+
+序列化规则与 ArduinoJson 6 一致：
+  JSON:        紧凑格式，浮点数按 FloatParts 的规则输出（double，最多9位有效数字）
+  MessagePack: 整数、字符串、映射和数组使用最短的类型，
+               浮点数在 float 范围内时编码为 float32（serializeMsgPack 的行为）
+
+线上大小另加 WebSocket 服务器帧头（不加掩码，载荷 <126 字节时 2 字节，否则 4 字节）。
+
+用法:
+    python3 tools/encoding_sizes.py
+    python3 tools/encoding_sizes.py --markdown
+
+@file encoding_sizes.py
+@author MrQ
+@version 1.0.0
+@date 2026-10-18
+"""
+
+import struct
+import sys
+
+
+class F32(float):
+    """C++ 中为 float 的字段（赋值给 JsonVariant 时转换为 double）"""
+
+    def __new__(cls, value):
+        return float.__new__(cls, struct.unpack('<f', struct.pack('<f', value))[0])
+
+
+def json_float(value):
+    """ArduinoJson 6 TextFormatter::writeFloat（FloatParts<double>）"""
+    if value != value:
+        return 'NaN'
+    if value in (float('inf'), float('-inf')):
+        return 'Infinity' if value > 0 else '-Infinity'
+
+    text = ''
+    if value < 0:
+        text = '-'
+        value = -value
+
+    max_decimal = 1000000000
+    places = 9
+    integral = int(value)
+    tmp = integral
+    while tmp >= 10:
+        max_decimal //= 10
+        places -= 1
+        tmp //= 10
+
+    remainder = (value - integral) * max_decimal
+    decimal = int(remainder)
+    decimal += int((remainder - decimal) * 2)
+    if decimal >= max_decimal:
+        decimal = 0
+        integral += 1
+
+    while places > 0 and decimal % 10 == 0:
+        decimal //= 10
+        places -= 1
+
+    text += str(integral)
+    if places:
+        text += '.' + str(decimal).rjust(places, '0')
+    return text
+
+
+def to_json(value):
+    if value is None:
+        return 'null'
+    if value is True:
+        return 'true'
+    if value is False:
+        return 'false'
+    if isinstance(value, float):
+        return json_float(value)
+    if isinstance(value, int):
+        return str(value)
+    if isinstance(value, str):
+        escaped = value.replace('\\', '\\\\').replace('"', '\\"')
+        return '"' + escaped + '"'
+    if isinstance(value, list):
+        return '[' + ','.join(to_json(v) for v in value) + ']'
+    return '{' + ','.join(to_json(k) + ':' + to_json(v) for k, v in value.items()) + '}'
+
+
+def to_msgpack(value):
+    if value is None:
+        return b'\xc0'
+    if value is True:
+        return b'\xc3'
+    if value is False:
+        return b'\xc2'
+    if isinstance(value, float):
+        if abs(value) <= 3.4028234663852886e38:
+            return b'\xca' + struct.pack('>f', value)
+        return b'\xcb' + struct.pack('>d', value)
+    if isinstance(value, int):
+        if 0 <= value <= 0x7f:
+            return bytes([value])
+        if -32 <= value < 0:
+            return struct.pack('>b', value)
+        if value > 0:
+            for limit, tag, fmt in ((0xff, 0xcc, '>B'), (0xffff, 0xcd, '>H'), (0xffffffff, 0xce, '>I')):
+                if value <= limit:
+                    return bytes([tag]) + struct.pack(fmt, value)
+            return b'\xcf' + struct.pack('>Q', value)
+        for limit, tag, fmt in ((-0x80, 0xd0, '>b'), (-0x8000, 0xd1, '>h'), (-0x80000000, 0xd2, '>i')):
+            if value >= limit:
+                return bytes([tag]) + struct.pack(fmt, value)
+        return b'\xd3' + struct.pack('>q', value)
+    if isinstance(value, str):
+        raw = value.encode('utf-8')
+        if len(raw) <= 31:
+            head = bytes([0xa0 | len(raw)])
+        elif len(raw) <= 0xff:
+            head = bytes([0xd9, len(raw)])
+        else:
+            head = b'\xda' + struct.pack('>H', len(raw))
+        return head + raw
+    if isinstance(value, list):
+        head = bytes([0x90 | len(value)]) if len(value) <= 15 else b'\xdc' + struct.pack('>H', len(value))
+        return head + b''.join(to_msgpack(v) for v in value)
+    head = bytes([0x80 | len(value)]) if len(value) <= 15 else b'\xde' + struct.pack('>H', len(value))
+    return head + b''.join(to_msgpack(k) + to_msgpack(v) for k, v in value.items())
+
+
+def ws_frame(payload_len):
+    """服务器发送的WebSocket帧大小（不加掩码）"""
+    if payload_len < 126:
+        return payload_len + 2
+    if payload_len <= 0xffff:
+        return payload_len + 4
+    return payload_len + 10
+
+
+# 与设备端构建的文档相同的字段和类型，数值取典型值
+PAYLOADS = [
+    # OTAManager::sendUpdateProgress()，OTA期间每100毫秒广播一次
+    ('progress', {
+        'type': 'progress',
+        'progress': F32(42.5),
+        'current': 557056,
+        'total': 1310720,
+        'speed': F32(48213.7),
+        'speedText': '47.1 KB/s',
+    }),
+    # OTAManager计划重启时的通知
+    ('restart', {
+        'type': 'restart',
+        'reason': 'ota',
+        'deadline': 1500,
+    }),
+    # WiFiScanner::writeJson()，8个网络
+    ('wifi_scan', {
+        'type': 'wifi_scan',
+        'networks': [
+            {'ssid': ssid, 'rssi': rssi, 'channel': channel, 'secure': secure}
+            for ssid, rssi, channel, secure in [
+                ('HomeNetwork', -48, 6, True),
+                ('TP-LINK_5A3C', -61, 1, True),
+                ('ChinaNet-8FQe', -67, 11, True),
+                ('Office-Guest', -70, 6, False),
+                ('DIRECT-7B-HP M428 LaserJet', -74, 6, True),
+                ('ESP_3A1F2C', -79, 1, False),
+                ('MERCURY_2.4G_E1', -83, 13, True),
+                ('Xiaomi_1C5D', -88, 4, True),
+            ]
+        ],
+        'age': 1834,
+    }),
+    # PeerOtaMirror的状态（GET /api/ota/mirror）
+    ('peer_ota', {
+        'type': 'peer_ota',
+        'state': 'pulling',
+        'runningMd5': '9e107d9d372bb6826bd81d3542a419d6',
+        'runningSize': 1048576,
+        'md5': 'e4d909c290d0fb1ca068ffaddf22cbd0',
+        'received': 524288,
+        'size': 1048576,
+        'peers': 14,
+        'nextGroup': 0,
+    }),
+]
+
+
+def main(argv):
+    markdown = '--markdown' in argv
+    rows = []
+    for name, doc in PAYLOADS:
+        json_len = len(to_json(doc).encode('utf-8'))
+        msgpack_len = len(to_msgpack(doc))
+        rows.append((name, json_len, msgpack_len, ws_frame(json_len), ws_frame(msgpack_len)))
+
+    if markdown:
+        print('| 消息 | JSON | MessagePack | 线上 JSON | 线上 MessagePack | 节省 |')
+        print('| --- | ---: | ---: | ---: | ---: | ---: |')
+        for name, j, m, wj, wm in rows:
+            print('| `%s` | %d | %d | %d | %d | %.0f%% |' % (name, j, m, wj, wm, 100.0 * (wj - wm) / wj))
+    else:
+        print('%-10s %6s %8s %10s %12s %6s' % ('消息', 'JSON', 'MsgPack', '线上JSON', '线上MsgPack', '节省'))
+        for name, j, m, wj, wm in rows:
+            print('%-10s %6d %8d %10d %12d %5.0f%%' % (name, j, m, wj, wm, 100.0 * (wj - wm) / wj))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""
+fs_sync.py
+
+把本地目录增量同步到设备的LittleFS（FsSync模块）
+
+读取设备的文件清单，只上传内容变化的文件（多个小文件合并到一个请求中）。
+设备上可能有运行时生成的数据（配置、日志等），默认不删除任何文件；
+指定 --delete 时才删除本地不存在的文件（--keep 列出的除外）。
+
+用法:
+    python3 tools/fs_sync.py 192.168.4.1 data
+    python3 tools/fs_sync.py 192.168.4.1 data --delete --keep /config.json --dry-run
+
+@file fs_sync.py
+@author MrQ
+@version 1.0.0
+@date 2026-10-18
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+import time
+import urllib.error
+import urllib.request
+import uuid
+
+
+def local_files(root):
+    """返回 {设备路径: 文件内容}"""
+    files = {}
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for name in sorted(filenames):
+            if name.startswith('.'):
+                continue
+            full = os.path.join(dirpath, name)
+            rel = os.path.relpath(full, root).replace(os.sep, '/')
+            with open(full, 'rb') as f:
+                files['/' + rel] = f.read()
+    return files
+
+
+def fetch_manifest(base_url, timeout):
+    # 设备在主循环中分批计算清单，完成前返回503
+    deadline = time.monotonic() + timeout
+    while True:
+        try:
+            with urllib.request.urlopen(base_url + '/api/fs/manifest', timeout=timeout) as response:
+                manifest = json.load(response)
+            if manifest.get('truncated'):
+                # 看不到的文件会被重复上传，--delete 也会基于不完整的清单做判断
+                sys.exit('设备上的文件数量超过清单上限 (FS_SYNC_MAX_FILES), 无法增量同步')
+            return {entry['path']: entry for entry in manifest['files']}
+        except urllib.error.HTTPError as exc:
+            if exc.code != 503 or time.monotonic() >= deadline:
+                raise
+            time.sleep(float(exc.headers.get('Retry-After', 1)))
+
+
+def encode_multipart(uploads, deletes):
+    boundary = uuid.uuid4().hex
+    parts = []
+
+    def field(name, value):
+        parts.append(f'--{boundary}\r\nContent-Disposition: form-data; name="{name}"\r\n\r\n{value}\r\n'.encode())
+
+    # 期望的MD5必须在对应文件之前发送
+    for path, data in uploads:
+        field('md5:' + path, hashlib.md5(data).hexdigest())
+    for path in deletes:
+        field('delete', path)
+    for path, data in uploads:
+        parts.append(f'--{boundary}\r\nContent-Disposition: form-data; name="file"; filename="{path}"\r\n'
+                     f'Content-Type: application/octet-stream\r\n\r\n'.encode())
+        parts.append(data)
+        parts.append(b'\r\n')
+    parts.append(f'--{boundary}--\r\n'.encode())
+    return boundary, b''.join(parts)
+
+
+def post_batch(base_url, uploads, deletes, timeout):
+    boundary, body = encode_multipart(uploads, deletes)
+    request = urllib.request.Request(base_url + '/api/fs/sync', data=body, method='POST')
+    request.add_header('Content-Type', f'multipart/form-data; boundary={boundary}')
+    with urllib.request.urlopen(request, timeout=timeout) as response:
+        return json.load(response)
+
+
+def make_batches(items, max_bytes, max_files):
+    batch, size = [], 0
+    for path, data in items:
+        if batch and (size + len(data) > max_bytes or len(batch) >= max_files):
+            yield batch
+            batch, size = [], 0
+        batch.append((path, data))
+        size += len(data)
+    if batch:
+        yield batch
+
+
+def main():
+    parser = argparse.ArgumentParser(description='增量同步文件到设备')
+    parser.add_argument('host', help='设备地址')
+    parser.add_argument('directory', help='本地目录（例如 data）')
+    parser.add_argument('--port', type=int, default=80, help='HTTP端口（默认80）')
+    parser.add_argument('--delete', action='store_true', help='删除设备上本地不存在的文件')
+    parser.add_argument('--keep', action='append', default=[], help='使用--delete时需要保留的文件（可多次指定）')
+    parser.add_argument('--batch-bytes', type=int, default=64 * 1024, help='每个请求的最大数据量')
+    parser.add_argument('--batch-files', type=int, default=16, help='每个请求的最大文件数')
+    parser.add_argument('--timeout', type=float, default=30, help='请求超时（秒）')
+    parser.add_argument('--dry-run', action='store_true', help='只显示需要执行的操作')
+    args = parser.parse_args()
+
+    base_url = f'http://{args.host}:{args.port}'
+    files = local_files(args.directory)
+    remote = fetch_manifest(base_url, args.timeout)
+
+    uploads = [(path, data) for path, data in files.items()
+               if path not in remote or remote[path]['md5'] != hashlib.md5(data).hexdigest()]
+    deletes = [] if not args.delete else sorted(
+        path for path in remote if path not in files and path not in args.keep)
+
+    unchanged = len(files) - len(uploads)
+    print(f'{len(uploads)} 个文件需要上传, {len(deletes)} 个需要删除, {unchanged} 个未变化')
+    for path, data in uploads:
+        print(f'  + {path} ({len(data)} bytes)')
+    for path in deletes:
+        print(f'  - {path}')
+
+    if args.dry_run or (not uploads and not deletes):
+        return
+
+    failed = False
+    batches = list(make_batches(uploads, args.batch_bytes, args.batch_files)) or [[]]
+    for i, batch in enumerate(batches):
+        # 删除操作随最后一个请求发送，新文件先写入
+        result = post_batch(base_url, batch, deletes if i == len(batches) - 1 else [], args.timeout)
+        for error in result.get('errors', []):
+            print(f'  错误: {error["path"]}: {error["error"]}', file=sys.stderr)
+            failed = True
+        print(f'请求 {i + 1}/{len(batches)}: 写入 {result["written"]}, 删除 {result["deleted"]}')
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,206 @@
+/**
+ * msgpack_decoder.js
+ *
+ * 浏览器端MessagePack解码器，配合MessageCodec模块使用
+ *
+ * 连接时指定编码（或连接后发送 {"cmd":"set_encoding","encoding":"msgpack"}）:
+ *   const ws = new WebSocket(`ws://${location.hostname}:81/?encoding=msgpack`);
+ *   ws.binaryType = 'arraybuffer';
+ *   ws.onmessage = (event) => {
+ *       const message = decodeMessage(event.data);
+ *       if (message) {
+ *           // 与JSON文本消息相同的对象，例如 {type: 'ota_progress', ...}
+ *       }
+ *       // 否则是二进制日志或WebSocket OTA应答，交给对应的解码器
+ *   };
+ *
+ * HTTP:
+ *   fetch('/api/ota/mirror', {headers: {Accept: 'application/msgpack'}})
+ *       .then((response) => response.arrayBuffer())
+ *       .then((buffer) => console.log(MessagePackDecoder.decode(buffer)));
+ *
+ * @file msgpack_decoder.js
+ * @author MrQ
+ * @version 1.0.0
+ * @date 2026-10-18
+ */
+
+class MessagePackDecoder {
+    /**
+     * 解码一个完整的MessagePack值
+     *
+     * @param {ArrayBuffer|Uint8Array} buffer 数据
+     * @return {*} 解码后的值
+     */
+    static decode(buffer) {
+        const bytes = buffer instanceof Uint8Array ? buffer : new Uint8Array(buffer);
+        const decoder = new MessagePackDecoder(bytes);
+        const value = decoder.read();
+        if (decoder.offset !== bytes.length) {
+            throw new Error('MessagePack: 多余的数据');
+        }
+        return value;
+    }
+
+    /**
+     * 判断二进制帧是否为MessageCodec发送的文档（顶层总是映射）
+     *
+     * 二进制日志以 'L' 开头，WebSocket OTA以 'O' 开头，不会与映射的首字节冲突
+     *
+     * @param {ArrayBuffer|Uint8Array} buffer 数据
+     * @return {boolean}
+     */
+    static isDocument(buffer) {
+        const bytes = buffer instanceof Uint8Array ? buffer : new Uint8Array(buffer);
+        if (bytes.length === 0) {
+            return false;
+        }
+        const first = bytes[0];
+        return (first >= 0x80 && first <= 0x8f) || first === 0xde || first === 0xdf;
+    }
+
+    constructor(bytes) {
+        this.bytes = bytes;
+        this.view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+        this.offset = 0;
+    }
+
+    read() {
+        const type = this.uint(1);
+
+        if (type <= 0x7f) {
+            return type;
+        }
+        if (type >= 0xe0) {
+            return type - 0x100;
+        }
+        if (type >= 0x80 && type <= 0x8f) {
+            return this.map(type & 0x0f);
+        }
+        if (type >= 0x90 && type <= 0x9f) {
+            return this.array(type & 0x0f);
+        }
+        if (type >= 0xa0 && type <= 0xbf) {
+            return this.str(type & 0x1f);
+        }
+
+        switch (type) {
+            case 0xc0: return null;
+            case 0xc2: return false;
+            case 0xc3: return true;
+            case 0xc4: return this.bin(this.uint(1));
+            case 0xc5: return this.bin(this.uint(2));
+            case 0xc6: return this.bin(this.uint(4));
+            case 0xc7: return this.ext(this.uint(1));
+            case 0xc8: return this.ext(this.uint(2));
+            case 0xc9: return this.ext(this.uint(4));
+            case 0xca: return this.float(4);
+            case 0xcb: return this.float(8);
+            case 0xcc: return this.uint(1);
+            case 0xcd: return this.uint(2);
+            case 0xce: return this.uint(4);
+            case 0xcf: return this.uint(8);
+            case 0xd0: return this.int(1);
+            case 0xd1: return this.int(2);
+            case 0xd2: return this.int(4);
+            case 0xd3: return this.int(8);
+            case 0xd4: return this.ext(1);
+            case 0xd5: return this.ext(2);
+            case 0xd6: return this.ext(4);
+            case 0xd7: return this.ext(8);
+            case 0xd8: return this.ext(16);
+            case 0xd9: return this.str(this.uint(1));
+            case 0xda: return this.str(this.uint(2));
+            case 0xdb: return this.str(this.uint(4));
+            case 0xdc: return this.array(this.uint(2));
+            case 0xdd: return this.array(this.uint(4));
+            case 0xde: return this.map(this.uint(2));
+            case 0xdf: return this.map(this.uint(4));
+            default:
+                throw new Error(`MessagePack: 无效的类型 0x${type.toString(16)}`);
+        }
+    }
+
+    need(length) {
+        if (this.offset + length > this.bytes.length) {
+            throw new Error('MessagePack: 数据不完整');
+        }
+        const start = this.offset;
+        this.offset += length;
+        return start;
+    }
+
+    uint(size) {
+        const at = this.need(size);
+        switch (size) {
+            case 1: return this.view.getUint8(at);
+            case 2: return this.view.getUint16(at);
+            case 4: return this.view.getUint32(at);
+            default: return Number(this.view.getBigUint64(at));
+        }
+    }
+
+    int(size) {
+        const at = this.need(size);
+        switch (size) {
+            case 1: return this.view.getInt8(at);
+            case 2: return this.view.getInt16(at);
+            case 4: return this.view.getInt32(at);
+            default: return Number(this.view.getBigInt64(at));
+        }
+    }
+
+    float(size) {
+        const at = this.need(size);
+        return size === 4 ? this.view.getFloat32(at) : this.view.getFloat64(at);
+    }
+
+    str(length) {
+        const at = this.need(length);
+        return new TextDecoder().decode(this.bytes.subarray(at, at + length));
+    }
+
+    bin(length) {
+        const at = this.need(length);
+        return this.bytes.slice(at, at + length);
+    }
+
+    ext(length) {
+        const type = this.int(1);
+        return {type: type, data: this.bin(length)};
+    }
+
+    array(count) {
+        const result = new Array(count);
+        for (let i = 0; i < count; i++) {
+            result[i] = this.read();
+        }
+        return result;
+    }
+
+    map(count) {
+        const result = {};
+        for (let i = 0; i < count; i++) {
+            const key = this.read();
+            result[key] = this.read();
+        }
+        return result;
+    }
+}
+
+/**
+ * 解码WebSocket消息：文本帧按JSON解析，MessagePack二进制帧按MessagePack解码
+ *
+ * @param {string|ArrayBuffer} data 消息数据
+ * @return {Object|null} 消息对象，其他二进制帧（日志、OTA应答）返回null
+ */
+function decodeMessage(data) {
+    if (typeof data === 'string') {
+        return JSON.parse(data);
+    }
+    return MessagePackDecoder.isDocument(data) ? MessagePackDecoder.decode(data) : null;
+}
+
+if (typeof module !== 'undefined') {
+    module.exports = {MessagePackDecoder, decodeMessage};
+}
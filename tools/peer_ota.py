@@ -0,0 +1,288 @@
+#!/usr/bin/env python3
+"""
+peer_ota.py
+
+设备间固件分发（PeerOtaMirror）的启动工具和本机模拟器
+
+start:    让一台已更新的设备作为根节点，把正在运行的固件分发给其他设备
+simulate: 在本机启动多个模拟设备（每个一个HTTP端口，协议与设备端相同），
+          估算分发树的深度和耗时，并与逐台上传比较
+
+          模拟设备是按相同协议重新实现的Python模型，不运行PeerOtaMirror的C++代码，
+          只能说明分组策略的效果，不能作为设备端实现的测试
+
+用法:
+    python3 tools/peer_ota.py start 192.168.1.10 --peers 192.168.1.11,192.168.1.12,192.168.1.13
+    python3 tools/peer_ota.py start 192.168.1.10 --peers-file fleet.txt
+    python3 tools/peer_ota.py simulate --devices 32 --image-kb 1024 --rate-kb 200
+    python3 tools/peer_ota.py simulate --devices 16 --offline 5,9
+
+@file peer_ota.py
+@author MrQ
+@version 1.0.0
+@date 2026-10-18
+"""
+
+import argparse
+import hashlib
+import json
+import os
+import sys
+import threading
+import time
+import urllib.error
+import urllib.parse
+import urllib.request
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+# 与 PeerOtaMirror.h 保持一致
+FANOUT = 2
+MAX_ATTEMPTS = 3
+
+
+def split_groups(peers, fanout):
+    """把设备分成最多fanout组，各组大小相差不超过1（与PeerOtaMirror::getGroup()相同）"""
+    groups = min(len(peers), fanout)
+    if groups == 0:
+        return []
+    base, extra = divmod(len(peers), groups)
+    result, first = [], 0
+    for g in range(groups):
+        count = base + (1 if g < extra else 0)
+        result.append(peers[first:first + count])
+        first += count
+    return result
+
+
+def post_instruction(host, source, md5, size, peers, timeout=5):
+    body = urllib.parse.urlencode({
+        'source': source, 'md5': md5, 'size': str(size), 'peers': ','.join(peers),
+    }).encode()
+    request = urllib.request.Request(f'http://{host}/api/ota/mirror', data=body, method='POST')
+    request.add_header('Content-Type', 'application/x-www-form-urlencoded')
+    with urllib.request.urlopen(request, timeout=timeout) as response:
+        return response.status
+
+
+def start(args):
+    peers = [p.strip() for p in (args.peers or '').split(',') if p.strip()]
+    if args.peers_file:
+        with open(args.peers_file) as f:
+            peers += [line.strip() for line in f if line.strip() and not line.startswith('#')]
+
+    with urllib.request.urlopen(f'http://{args.root}/api/ota/mirror', timeout=args.timeout) as response:
+        status = json.load(response)
+    md5, size = status['runningMd5'], status['runningSize']
+    if status['state'] != 'idle':
+        sys.exit(f'根节点正忙: {status["state"]}')
+    print(f'根节点 {args.root}: 固件 {size} bytes, MD5 {md5}')
+
+    # 根节点已在运行这个固件，只负责转发
+    status = post_instruction(args.root, f'http://{args.root}/api/ota/image', md5, size, peers, args.timeout)
+    print(f'已发送分发指令 (HTTP {status}), {len(peers)} 台设备, 预计深度 {tree_depth(len(peers) + 1, FANOUT)}')
+
+
+def tree_depth(nodes, fanout):
+    depth, covered, width = 0, 1, 1
+    while covered < nodes:
+        width *= fanout
+        covered += width
+        depth += 1
+    return depth
+
+
+class SimDevice:
+    """模拟一台设备：HTTP接口、下载、校验、重启和转发（PeerOtaMirror的Python模型）"""
+
+    def __init__(self, index, port, image, rate, reboot, fanout, offline, log):
+        self.index = index
+        self.host = f'127.0.0.1:{port}'
+        self.image = image
+        self.md5 = hashlib.md5(image).hexdigest()
+        self.rate = rate
+        self.reboot = reboot
+        self.fanout = fanout
+        self.offline = offline
+        self.log = log
+        self.busy = False
+        self.updated_at = None
+        self.depth = None
+        self.upload_lock = threading.Lock()  # 同一台设备的上行带宽被所有下载共享
+        self.server = None
+
+    def start(self):
+        device = self
+
+        class Handler(BaseHTTPRequestHandler):
+            def log_message(self, *args):
+                pass
+
+            def do_GET(self):
+                if self.path == '/api/ota/image':
+                    device.serve_image(self)
+                elif self.path == '/api/ota/mirror':
+                    body = json.dumps({'type': 'peer_ota', 'state': 'fanout' if device.busy else 'idle',
+                                       'runningMd5': device.md5, 'runningSize': len(device.image)}).encode()
+                    self.send_response(200)
+                    self.send_header('Content-Type', 'application/json')
+                    self.send_header('Content-Length', str(len(body)))
+                    self.end_headers()
+                    self.wfile.write(body)
+                else:
+                    self.send_error(404)
+
+            def do_POST(self):
+                if self.path != '/api/ota/mirror':
+                    self.send_error(404)
+                    return
+                length = int(self.headers.get('Content-Length', 0))
+                fields = urllib.parse.parse_qs(self.rfile.read(length).decode())
+                code = device.accept({k: v[0] for k, v in fields.items()})
+                self.send_response(code)
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+
+        if not self.offline:
+            port = int(self.host.split(':')[1])
+            self.server = ThreadingHTTPServer(('127.0.0.1', port), Handler)
+            threading.Thread(target=self.server.serve_forever, daemon=True).start()
+
+    def stop(self):
+        if self.server:
+            self.server.shutdown()
+
+    def serve_image(self, handler):
+        image = self.image
+        handler.send_response(200)
+        handler.send_header('Content-Length', str(len(image)))
+        handler.send_header('X-Image-MD5', hashlib.md5(image).hexdigest())
+        handler.end_headers()
+        chunk = 4096
+        with self.upload_lock:
+            for offset in range(0, len(image), chunk):
+                handler.wfile.write(image[offset:offset + chunk])
+                time.sleep(chunk / self.rate)
+
+    def accept(self, fields):
+        if self.busy:
+            return 409
+        self.busy = True
+        peers = [p for p in fields.get('peers', '').split(',') if p]
+        depth = int(fields.get('depth', '0'))
+        threading.Thread(target=self.run, args=(fields['source'], fields['md5'], int(fields.get('size', 0)), peers, depth),
+                         daemon=True).start()
+        return 202
+
+    def run(self, source, md5, size, peers, depth):
+        own_source = f'http://{self.host}/api/ota/image'
+        if md5 != self.md5:
+            for attempt in range(1, MAX_ATTEMPTS + 1):
+                try:
+                    with urllib.request.urlopen(source, timeout=60) as response:
+                        data = response.read()
+                    if len(data) != size or hashlib.md5(data).hexdigest() != md5:
+                        raise ValueError('verify_failed')
+                    self.image = data
+                    self.md5 = md5
+                    break
+                except Exception as exc:  # noqa: BLE001
+                    self.log(f'设备 {self.index}: 下载失败 ({exc}), 第 {attempt} 次')
+                    time.sleep(0.2)
+            else:
+                # 与设备端相同：自己更新失败时把原来的source转发下去
+                own_source = source
+            if self.md5 == md5:
+                time.sleep(self.reboot)
+                self.updated_at = time.monotonic()
+                self.depth = depth
+                self.log(f'设备 {self.index}: 已更新 (深度 {depth})')
+
+        for group in split_groups(peers, self.fanout):
+            for skip in range(len(group)):
+                child, rest = group[skip], group[skip + 1:]
+                try:
+                    # depth字段只用于模拟器统计，设备端会忽略
+                    body = urllib.parse.urlencode({'source': own_source, 'md5': md5, 'size': str(size),
+                                                   'peers': ','.join(rest), 'depth': str(depth + 1)}).encode()
+                    request = urllib.request.Request(f'http://{child}/api/ota/mirror', data=body, method='POST')
+                    with urllib.request.urlopen(request, timeout=2) as response:
+                        if response.status == 202:
+                            break
+                except (urllib.error.URLError, OSError):
+                    self.log(f'设备 {self.index}: {child} 不可达, 由组内下一台接替')
+        self.busy = False
+
+
+def simulate(args):
+    old_image = os.urandom(args.image_kb * 1024)
+    new_image = os.urandom(args.image_kb * 1024)
+    offline = {int(i) for i in args.offline.split(',') if i} if args.offline else set()
+    rate = args.rate_kb * 1024
+    lock = threading.Lock()
+
+    def log(message):
+        if args.verbose:
+            with lock:
+                print(message)
+
+    devices = []
+    for i in range(args.devices):
+        image = new_image if i == 0 else old_image
+        device = SimDevice(i, args.base_port + i, image, rate, args.reboot, args.fanout, i in offline, log)
+        device.start()
+        devices.append(device)
+
+    root = devices[0]
+    root.updated_at = time.monotonic()
+    root.depth = 0
+    started = time.monotonic()
+    root.accept({'source': f'http://{root.host}/api/ota/image', 'md5': root.md5, 'size': str(len(new_image)),
+                 'peers': ','.join(d.host for d in devices[1:])})
+
+    online = [d for d in devices if not d.offline]
+    deadline = started + args.timeout
+    while time.monotonic() < deadline and any(d.md5 != root.md5 for d in online):
+        time.sleep(0.1)
+    elapsed = time.monotonic() - started
+
+    for device in devices:
+        device.stop()
+
+    updated = [d for d in online if d.md5 == root.md5]
+    max_depth = max(d.depth for d in updated)
+    serial = (args.devices - 1) * len(new_image) / rate + (args.devices - 1) * args.reboot
+    print(f'{len(updated)}/{len(online)} 台在线设备已更新, 离线 {len(offline)} 台')
+    print(f'耗时 {elapsed:.1f}s, 最大深度 {max_depth} (理论 {tree_depth(args.devices, args.fanout)})')
+    print(f'逐台上传估计耗时 {serial:.1f}s')
+    sys.exit(0 if len(updated) == len(online) else 1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='设备间固件分发')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('start', help='从一台已更新的设备开始分发')
+    p.add_argument('root', help='根节点设备 "主机[:端口]"')
+    p.add_argument('--peers', help='逗号分隔的设备列表')
+    p.add_argument('--peers-file', help='设备列表文件，每行一个')
+    p.add_argument('--timeout', type=float, default=30, help='请求超时（秒）')
+    p.set_defaults(func=start)
+
+    p = sub.add_parser('simulate', help='在本机模拟分发过程')
+    p.add_argument('--devices', type=int, default=16, help='设备数量（含根节点）')
+    p.add_argument('--image-kb', type=int, default=256, help='固件大小（KB）')
+    p.add_argument('--rate-kb', type=int, default=512, help='每台设备的上行速率（KB/s）')
+    p.add_argument('--reboot', type=float, default=0.5, help='模拟重启耗时（秒）')
+    p.add_argument('--fanout', type=int, default=FANOUT, help='每台设备转发的分支数')
+    p.add_argument('--offline', help='离线设备的序号，逗号分隔')
+    p.add_argument('--base-port', type=int, default=18000, help='第一个模拟设备的端口')
+    p.add_argument('--timeout', type=float, default=300, help='最长等待时间（秒）')
+    p.add_argument('-v', '--verbose', action='store_true', help='显示每台设备的事件')
+    p.set_defaults(func=simulate)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
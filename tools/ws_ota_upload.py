@@ -0,0 +1,298 @@
+#!/usr/bin/env python3
+"""
+ws_ota_upload.py
+
+通过WebSocket二进制帧上传固件或文件系统镜像（WsOtaReceiver协议）
+
+发送端保持最多一个窗口的块在途，收到累计确认后继续发送；
+连接断开时自动重连并从设备确认的位置续传。
+
+用法:
+    python3 tools/ws_ota_upload.py 192.168.4.1 .pio/build/esp32/firmware.bin
+    python3 tools/ws_ota_upload.py 192.168.4.1 littlefs.bin --filesystem --port 81
+
+本机回环测试（主机名写 loopback）:
+    python3 tools/ws_ota_upload.py loopback firmware.bin --rtt 20 --write-rate 120
+
+回环模式在 127.0.0.1 上启动一个按 WsOtaReceiver 协议应答的接收端（Python 模型，
+确认时机、乱序处理和续传条件与设备端相同），可以模拟往返延迟和闪存写入速度，
+用于比较不同块大小和窗口下的吞吐量；它不运行设备端的 C++ 代码。
+
+依赖: pip install websockets
+
+@file ws_ota_upload.py
+@author MrQ
+@version 1.0.0
+@date 2026-10-18
+"""
+
+import argparse
+import asyncio
+import hashlib
+import struct
+import sys
+import time
+
+import websockets
+
+MAGIC = ord('O')
+OP_BEGIN = 0x01
+OP_DATA = 0x02
+OP_END = 0x03
+OP_ABORT = 0x04
+OP_ACK = 0x80
+FLAG_RESUME = 0x01
+
+STATUS_OK = 0
+STATUS_DONE = 1
+STATUS_BAD_REQUEST = 3
+STATUS_VERIFY_FAILED = 5
+STATUS_NO_SESSION = 6
+STATUS_NAMES = {
+    2: '设备忙（其他上传正在进行）',
+    3: '请求无效',
+    4: '闪存写入失败',
+    5: '镜像校验失败',
+    6: '没有进行中的会话',
+}
+
+ACK_FORMAT = '<BBBBIIIHH'
+ACK_TIMEOUT = 10
+
+
+def frame(op, seq=0, payload=b''):
+    return struct.pack('<BBHI', MAGIC, op, 0, seq) + payload
+
+
+class Uploader:
+    def __init__(self, url, image, update_type, chunk_size, window):
+        self.url = url
+        self.image = image
+        self.update_type = update_type
+        self.chunk_size = chunk_size
+        self.window = window
+        self.md5 = hashlib.md5(image).hexdigest().encode()
+        self.next_seq = 0
+        self.started = False
+        self.start_time = None
+
+    @property
+    def chunk_count(self):
+        return (len(self.image) + self.chunk_size - 1) // self.chunk_size
+
+    async def run(self, retries):
+        for attempt in range(retries + 1):
+            try:
+                async with websockets.connect(self.url, max_size=None, ping_interval=None) as ws:
+                    if await self.session(ws):
+                        return True
+                    return False
+            except (OSError, asyncio.TimeoutError, websockets.ConnectionClosed) as exc:
+                if attempt == retries:
+                    print(f'\n连接失败: {exc}', file=sys.stderr)
+                    return False
+                print(f'\n连接断开 ({exc})，1秒后续传...', file=sys.stderr)
+                await asyncio.sleep(1)
+        return False
+
+    async def recv_ack(self, ws):
+        while True:
+            message = await ws.recv()
+            if isinstance(message, bytes) and len(message) >= 20 and message[0] == MAGIC and message[1] == OP_ACK:
+                _, _, status, window, next_seq, written, total, chunk, _ = struct.unpack(ACK_FORMAT, message[:20])
+                return status, window, next_seq, written, total, chunk
+            # 其他消息（日志、进度JSON等）忽略
+
+    async def session(self, ws):
+        flags = FLAG_RESUME if self.started else 0
+        begin = struct.pack('<IBBH', len(self.image), self.update_type, flags, self.chunk_size) + self.md5
+        await ws.send(frame(OP_BEGIN, 0, begin))
+
+        status, window, next_seq, _, _, chunk = await asyncio.wait_for(self.recv_ack(ws), ACK_TIMEOUT)
+        if status != STATUS_OK:
+            print(f'设备拒绝上传: {STATUS_NAMES.get(status, status)}', file=sys.stderr)
+            return False
+
+        # 设备可能限制块大小和窗口
+        if chunk and chunk != self.chunk_size:
+            if self.started:
+                print('续传时块大小不一致', file=sys.stderr)
+                return False
+            self.chunk_size = chunk
+        self.window = min(self.window, window) if window else self.window
+        self.next_seq = next_seq if self.started else 0
+        if not self.started:
+            self.started = True
+            self.start_time = time.monotonic()
+
+        acked = self.next_seq
+        sent = self.next_seq
+        while acked < self.chunk_count:
+            # 窗口内尽量多发
+            while sent < self.chunk_count and sent - acked < self.window:
+                offset = sent * self.chunk_size
+                await ws.send(frame(OP_DATA, sent, self.image[offset:offset + self.chunk_size]))
+                sent += 1
+
+            status, _, next_seq, written, total, _ = await asyncio.wait_for(self.recv_ack(ws), ACK_TIMEOUT)
+            if status != STATUS_OK:
+                print(f'\n上传失败: {STATUS_NAMES.get(status, status)}', file=sys.stderr)
+                return False
+
+            if next_seq == acked and next_seq < sent:
+                # 没有前进的确认表示设备丢弃了乱序的块，从确认位置重发
+                sent = next_seq
+            acked = next_seq
+            self.next_seq = next_seq
+            self.report(written, total)
+
+        await ws.send(frame(OP_END))
+        status, _, _, written, total, _ = await asyncio.wait_for(self.recv_ack(ws), ACK_TIMEOUT)
+        self.report(written, total)
+        print()
+        if status != STATUS_DONE:
+            print(f'完成失败: {STATUS_NAMES.get(status, status)}', file=sys.stderr)
+            return False
+
+        elapsed = time.monotonic() - self.start_time
+        print(f'上传完成: {len(self.image)} bytes, {elapsed:.1f} s, '
+              f'{len(self.image) / 1024 / max(elapsed, 1e-6):.1f} KB/s，设备将重启')
+        return True
+
+    def report(self, written, total):
+        elapsed = max(time.monotonic() - self.start_time, 1e-6)
+        percent = written * 100.0 / total if total else 0
+        print(f'\r{percent:5.1f}%  {written}/{total} bytes  {written / 1024 / elapsed:.1f} KB/s', end='', flush=True)
+
+
+class LoopbackReceiver:
+    """WsOtaReceiver的Python模型：每半个窗口累计确认，乱序时确认一次后丢弃"""
+
+    WINDOW = 8
+    MAX_CHUNK = 4096
+    BEGIN_SIZE = 8
+
+    def __init__(self):
+        self.active = False
+        self.total = 0
+        self.update_type = 0
+        self.chunk = 0
+        self.md5 = b''
+        self.next_seq = 0
+        self.written = 0
+        self.unacked = 0
+        self.gap_acked = False
+        self.hash = None
+
+    def ack(self, status):
+        return struct.pack(ACK_FORMAT, MAGIC, OP_ACK, status, self.WINDOW,
+                           self.next_seq, self.written, self.total, self.chunk, 0)
+
+    def on_message(self, message):
+        """处理一帧，返回需要发送的确认（可能为空）"""
+        if len(message) < 8 or message[0] != MAGIC:
+            return []
+        op, seq, data = message[1], struct.unpack('<I', message[4:8])[0], message[8:]
+
+        if op == OP_BEGIN:
+            if len(data) < self.BEGIN_SIZE:
+                return [self.ack(STATUS_BAD_REQUEST)]
+            total, update_type, flags, chunk = struct.unpack('<IBBH', data[:self.BEGIN_SIZE])
+            chunk = min(chunk, self.MAX_CHUNK)
+            md5 = data[self.BEGIN_SIZE:self.BEGIN_SIZE + 32].lower()
+            if (self.active and flags & FLAG_RESUME and total == self.total and update_type == self.update_type
+                    and chunk == self.chunk and md5 == self.md5):
+                self.unacked = 0
+                return [self.ack(STATUS_OK)]
+            if not total or not chunk:
+                return [self.ack(STATUS_BAD_REQUEST)]
+            self.__init__()
+            self.active, self.total, self.update_type, self.chunk, self.md5 = True, total, update_type, chunk, md5
+            self.hash = hashlib.md5()
+            return [self.ack(STATUS_OK)]
+
+        if not self.active:
+            return [self.ack(STATUS_NO_SESSION)]
+
+        if op == OP_DATA:
+            if seq != self.next_seq:
+                if seq < self.next_seq or not self.gap_acked:
+                    self.gap_acked = seq > self.next_seq
+                    self.unacked = 0
+                    return [self.ack(STATUS_OK)]
+                return []
+            last = self.written + len(data) == self.total
+            if (len(data) != self.chunk and not last) or self.written + len(data) > self.total:
+                self.active = False
+                return [self.ack(STATUS_BAD_REQUEST)]
+            self.hash.update(data)
+            self.written += len(data)
+            self.next_seq += 1
+            self.gap_acked = False
+            self.unacked += 1
+            if self.unacked >= self.WINDOW // 2 or last:
+                self.unacked = 0
+                return [self.ack(STATUS_OK)]
+            return []
+
+        if op == OP_END:
+            if self.written != self.total:
+                return [self.ack(STATUS_OK)]
+            verified = not self.md5 or self.hash.hexdigest().encode() == self.md5
+            self.active = False
+            return [self.ack(STATUS_DONE if verified else STATUS_VERIFY_FAILED)]
+
+        if op == OP_ABORT:
+            self.active = False
+            return [self.ack(STATUS_OK)]
+
+        return [self.ack(STATUS_BAD_REQUEST)]
+
+
+async def run_loopback(uploader, retries, rtt, write_rate):
+    """在127.0.0.1上运行接收端模型并上传，rtt为往返延迟（秒），write_rate为闪存写入速度（字节/秒）"""
+    receiver = LoopbackReceiver()
+    loop = asyncio.get_running_loop()
+
+    async def handler(ws, *_):
+        async for message in ws:
+            if write_rate and len(message) > 8 and message[1] == OP_DATA:
+                # 设备在主循环中同步写入闪存，写入期间不处理后续的帧
+                await asyncio.sleep((len(message) - 8) / write_rate)
+            for ack in receiver.on_message(message):
+                # 确认经过一个往返延迟到达发送端
+                loop.call_later(rtt, lambda data=ack: asyncio.ensure_future(ws.send(data)))
+
+    async with websockets.serve(handler, '127.0.0.1', 0, max_size=None, ping_interval=None) as server:
+        port = server.sockets[0].getsockname()[1]
+        uploader.url = f'ws://127.0.0.1:{port}/'
+        return await uploader.run(retries)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='通过WebSocket上传OTA镜像')
+    parser.add_argument('host', help='设备地址, loopback表示本机回环测试')
+    parser.add_argument('image', help='固件或文件系统镜像')
+    parser.add_argument('--port', type=int, default=81, help='WebSocket端口（默认81）')
+    parser.add_argument('--filesystem', action='store_true', help='上传文件系统镜像')
+    parser.add_argument('--chunk', type=int, default=4096, help='块大小（默认4096）')
+    parser.add_argument('--window', type=int, default=8, help='在途块数（默认8）')
+    parser.add_argument('--retries', type=int, default=5, help='断线重连次数（默认5）')
+    parser.add_argument('--rtt', type=float, default=0, help='回环测试: 模拟的往返延迟（毫秒）')
+    parser.add_argument('--write-rate', type=float, default=0, help='回环测试: 模拟的闪存写入速度（KB/s, 0为不限）')
+    args = parser.parse_args()
+
+    with open(args.image, 'rb') as f:
+        image = f.read()
+
+    uploader = Uploader(f'ws://{args.host}:{args.port}/', image,
+                        2 if args.filesystem else 1, args.chunk, args.window)
+    if args.host == 'loopback':
+        ok = asyncio.run(run_loopback(uploader, args.retries, args.rtt / 1000, args.write_rate * 1024))
+    else:
+        ok = asyncio.run(uploader.run(args.retries))
+    sys.exit(0 if ok else 1)
+
+
+if __name__ == '__main__':
+    main()